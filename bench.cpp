@@ -0,0 +1,874 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Per-thread counters, padded to avoid false sharing (64-byte cache lines).
+// Per-thread arrays are grown in BenchStart while no run is active (g_poolLock
+// held, every pool thread parked), never shrunk.
+struct alignas(64) PaddedCounter { std::atomic<int64_t> ops; };
+static std::unique_ptr<PaddedCounter[]> g_threadOps;
+static std::vector<BenchThreadResult> g_threadResults;
+static int g_threadCapacity = 0;
+
+// Progress samples: slot k holds the first (stamp, cumulative ops) seen after
+// release + k * sampleInterval. Written by the owning worker only and published
+// through `count`, so the coordinator never reads a torn pair.
+struct BenchSample { int64_t tNs; int64_t ops; };
+struct alignas(64) BenchSampleLog {
+    std::vector<BenchSample> slots;
+    std::atomic<int> count;
+};
+static std::unique_ptr<BenchSampleLog[]> g_samples;
+
+// Run state. Written by the caller in BenchStart before the run is published;
+// during a run the control thread and workers talk only through the atomics.
+// g_go / g_released are release-stored after the deadlines so an acquire load
+// makes the deadlines visible; g_cancel and g_stopNs are polled relaxed once
+// per chunk, which only delays (never reorders) their effect.
+static BenchConfig g_cfg;
+static BenchResult g_result;
+static std::atomic<int> g_arrived(0);
+static std::atomic<bool> g_go(false);
+static std::atomic<bool> g_cancel(false);
+static std::atomic<const char*> g_runError(NULL);  // set by BenchFailRun
+static std::atomic<bool> g_done(false);
+static std::atomic<bool> g_released(false);
+static std::atomic<int64_t> g_releaseNs(0);
+static std::atomic<int64_t> g_warmupEndNs(0);
+static std::atomic<int64_t> g_stopNs(0);      // adaptive runs pull this in early
+static std::atomic<int> g_finished(0);
+static std::mutex g_finishLock;               // last worker out wakes the control thread
+static std::condition_variable g_finishCv;
+static std::mutex g_statsLock;
+static BenchRateStats g_liveStats = {};
+static bool g_converged = false;
+static bool g_active = false;                 // caller side only
+
+// A run is a sequence of phases, one placement each, executed back to back on
+// the pool. Plain runs have one phase; SMT modes measure one thread per core,
+// then one per logical processor. The control thread publishes each phase
+// like a run (under g_poolLock), so workers see g_placement / g_runThreads
+// through the lock.
+static std::vector<std::vector<BenchPlacement>> g_phases;
+static std::vector<BenchPlacement> g_placement;   // current phase
+static std::atomic<int> g_runThreads(0);          // workers in the current phase
+static std::atomic<int> g_phaseIndex(0);
+static std::vector<BenchResult> g_phaseResults;
+static int g_sampleSlots = 0;
+static bool g_simulated = false;                  // planned on a simulated layout, nothing applied
+static BenchKernelRunFn g_kernelRun = BenchCpuKernel;  // the run's registry kernel
+static double g_opsPerIter = 1.0;
+
+// Persistent pool: one control thread plus workers, created lazily and parked
+// on g_poolWake between runs. A run is published by bumping g_runGeneration;
+// g_participants counts threads still inside it. All guarded by g_poolLock.
+static std::mutex g_poolLock;
+static std::condition_variable g_poolWake;
+static std::condition_variable g_poolIdle;
+static std::thread g_controlThread;
+static std::vector<std::thread> g_poolWorkers;
+static uint64_t g_runGeneration = 0;
+static int g_participants = 0;
+static bool g_poolShutdown = false;
+static BenchCancelStats g_cancelStats = {};
+
+int64_t BenchNowNs() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int BenchRunThreads() {
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    return n > 0 ? n : 1;
+}
+
+// Set by each worker as it starts a phase
+static thread_local int t_workerIndex = 0;
+
+int BenchRunWorker() {
+    return t_workerIndex;
+}
+
+double BenchCpuKernel(double seed, int64_t iters) {
+    volatile double x = seed;
+    for (int64_t i = 0; i < iters; i++) {
+        x = sin(x) * cos(x) + sqrt(x + 1.0);
+    }
+    return x;
+}
+
+// Two-sided 95 % Student t quantile
+static double StudentT975(int df) {
+    static const double table[31] = {
+        0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) return 0.0;
+    if (df <= 30) return table[df];
+    return 1.96 + 2.4 / df;
+}
+
+BenchRateStats BenchComputeRateStats(const double* rates, int count) {
+    BenchRateStats st = {};
+    st.batches = count;
+    if (count < 1) return st;
+    for (int i = 0; i < count; i++) st.mean += rates[i];
+    st.mean /= count;
+    if (count < 2 || st.mean <= 0.0) return st;
+    double var = 0.0;
+    for (int i = 0; i < count; i++) var += (rates[i] - st.mean) * (rates[i] - st.mean);
+    double sd = sqrt(var / (count - 1));
+    st.halfWidth = StudentT975(count - 1) * sd / sqrt((double)count);
+    st.precision = st.halfWidth / st.mean;
+    return st;
+}
+
+BenchThrottleSummary BenchAnalyzeThrottling(const double* rates, int count, int warmupSamples) {
+    BenchThrottleSummary t = {};
+    t.onsetSample = -1;
+    // Warm-up samples can't set the peak; the first interval includes thread
+    // start-up, so it goes even without a warm-up
+    int skip = warmupSamples < 1 ? 1 : warmupSamples;
+    if (count - skip < 1) return t;
+    rates += skip;
+    count -= skip;
+
+    // Rolling mean so a single slow interval is not read as a peak or a drop
+    std::vector<double> smooth(count);
+    int half = BENCH_SMOOTH_SAMPLES / 2;
+    int peakIdx = 0;
+    for (int i = 0; i < count; i++) {
+        int lo = i - half < 0 ? 0 : i - half;
+        int hi = i + half >= count ? count - 1 : i + half;
+        double sum = 0.0;
+        for (int j = lo; j <= hi; j++) sum += rates[j];
+        smooth[i] = sum / (hi - lo + 1);
+        if (smooth[i] > smooth[peakIdx]) peakIdx = i;
+    }
+    t.peak = smooth[peakIdx];
+
+    // Same smoothed series as the peak, so sustained can't read above it
+    int tailStart = count - count / 3;
+    if (tailStart >= count) tailStart = count - 1;
+    double sum = 0.0;
+    for (int i = tailStart; i < count; i++) sum += smooth[i];
+    t.sustained = sum / (count - tailStart);
+    t.dropPct = t.peak > 0.0 ? (t.peak - t.sustained) / t.peak * 100.0 : 0.0;
+    if (t.dropPct < 0.0) t.dropPct = 0.0;
+    t.throttled = t.dropPct >= BENCH_THROTTLE_DROP_PCT;
+
+    double threshold = t.peak * (1.0 - BENCH_THROTTLE_DROP_PCT / 100.0);
+    for (int i = peakIdx; i < count; i++) {
+        if (smooth[i] < threshold) {
+            t.onsetSample = i + skip;  // index into the caller's series
+            break;
+        }
+    }
+    return t;
+}
+
+// Median of a copy, upper middle for even counts
+static double Median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+BenchThreadSpread BenchAnalyzeSpread(const std::vector<BenchThreadResult>& threads, bool byClass) {
+    BenchThreadSpread sp = {};
+    int n = (int)threads.size();
+    if (n < 1) return sp;
+    std::vector<double> rates;
+    double mean = 0.0;
+    for (const BenchThreadResult& t : threads) {
+        rates.push_back(t.opsPerSec);
+        mean += t.opsPerSec;
+    }
+    mean /= n;
+    sp.min = *std::min_element(rates.begin(), rates.end());
+    sp.max = *std::max_element(rates.begin(), rates.end());
+    sp.median = Median(rates);
+    double var = 0.0;
+    for (double r : rates) var += (r - mean) * (r - mean);
+    if (n > 1 && mean > 0.0) sp.cv = sqrt(var / (n - 1)) / mean;
+
+    for (int i = 0; i < n; i++) {
+        double peer = sp.median;
+        if (byClass) {
+            std::vector<double> same;
+            for (const BenchThreadResult& t : threads) {
+                if (t.placement.efficiencyClass == threads[i].placement.efficiencyClass) same.push_back(t.opsPerSec);
+            }
+            peer = Median(same);
+        }
+        if (peer <= 0.0) continue;
+        double deficit = (1.0 - threads[i].opsPerSec / peer) * 100.0;
+        if (deficit >= BENCH_STRAGGLER_PCT) sp.stragglers.push_back(BenchStraggler{ i, deficit });
+    }
+    std::sort(sp.stragglers.begin(), sp.stragglers.end(),
+        [](const BenchStraggler& a, const BenchStraggler& b) { return a.deficitPct > b.deficitPct; });
+    return sp;
+}
+
+std::vector<int> BenchScalingSteps(int mode, int maxThreads) {
+    std::vector<int> steps;
+    if (maxThreads < 1) maxThreads = 1;
+    if (mode == BENCH_SCALING_EVERY) {
+        for (int n = 1; n <= maxThreads; n++) steps.push_back(n);
+        return steps;
+    }
+    for (int n = 1; n < maxThreads; n *= 2) steps.push_back(n);
+    steps.push_back(maxThreads);
+    return steps;
+}
+
+BenchScalingReport BenchAnalyzeScaling(const int* threads, const double* scores, int count) {
+    BenchScalingReport rep;
+    if (count < 1 || scores[0] <= 0.0) return rep;
+    double base = scores[0] / threads[0];
+    for (int i = 0; i < count; i++) {
+        BenchScalingPoint pt = {};
+        pt.threads = threads[i];
+        pt.score = scores[i];
+        pt.speedup = scores[i] / base;
+        pt.efficiency = pt.speedup / threads[i];
+        rep.points.push_back(pt);
+    }
+    BenchScalingFit& fit = rep.fit;
+
+    // Amdahl: 1/S - 1/n = s (1 - 1/n), a line through the origin
+    double sxy = 0.0, sxx = 0.0;
+    for (const BenchScalingPoint& pt : rep.points) {
+        if (pt.threads < 2 || pt.speedup <= 0.0) continue;
+        double x = 1.0 - 1.0 / pt.threads;
+        sxy += (1.0 / pt.speedup - 1.0 / pt.threads) * x;
+        sxx += x * x;
+    }
+    if (sxx > 0.0) fit.serialFraction = std::min(1.0, std::max(0.0, sxy / sxx));
+
+    // USL: n/S - 1 = sigma (n - 1) + kappa n (n - 1), two regressors, no
+    // intercept; fall back to kappa = 0 (Amdahl's form) if kappa comes out negative
+    double a11 = 0.0, a12 = 0.0, a22 = 0.0, b1 = 0.0, b2 = 0.0;
+    for (const BenchScalingPoint& pt : rep.points) {
+        if (pt.threads < 2 || pt.speedup <= 0.0) continue;
+        double n = pt.threads;
+        double y = n / pt.speedup - 1.0, x1 = n - 1.0, x2 = n * (n - 1.0);
+        a11 += x1 * x1; a12 += x1 * x2; a22 += x2 * x2;
+        b1 += x1 * y; b2 += x2 * y;
+    }
+    double det = a11 * a22 - a12 * a12;
+    if (det > 1e-12 * a11 * a22) {
+        fit.sigma = (b1 * a22 - b2 * a12) / det;
+        fit.kappa = (a11 * b2 - a12 * b1) / det;
+    }
+    if (fit.kappa <= 0.0 && a11 > 0.0) {
+        fit.kappa = 0.0;
+        fit.sigma = b1 / a11;
+    }
+    if (fit.sigma < 0.0) fit.sigma = 0.0;
+    if (fit.kappa > 0.0) fit.peakThreads = sqrt((1.0 - std::min(fit.sigma, 1.0)) / fit.kappa);
+
+    // Knee: the last count before a step whose added threads each return less
+    // than BENCH_KNEE_MARGINAL of the single-thread rate
+    fit.kneeThreads = rep.points.back().threads;
+    for (int i = 1; i < count; i++) {
+        int added = rep.points[i].threads - rep.points[i - 1].threads;
+        if (added < 1) continue;
+        double marginal = (rep.points[i].score - rep.points[i - 1].score) / added / base;
+        if (marginal < BENCH_KNEE_MARGINAL) {
+            fit.kneeThreads = rep.points[i - 1].threads;
+            break;
+        }
+    }
+    return rep;
+}
+
+// Record progress into every sample slot whose boundary has passed
+static void RecordSamples(int idx, int64_t sinceRelease, int64_t ops, int* nextSlot) {
+    BenchSampleLog& log = g_samples[idx];
+    int64_t interval = (int64_t)g_cfg.sampleIntervalMs * 1000000;
+    int last = (int)(sinceRelease / interval);
+    int cap = (int)log.slots.size();
+    int slot = *nextSlot;
+    while (slot <= last && slot < cap) {
+        log.slots[slot].tNs = sinceRelease;
+        log.slots[slot].ops = ops;
+        slot++;
+    }
+    if (slot != *nextSlot) log.count.store(slot, std::memory_order_release);
+    *nextSlot = slot;
+}
+
+// Worker: wait at the barrier, warm up, then measure its own window. Chunks are
+// resized so each takes about BENCH_CHUNK_TARGET_US, which bounds cancel latency.
+static void BenchWorkerLoop(int idx) {
+    double x = 1.0 + idx;
+    t_workerIndex = idx;
+    if (!g_simulated) BenchApplyPlacement(g_placement[idx], g_cfg.pinThreads);
+    g_arrived.fetch_add(1, std::memory_order_acq_rel);
+    while (!g_go.load(std::memory_order_acquire)) {
+        if (g_cancel.load(std::memory_order_relaxed)) return;
+        std::this_thread::yield();
+    }
+    const int64_t release = g_releaseNs.load(std::memory_order_relaxed);
+    const int64_t warmupEnd = g_warmupEndNs.load(std::memory_order_relaxed);
+    const int64_t interval = (int64_t)g_cfg.sampleIntervalMs * 1000000;
+
+    const int64_t chunkTargetNs = (int64_t)BENCH_CHUNK_TARGET_US * 1000;
+    int64_t chunk = BENCH_CHUNK_MIN_OPS;
+    int64_t ops = 0, startOps = 0, startNs = 0;
+    int64_t now = BenchNowNs();
+    int nextSlot = 0;
+    int64_t nextSampleAt = release;
+    bool measuring = now >= warmupEnd;
+    if (measuring) startNs = now;
+    while (true) {
+        if (now >= nextSampleAt) {
+            RecordSamples(idx, now - release, ops, &nextSlot);
+            nextSampleAt = release + (int64_t)nextSlot * interval;
+        }
+        x = g_kernelRun(x, chunk);
+        ops += chunk;
+        g_threadOps[idx].ops.store(ops, std::memory_order_relaxed);
+        if (g_cancel.load(std::memory_order_relaxed)) return;
+        int64_t prev = now;
+        now = BenchNowNs();
+        if (now - prev < chunkTargetNs / 2 && chunk < BENCH_CHUNK_MAX_OPS) chunk *= 2;
+        else if (now - prev > chunkTargetNs * 2 && chunk > BENCH_CHUNK_MIN_OPS) chunk /= 2;
+        if (idx == g_cfg.slowThread && g_cfg.slowPct > 0) {
+            // Idle so the busy share of the chunk is (100 - slowPct) %
+            std::this_thread::sleep_for(std::chrono::nanoseconds((now - prev) * g_cfg.slowPct / (100 - g_cfg.slowPct)));
+            now = BenchNowNs();
+        }
+        if (!measuring) {
+            if (now >= warmupEnd) {
+                measuring = true;
+                startNs = now;
+                startOps = ops;
+            }
+        } else if (now >= g_stopNs.load(std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    RecordSamples(idx, now - release, ops, &nextSlot);
+
+    BenchThreadResult& r = g_threadResults[idx];
+    r.ops = ops - startOps;
+    r.startNs = startNs - release;
+    r.stopNs = now - release;
+    r.opsPerSec = (now > startNs) ? (double)r.ops * 1e9 / (double)(now - startNs) : 0.0;
+    r.placement = g_placement[idx];
+}
+
+static void BenchWorker(int idx) {
+    BenchWorkerLoop(idx);
+    if (g_finished.fetch_add(1, std::memory_order_acq_rel) + 1 == g_runThreads.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(g_finishLock);
+        g_finishCv.notify_all();
+    }
+}
+
+// Batch rates over the measurement phase, from the samples all workers have published
+static BenchRateStats CollectRateStats() {
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    int64_t interval = (int64_t)g_cfg.sampleIntervalMs * 1000000;
+    int64_t warmupNs = (int64_t)g_cfg.warmupMs * 1000000;
+    int first = (int)((warmupNs + interval - 1) / interval);
+    int available = -1;
+    for (int i = 0; i < n; i++) {
+        int c = g_samples[i].count.load(std::memory_order_acquire);
+        if (available < 0 || c < available) available = c;
+    }
+    std::vector<double> rates;
+    for (int b = first; b + BENCH_BATCH_INTERVALS < available; b += BENCH_BATCH_INTERVALS) {
+        int e = b + BENCH_BATCH_INTERVALS;
+        double rate = 0.0;
+        for (int i = 0; i < n; i++) {
+            const BenchSample& s0 = g_samples[i].slots[b];
+            const BenchSample& s1 = g_samples[i].slots[e];
+            if (s1.tNs > s0.tNs) rate += (double)(s1.ops - s0.ops) * 1e9 / (double)(s1.tNs - s0.tNs);
+        }
+        rates.push_back(rate);
+    }
+    return BenchComputeRateStats(rates.data(), (int)rates.size());
+}
+
+// Convert every worker's sample slots into per-interval rates
+static void BuildTimeSeries(BenchTimeSeries* ts) {
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    ts->intervalMs = g_cfg.sampleIntervalMs;
+    int64_t interval = (int64_t)g_cfg.sampleIntervalMs * 1000000;
+    ts->warmupSamples = (int)(((int64_t)g_cfg.warmupMs * 1000000 + interval - 1) / interval);
+    int available = -1;
+    for (int i = 0; i < n; i++) {
+        int c = g_samples[i].count.load(std::memory_order_acquire);
+        if (available < 0 || c < available) available = c;
+    }
+    int count = available > 1 ? available - 1 : 0;
+    ts->total.assign(count, 0.0);
+    ts->perThread.assign(n, std::vector<double>(count, 0.0));
+    for (int i = 0; i < n; i++) {
+        const std::vector<BenchSample>& slots = g_samples[i].slots;
+        for (int k = 0; k < count; k++) {
+            // A worker that missed boundaries fills several slots from one check;
+            // spread the rate of the next real span over those intervals
+            int e = k + 1;
+            while (e < count && slots[e].tNs == slots[k].tNs) e++;
+            int64_t dt = slots[e].tNs - slots[k].tNs;
+            double rate = dt > 0 ? (double)(slots[e].ops - slots[k].ops) * 1e9 / (double)dt : 0.0;
+            ts->perThread[i][k] = rate;
+            ts->total[k] += rate;
+        }
+    }
+}
+
+std::vector<BenchClassScore> BenchClassScores(const std::vector<BenchThreadResult>& threads) {
+    std::vector<BenchClassScore> classes;
+    for (const BenchThreadResult& t : threads) {
+        size_t c = 0;
+        while (c < classes.size() && classes[c].efficiencyClass != t.placement.efficiencyClass) c++;
+        if (c == classes.size()) {
+            BenchClassScore cs = {};
+            cs.efficiencyClass = t.placement.efficiencyClass;
+            classes.push_back(cs);
+        }
+        classes[c].threads++;
+        classes[c].score += t.opsPerSec;
+    }
+    for (BenchClassScore& cs : classes) cs.perThread = cs.score / cs.threads;
+    std::sort(classes.begin(), classes.end(),
+        [](const BenchClassScore& a, const BenchClassScore& b) { return a.efficiencyClass > b.efficiencyClass; });
+    return classes;
+}
+
+// Sum per-thread windows into the final score
+static void BuildResult() {
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    g_result = BenchResult();
+    g_result.threadCount = n;
+    g_result.threads.assign(g_threadResults.begin(), g_threadResults.begin() + n);
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || g_placement[i].group != g_placement[i - 1].group) g_result.groupCount++;
+    }
+    BenchTopology topo = BenchGetTopology();
+    g_result.logicalCount = topo.logicalCount;
+    g_result.effectiveCount = topo.effectiveCount;
+    int64_t firstStart = 0, lastStart = 0, lastStop = 0;
+    for (int i = 0; i < n; i++) {
+        const BenchThreadResult& t = g_threadResults[i];
+        g_result.score += t.opsPerSec;
+        g_result.totalOps += t.ops;
+        if (i == 0 || t.startNs < firstStart) firstStart = t.startNs;
+        if (i == 0 || t.startNs > lastStart) lastStart = t.startNs;
+        if (i == 0 || t.stopNs > lastStop) lastStop = t.stopNs;
+    }
+    g_result.elapsedSec = (double)(lastStop - firstStart) / 1e9;
+    g_result.startSkewNs = lastStart - firstStart;
+    g_result.stats = CollectRateStats();
+    g_result.adaptive = g_cfg.adaptive;
+    g_result.converged = g_converged;
+    BuildTimeSeries(&g_result.series);
+    g_result.throttle = BenchAnalyzeThrottling(g_result.series.total.data(), (int)g_result.series.total.size(),
+        g_result.series.warmupSamples);
+    g_result.pinned = g_cfg.pinThreads && !g_simulated;
+    if (g_result.pinned) g_result.classes = BenchClassScores(g_result.threads);
+    g_result.spread = BenchAnalyzeSpread(g_result.threads, g_result.pinned);
+    g_result.completed = true;
+}
+
+// Control: release the workers of one phase together once all have arrived at the barrier
+static void RunPhase() {
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    while (g_arrived.load(std::memory_order_acquire) < n && !g_cancel.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+    }
+
+    int64_t release = BenchNowNs();
+    int64_t warmupEnd = release + (int64_t)g_cfg.warmupMs * 1000000;
+    int64_t windowMs = g_cfg.adaptive ? g_cfg.maxDurationMs : g_cfg.durationMs;
+    int64_t minStop = warmupEnd + (int64_t)g_cfg.minDurationMs * 1000000;
+    g_releaseNs.store(release, std::memory_order_relaxed);
+    g_warmupEndNs.store(warmupEnd, std::memory_order_relaxed);
+    g_stopNs.store(warmupEnd + windowMs * 1000000, std::memory_order_relaxed);
+    g_released.store(true, std::memory_order_release);
+    g_go.store(true, std::memory_order_release);
+
+    // Track precision while the workers run; adaptive runs stop once it is good enough
+    bool stopRequested = false;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(g_finishLock);
+            if (g_finishCv.wait_for(lock, std::chrono::milliseconds(5),
+                    [n] { return g_finished.load(std::memory_order_acquire) >= n; })) break;
+        }
+        if (g_cancel.load(std::memory_order_relaxed)) continue;
+        BenchRateStats st = CollectRateStats();
+        {
+            std::lock_guard<std::mutex> lock(g_statsLock);
+            g_liveStats = st;
+        }
+        int64_t now = BenchNowNs();
+        if (g_cfg.adaptive && !stopRequested && now >= minStop && st.batches >= 3 &&
+            st.precision > 0.0 && st.precision <= g_cfg.targetPrecision) {
+            g_stopNs.store(now, std::memory_order_relaxed);
+            g_converged = true;
+            stopRequested = true;
+        }
+    }
+
+}
+
+// Reset per-thread and barrier state for a phase; the pool is idle or every
+// worker of the previous phase has finished
+static void ResetPhaseState(const std::vector<BenchPlacement>& plan) {
+    int n = (int)plan.size();
+    g_placement = plan;
+    for (int i = 0; i < n; i++) {
+        g_threadOps[i].ops.store(0, std::memory_order_relaxed);
+        g_threadResults[i] = BenchThreadResult();
+        g_samples[i].slots.assign(g_sampleSlots, BenchSample());
+        g_samples[i].count.store(0, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_statsLock);
+        g_liveStats = BenchRateStats();
+    }
+    g_converged = false;
+    g_finished.store(0, std::memory_order_relaxed);
+    g_arrived.store(0, std::memory_order_relaxed);
+    g_go.store(false, std::memory_order_relaxed);
+    g_released.store(false, std::memory_order_relaxed);
+    g_runThreads.store(n, std::memory_order_relaxed);
+}
+
+// Publish the next phase to the pool from the control thread
+static void PublishPhase(int k) {
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        ResetPhaseState(g_phases[k]);
+        g_phaseIndex.store(k, std::memory_order_relaxed);
+        g_participants += g_runThreads.load(std::memory_order_relaxed);
+        g_runGeneration++;
+    }
+    g_poolWake.notify_all();
+}
+
+// SMT modes: the physical phase is the solo baseline of every core, the
+// logical phase loads every sibling; pairs are matched by core
+static void BuildSmtReport(BenchResult* res) {
+    const BenchResult& phys = g_phaseResults[0];
+    const BenchResult& logical = g_phaseResults.back();
+    BenchSmtReport& smt = res->smt;
+    smt.mode = g_cfg.smtMode;
+    smt.physicalScore = phys.score;
+    smt.logicalScore = logical.score;
+    smt.yield = phys.score > 0.0 ? logical.score / phys.score : 0.0;
+    if (g_cfg.smtMode != BENCH_SMT_PAIRS) return;
+    for (const BenchThreadResult& solo : phys.threads) {
+        BenchSmtPair pair = {};
+        pair.core = solo.placement.core;
+        pair.cpuA = solo.placement.cpu;
+        pair.cpuB = -1;
+        pair.solo = solo.opsPerSec;
+        int siblings = 0;
+        for (const BenchThreadResult& t : logical.threads) {
+            if (t.placement.core != pair.core || t.placement.group != solo.placement.group) continue;
+            pair.paired += t.opsPerSec;
+            if (t.placement.cpu != pair.cpuA && pair.cpuB < 0) pair.cpuB = t.placement.cpu;
+            siblings++;
+        }
+        if (pair.solo > 0.0 && siblings > 0) {
+            pair.slowdownPct = (1.0 - pair.paired / siblings / pair.solo) * 100.0;
+            pair.yield = pair.paired / pair.solo;
+        }
+        smt.pairs.push_back(pair);
+    }
+}
+
+// Sweeps: every phase is one step; the last (largest) one is the headline
+static void BuildScalingReport(BenchResult* res) {
+    std::vector<int> threads;
+    std::vector<double> scores;
+    for (const BenchResult& r : g_phaseResults) {
+        threads.push_back(r.threadCount);
+        scores.push_back(r.score);
+    }
+    res->scaling = BenchAnalyzeScaling(threads.data(), scores.data(), (int)threads.size());
+    res->scaling.mode = g_cfg.scalingMode;
+    for (size_t i = 0; i < res->scaling.points.size(); i++) {
+        res->scaling.points[i].precision = g_phaseResults[i].stats.precision;
+    }
+}
+
+// Control: run every phase, then pick the headline result
+static void BenchCoordinator() {
+    g_phaseResults.clear();
+    for (int k = 0; k < (int)g_phases.size(); k++) {
+        if (k > 0) PublishPhase(k);
+        RunPhase();
+        if (g_cancel.load(std::memory_order_relaxed)) break;
+        BuildResult();
+        g_phaseResults.push_back(g_result);
+    }
+    if (!g_cancel.load(std::memory_order_relaxed) && g_cfg.smtMode != BENCH_SMT_OFF) {
+        g_result = g_cfg.smtMode == BENCH_SMT_PHYSICAL ? g_phaseResults[0] : g_phaseResults.back();
+        BuildSmtReport(&g_result);
+    } else if (!g_cancel.load(std::memory_order_relaxed) && g_cfg.scalingMode != BENCH_SCALING_OFF) {
+        BuildScalingReport(&g_result);
+    }
+    if (g_opsPerIter != 1.0) BenchScaleRates(&g_result, g_opsPerIter);
+    {
+        // A cancel that stopped waiting for this thread leaves the reset to it
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        if (g_cancel.load(std::memory_order_relaxed)) g_result = BenchResult();
+    }
+    g_done.store(true, std::memory_order_release);
+}
+
+// Pool thread body: park until a new run is published, take part if needed
+static void PoolThread(int idx) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(g_poolLock);
+    while (true) {
+        g_poolWake.wait(lock, [&seen] { return g_poolShutdown || g_runGeneration != seen; });
+        if (g_poolShutdown) return;
+        seen = g_runGeneration;
+        if (idx >= g_runThreads.load(std::memory_order_relaxed)) continue;  // not part of this phase
+        lock.unlock();
+        if (idx < 0) BenchCoordinator();
+        else BenchWorker(idx);
+        lock.lock();
+        // The control thread published the later phases itself; workers must
+        // still see them
+        if (idx < 0) seen = g_runGeneration;
+        if (--g_participants == 0) g_poolIdle.notify_all();
+    }
+}
+
+void BenchShutdown() {
+    BenchCancel();
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        g_poolShutdown = true;
+    }
+    g_poolWake.notify_all();
+    if (g_controlThread.joinable()) g_controlThread.join();
+    for (std::thread& t : g_poolWorkers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+// Create missing pool threads; called with g_poolLock held
+static void EnsurePoolThreads(int workers) {
+    if (!g_controlThread.joinable()) {
+        g_controlThread = std::thread(PoolThread, -1);
+        atexit(BenchShutdown);
+    }
+    while ((int)g_poolWorkers.size() < workers) {
+        g_poolWorkers.emplace_back(PoolThread, (int)g_poolWorkers.size());
+    }
+}
+
+// Grow the per-thread arrays; called with g_poolLock held and the pool idle
+static void EnsureThreadCapacity(int n) {
+    if (n <= g_threadCapacity) return;
+    int cap = g_threadCapacity > 0 ? g_threadCapacity : 16;
+    while (cap < n) cap *= 2;
+    g_threadOps.reset(new PaddedCounter[cap]);
+    g_samples.reset(new BenchSampleLog[cap]);
+    g_threadResults.resize(cap);
+    g_threadCapacity = cap;
+}
+
+int BenchPoolSize() {
+    std::lock_guard<std::mutex> lock(g_poolLock);
+    return (int)g_poolWorkers.size() + (g_controlThread.joinable() ? 1 : 0);
+}
+
+BenchCancelStats BenchGetCancelStats() {
+    std::lock_guard<std::mutex> lock(g_poolLock);
+    return g_cancelStats;
+}
+
+void BenchScaleRates(BenchResult* r, double factor) {
+    r->score *= factor;
+    r->threadedScore *= factor;
+    r->stats.mean *= factor;
+    r->stats.halfWidth *= factor;
+    for (double& v : r->series.total) v *= factor;
+    for (std::vector<double>& t : r->series.perThread) {
+        for (double& v : t) v *= factor;
+    }
+    r->throttle.peak *= factor;
+    r->throttle.sustained *= factor;
+    for (BenchThreadResult& t : r->threads) t.opsPerSec *= factor;
+    r->spread.min *= factor;
+    r->spread.median *= factor;
+    r->spread.max *= factor;
+    for (BenchClassScore& c : r->classes) {
+        c.score *= factor;
+        c.perThread *= factor;
+    }
+    r->smt.physicalScore *= factor;
+    r->smt.logicalScore *= factor;
+    for (BenchSmtPair& p : r->smt.pairs) {
+        p.solo *= factor;
+        p.paired *= factor;
+    }
+    for (BenchScalingPoint& p : r->scaling.points) p.score *= factor;
+}
+
+bool BenchStart(const BenchConfig& cfg) {
+    if (g_active) return false;
+    // Copy the name out so an unterminated one can't be read past its end
+    char kernelName[BENCH_KERNEL_NAME_MAX];
+    memcpy(kernelName, cfg.kernel, sizeof(kernelName));
+    kernelName[sizeof(kernelName) - 1] = '\0';
+    const BenchKernel* kernel = BenchFindKernel(kernelName);
+    if (!kernel || !kernel->run) return false;
+    std::unique_lock<std::mutex> lock(g_poolLock);
+    // A cancel that exceeded its bound leaves threads finishing their last chunk
+    g_poolIdle.wait(lock, [] { return g_participants == 0; });
+    g_cfg = cfg;
+    g_kernelRun = kernel->run;
+    g_opsPerIter = kernel->opsPerIter;
+    if (g_cfg.threadCount < 1) g_cfg.threadCount = 1;
+    if (g_cfg.threadCount > BENCH_MAX_THREADS) g_cfg.threadCount = BENCH_MAX_THREADS;
+    if (g_cfg.warmupMs < 0) g_cfg.warmupMs = 0;
+    if (g_cfg.durationMs < 1) g_cfg.durationMs = 1;
+    if (g_cfg.sampleIntervalMs < 1) g_cfg.sampleIntervalMs = 1;
+    if (g_cfg.minDurationMs < 0) g_cfg.minDurationMs = 0;
+    if (g_cfg.maxDurationMs < g_cfg.minDurationMs) g_cfg.maxDurationMs = g_cfg.minDurationMs;
+    if (g_cfg.maxDurationMs < 1) g_cfg.maxDurationMs = 1;
+    if (g_cfg.slowPct < 0) g_cfg.slowPct = 0;
+    if (g_cfg.slowPct > 90) g_cfg.slowPct = 90;
+
+    // Enough sample slots for the longest possible window plus the stop overrun
+    int windowMs = g_cfg.adaptive ? g_cfg.maxDurationMs : g_cfg.durationMs;
+    g_sampleSlots = (g_cfg.warmupMs + windowMs) / g_cfg.sampleIntervalMs + 4;
+    BenchTopology topo = BenchTopologyFor(g_cfg);
+    g_simulated = topo.simulated;
+    g_phases.clear();
+    if (g_cfg.smtMode != BENCH_SMT_OFF) {
+        // SMT modes place one pinned thread per core, then one per logical
+        // processor; without SMT the second phase would repeat the first
+        g_cfg.pinThreads = true;
+        g_phases.push_back(BenchPlanPhysical(topo));
+        std::vector<BenchPlacement> logical = BenchPlanLogical(topo);
+        if (logical.size() > g_phases[0].size()) g_phases.push_back(logical);
+    } else if (g_cfg.scalingMode != BENCH_SCALING_OFF) {
+        // Pinned sweeps add a physical core per thread before using siblings
+        for (int n : BenchScalingSteps(g_cfg.scalingMode, g_cfg.threadCount)) {
+            g_phases.push_back(g_cfg.pinThreads ? BenchPlanCoresFirst(topo, n) : BenchPlanPlacement(topo, n));
+        }
+    } else {
+        g_phases.push_back(BenchPlanPlacement(topo, g_cfg.threadCount));
+    }
+    int maxThreads = 0;
+    for (const std::vector<BenchPlacement>& plan : g_phases) {
+        if ((int)plan.size() > maxThreads) maxThreads = (int)plan.size();
+    }
+    EnsureThreadCapacity(maxThreads);
+    ResetPhaseState(g_phases[0]);
+    g_phaseIndex.store(0, std::memory_order_relaxed);
+    g_result = BenchResult();
+    g_cancel.store(false, std::memory_order_relaxed);
+    g_runError.store(NULL, std::memory_order_relaxed);
+    g_done.store(false, std::memory_order_relaxed);
+    EnsurePoolThreads(maxThreads);
+    g_participants = g_runThreads.load(std::memory_order_relaxed) + 1;
+    g_runGeneration++;
+    g_active = true;
+    lock.unlock();
+    g_poolWake.notify_all();
+    return true;
+}
+
+bool BenchIsDone() {
+    return g_done.load(std::memory_order_acquire);
+}
+
+int64_t BenchCancel() {
+    if (!g_active) return 0;
+    int64_t t0 = BenchNowNs();
+    g_cancel.store(true, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(g_poolLock);
+    bool parked = g_poolIdle.wait_for(lock, std::chrono::milliseconds(BENCH_CANCEL_BOUND_MS),
+        [] { return g_participants == 0; });
+    int64_t latency = BenchNowNs() - t0;
+    g_cancelStats.count++;
+    g_cancelStats.lastNs = latency;
+    if (latency > g_cancelStats.maxNs) g_cancelStats.maxNs = latency;
+    if (!parked) g_cancelStats.overBound++;
+    // Past the bound the coordinator may still be writing the result; it
+    // clears it itself once it sees the cancel
+    if (parked) g_result = BenchResult();
+    g_active = false;
+    return latency;
+}
+
+BenchProgress BenchGetProgress() {
+    BenchProgress p = {};
+    int64_t phaseNs = ((int64_t)g_cfg.warmupMs + (g_cfg.adaptive ? g_cfg.maxDurationMs : g_cfg.durationMs)) * 1000000;
+    p.runPhaseCount = g_active ? (int)g_phases.size() : 1;
+    p.runPhase = g_phaseIndex.load(std::memory_order_relaxed);
+    p.totalNs = phaseNs * p.runPhaseCount;
+    if (!g_active) {
+        p.phase = BENCH_PHASE_IDLE;
+        return p;
+    }
+    int n = g_runThreads.load(std::memory_order_relaxed);
+    for (int i = 0; i < n; i++) {
+        p.ops += g_threadOps[i].ops.load(std::memory_order_relaxed);
+    }
+    if (g_done.load(std::memory_order_acquire)) {
+        p.phase = BENCH_PHASE_DONE;
+        p.elapsedNs = p.totalNs;
+    } else if (!g_released.load(std::memory_order_acquire)) {
+        p.phase = BENCH_PHASE_STARTING;
+        p.elapsedNs = phaseNs * p.runPhase;
+    } else {
+        int64_t now = BenchNowNs();
+        p.elapsedNs = phaseNs * p.runPhase + now - g_releaseNs.load(std::memory_order_relaxed);
+        p.phase = (now < g_warmupEndNs.load(std::memory_order_relaxed)) ? BENCH_PHASE_WARMUP : BENCH_PHASE_MEASURE;
+    }
+    std::lock_guard<std::mutex> lock(g_statsLock);
+    p.stats = g_liveStats;
+    return p;
+}
+
+BenchResult BenchGetResult() {
+    if (!g_active) return BenchResult();
+    std::unique_lock<std::mutex> lock(g_poolLock);
+    g_poolIdle.wait(lock, [] { return g_participants == 0; });
+    g_active = false;
+    return g_result;
+}
+
+const char* BenchRunError() {
+    const char* why = g_runError.load(std::memory_order_acquire);
+    return why ? why : "";
+}
+
+// Workers see the cancel after their current chunk; the control thread then
+// ends the phase without building a result
+void BenchFailRun(const char* why) {
+    const char* none = NULL;
+    g_runError.compare_exchange_strong(none, why, std::memory_order_acq_rel);
+    g_cancel.store(true, std::memory_order_relaxed);
+}
+
+BenchResult BenchRun(const BenchConfig& cfg) {
+    if (!BenchStart(cfg)) return BenchResult();
+    return BenchGetResult();
+}
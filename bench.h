@@ -0,0 +1,720 @@
+// Portable benchmark core shared by the GUI and the headless runner.
+// Everything in here builds on Windows and Linux; no Win32 types.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "bench_plugin.h"
+
+// Sanity limit on worker threads; per-thread state is sized per run
+#define BENCH_MAX_THREADS 4096
+
+// Workers size their chunks (ops between progress publishes, clock and cancel
+// checks) so one chunk takes about this long
+#define BENCH_CHUNK_TARGET_US 250
+#define BENCH_CHUNK_MIN_OPS 256
+#define BENCH_CHUNK_MAX_OPS (1 << 24)
+
+// BenchCancel waits at most this long for every pool thread to park: one chunk
+// plus scheduling slack when the machine is oversubscribed
+#define BENCH_CANCEL_BOUND_MS 50
+
+// Ops/s samples are grouped into batches of this many intervals for the
+// confidence interval, so short-term autocorrelation doesn't shrink it
+#define BENCH_BATCH_INTERVALS 5
+
+// SMT placement modes. Each pins one thread per physical core, then one per
+// logical processor (the second phase is skipped without SMT), and reports
+// the SMT yield; the mode picks the headline score and PAIRS adds the
+// per-core sibling breakdown.
+enum BenchSmtMode {
+    BENCH_SMT_OFF,             // plain run, threadCount workers
+    BENCH_SMT_PHYSICAL,        // score = one thread per physical core
+    BENCH_SMT_ALL,             // score = one thread per logical processor
+    BENCH_SMT_PAIRS            // as ALL, plus per-pair slowdown against the solo core
+};
+
+// Thread-scaling sweep: one phase per thread count up to threadCount, each a
+// full warm-up + measurement run
+enum BenchScalingMode {
+    BENCH_SCALING_OFF,
+    BENCH_SCALING_POW2,        // 1, 2, 4, ... and threadCount itself
+    BENCH_SCALING_EVERY        // every count from 1 to threadCount
+};
+
+// A step whose added threads return less than this fraction of one thread's
+// rate each is past the knee
+#define BENCH_KNEE_MARGINAL 0.5
+
+// Kernel names, NUL included
+#define BENCH_KERNEL_NAME_MAX 32
+
+// Plugins are loaded from this directory next to the executable, and from
+// every file or directory listed in this environment variable (separated like
+// PATH), which child processes inherit
+#define BENCH_PLUGIN_DIR "plugins"
+#define BENCH_PLUGIN_ENV "RTBENCH_PLUGINS"
+
+// Forces the ISA of the "simd" kernel (scalar, sse2, avx2, avx512) in this
+// process and its children; ignored if the CPU lacks it
+#define BENCH_ISA_ENV "RTBENCH_ISA"
+
+// Forces how the memory-access kernels (pointer chase, random access) get
+// their buffers (default, 4k, thp, 2m, 1g) in this process and its children
+#define BENCH_PAGES_ENV "RTBENCH_PAGES"
+
+// Forces the allocator of the "alloc-churn" and "alloc-xthread" kernels
+// (system, pool) in this process and its children
+#define BENCH_ALLOC_ENV "RTBENCH_ALLOC"
+
+// SIMD instruction sets, narrowest first
+enum BenchIsa {
+    BENCH_ISA_SCALAR = 0,
+    BENCH_ISA_SSE2 = 1,
+    BENCH_ISA_AVX2 = 2,        // with FMA
+    BENCH_ISA_AVX512 = 3,      // AVX-512F
+    BENCH_ISA_COUNT
+};
+
+// Run configuration
+struct BenchConfig {
+    // Registry kernel the workers run. Its thread model is applied by the
+    // front ends; the core runs threadCount workers of any kernel.
+    char kernel[BENCH_KERNEL_NAME_MAX] = "cpu";
+    int threadCount = 1;       // 1 = single-core, >1 = multi-core
+    int warmupMs = 1000;       // excluded from the score
+    int durationMs = 10000;    // measurement window per thread (fixed mode)
+    int sampleIntervalMs = 100;  // workers record progress at this interval
+
+    // Split the logical processors (at least threadCount of them) into groups
+    // of this size instead of the OS groups; placement is planned but not
+    // applied, so group logic can be exercised on any machine
+    int simulatedGroupSize = 0;
+    int simulatedSmt = 0;      // >1: pretend every core has this many siblings
+
+    // Pin every worker to the single logical processor it was placed on, so
+    // per-core scores and efficiency-class subtotals are meaningful
+    bool pinThreads = false;
+
+    // BenchSmtMode; anything but OFF ignores threadCount and pins
+    int smtMode = BENCH_SMT_OFF;
+
+    // BenchScalingMode; sweeps 1..threadCount, pinned cores-first if pinThreads
+    int scalingMode = BENCH_SCALING_OFF;
+
+    // Testing: worker `slowThread` idles `slowPct` % of its time (at most 90),
+    // so the straggler report has something to find
+    int slowThread = -1;
+    int slowPct = 0;
+
+    // Adaptive mode: measure until the 95 % CI of the rate is within
+    // +-targetPrecision of the mean, bounded by min/max duration
+    bool adaptive = false;
+    double targetPrecision = 0.005;
+    int minDurationMs = 2000;
+    int maxDurationMs = 30000;
+};
+
+// Batch-means confidence interval of a rate (95 %, Student t)
+struct BenchRateStats {
+    int batches;
+    double mean;
+    double halfWidth;
+    double precision;          // halfWidth / mean, 0 if undetermined
+};
+
+// Throughput per sample interval from barrier release, warm-up included so
+// turbo decay in the first seconds is visible
+struct BenchTimeSeries {
+    int intervalMs = 0;
+    int warmupSamples = 0;     // leading samples that fall in the warm-up phase
+    std::vector<double> total;                   // ops/s, all threads
+    std::vector<std::vector<double>> perThread;  // ops/s per worker
+};
+
+// Throttling / turbo-decay summary of a time series
+#define BENCH_THROTTLE_DROP_PCT 5.0   // sustained this far below peak = throttling
+#define BENCH_SMOOTH_SAMPLES 5        // rolling window applied before peak/sustained
+struct BenchThrottleSummary {
+    double peak;               // highest smoothed rate
+    double sustained;          // mean smoothed rate over the last third of the run
+    double dropPct;            // (peak - sustained) / peak
+    int onsetSample;           // first sample after the peak that drops below the threshold, -1 if none
+    bool throttled;
+};
+
+// A logical processor / where a worker runs: its group and a processor index
+// inside that group (the CPU id on Linux, where there is a single group), plus
+// the physical core and package it belongs to. Efficiency classes follow the
+// Windows convention: 0 is the most efficient (slowest) class, higher classes
+// are faster, and all processors are class 0 on non-hybrid machines.
+struct BenchPlacement {
+    int group;
+    int cpu;
+    int core;                  // machine-wide physical core index
+    int package;
+    int efficiencyClass;
+};
+
+// Per-thread measurement, stamps are relative to the barrier release
+struct BenchThreadResult {
+    int64_t ops;               // ops inside the measurement window only
+    int64_t startNs;
+    int64_t stopNs;
+    double opsPerSec;
+    BenchPlacement placement;  // where the worker was placed (exact CPU when pinned)
+};
+
+// A thread this far below the median rate of its peers is a straggler
+#define BENCH_STRAGGLER_PCT 10.0
+
+struct BenchStraggler {
+    int thread;                // index into BenchResult::threads
+    double deficitPct;         // below the peer median
+};
+
+// Distribution of per-thread rates. Pinned runs compare each thread with the
+// median of its efficiency class, so E-cores are not all flagged on hybrids.
+struct BenchThreadSpread {
+    double min, median, max;   // ops/s per thread
+    double cv;                 // coefficient of variation, stddev / mean
+    std::vector<BenchStraggler> stragglers;  // slowest first
+};
+
+// Pinned-run subtotal for one efficiency class
+struct BenchClassScore {
+    int efficiencyClass;
+    int threads;
+    double score;              // ops/s, sum over the class
+    double perThread;          // ops/s, mean per thread
+};
+
+// Logical processors as the OS schedules them: Windows processor groups (at
+// most 64 each), a single group elsewhere. The effective count is what this
+// process may actually use: its affinity mask (process, job object or
+// sched_getaffinity) capped by a CPU quota (job rate cap, cgroup cpu.max or
+// cfs_quota_us), rounded up.
+struct BenchTopology {
+    int logicalCount = 0;      // online logical processors in the machine
+    int coreCount = 0;         // physical cores in the machine
+    int effectiveCount = 0;    // threads the multicore run defaults to
+    int classCount = 1;        // distinct efficiency classes (2 on P-core/E-core parts)
+    double cpuQuota = 0.0;     // CPUs' worth of time allowed, 0 = unlimited
+    std::vector<int> groupSizes;
+    std::vector<BenchPlacement> allowed;  // processors in the affinity mask, by group
+    bool simulated = false;    // layout comes from BenchConfig::simulated*
+};
+
+// One physical core in SMT pairs mode: its first sibling alone, then all of
+// its siblings loaded together
+struct BenchSmtPair {
+    int core;
+    int cpuA, cpuB;            // siblings (cpuB = -1 on a core without SMT)
+    double solo;               // ops/s, cpuA alone (physical phase)
+    double paired;             // ops/s, all siblings together (logical phase)
+    double slowdownPct;        // per-thread loss from sharing the core
+    double yield;              // paired / solo
+};
+
+struct BenchSmtReport {
+    int mode = BENCH_SMT_OFF;
+    double physicalScore = 0.0;  // ops/s, one thread per core
+    double logicalScore = 0.0;   // ops/s, one thread per logical processor
+    double yield = 0.0;          // logicalScore / physicalScore
+    std::vector<BenchSmtPair> pairs;  // pairs mode only
+};
+
+// One step of a scaling sweep
+struct BenchScalingPoint {
+    int threads;
+    double score;              // ops/s, all threads
+    double speedup;            // score / single-thread score
+    double efficiency;         // speedup / threads
+    double precision;          // achieved precision of the step's score
+};
+
+// Models fitted to the speedup curve by least squares. Amdahl:
+// S(n) = 1 / (s + (1 - s) / n). Universal Scalability Law:
+// S(n) = n / (1 + sigma (n - 1) + kappa n (n - 1)), where kappa > 0 means
+// throughput eventually falls as threads are added.
+struct BenchScalingFit {
+    double serialFraction;     // Amdahl s
+    double sigma;              // USL contention
+    double kappa;              // USL coherency
+    double peakThreads;        // USL throughput maximum, 0 if it never turns over
+    int kneeThreads;           // last count before the marginal gain drops below BENCH_KNEE_MARGINAL
+};
+
+struct BenchScalingReport {
+    int mode = BENCH_SCALING_OFF;
+    std::vector<BenchScalingPoint> points;
+    BenchScalingFit fit = {};
+};
+
+struct BenchResult {
+    bool completed = false;    // false if cancelled
+    int threadCount = 0;
+    int groupCount = 0;        // processor groups the workers were spread over
+    int logicalCount = 0;      // machine logical processors
+    int effectiveCount = 0;    // processors available to this process
+    double score = 0.0;        // ops/s, sum of per-thread measured rates
+    double elapsedSec = 0.0;   // first start stamp to last stop stamp
+    int64_t totalOps = 0;
+    int64_t startSkewNs = 0;   // spread between earliest and latest start stamp
+    BenchRateStats stats = {}; // achieved precision of the score
+    bool adaptive = false;
+    bool converged = false;    // adaptive run hit its target before maxDurationMs
+    BenchTimeSeries series;
+    BenchThrottleSummary throttle = {};
+    std::vector<BenchThreadResult> threads;
+    BenchThreadSpread spread = {};
+    bool pinned = false;
+    std::vector<BenchClassScore> classes;  // pinned runs only, fastest class first
+    BenchSmtReport smt;        // SMT modes only
+    BenchScalingReport scaling;  // sweeps only; the headline is the largest count
+    bool processes = false;    // one worker process per thread (BenchProcStart)
+    double threadedScore = 0.0;  // processes runs: ops/s of the same run as threads
+};
+
+enum BenchPhase {
+    BENCH_PHASE_IDLE,
+    BENCH_PHASE_STARTING,      // workers spawned, waiting at the start barrier
+    BENCH_PHASE_WARMUP,
+    BENCH_PHASE_MEASURE,
+    BENCH_PHASE_DONE
+};
+
+struct BenchProgress {
+    BenchPhase phase;
+    int64_t elapsedNs;         // since barrier release (warm-up included)
+    int64_t totalNs;           // warm-up + duration (max duration when adaptive)
+    int64_t ops;               // ops published so far, all threads
+    BenchRateStats stats;      // running precision, measurement phase only
+    int runPhase;              // current placement phase (SMT modes run two, sweeps one per step)
+    int runPhaseCount;
+};
+
+// Measured cancel latency, request to every participating thread parked
+struct BenchCancelStats {
+    int count;
+    int overBound;             // cancels that exceeded BENCH_CANCEL_BOUND_MS
+    int64_t lastNs;
+    int64_t maxNs;
+};
+
+// A registered kernel. Built-in kernels and their variants come first, then
+// kernels the executable adds (the GUI's gpu), then plugins in load order;
+// the registry only grows, so indices stay valid.
+struct BenchKernel {
+    std::string name;
+    std::string label;
+    std::string unit;
+    double opsPerIter;
+    int threadModel;           // BenchKernelThreadModel
+    BenchKernelRunFn run;      // NULL for BENCH_KERNEL_EXTERNAL
+    std::string source;        // plugin file, "" for kernels built into the executable
+    bool variant = false;      // forced variant of another kernel (simd-avx2); not in the GUI menu
+};
+
+// Add a kernel; false (and *error says why) if it is malformed or its name is taken
+bool BenchRegisterKernel(const BenchKernelInfo& info, const char* source, std::string* error);
+
+// Load BENCH_PLUGIN_DIR and BENCH_PLUGIN_ENV; files already loaded are
+// skipped, so this may be called again after changing the variable. Returns
+// the kernels added; problems are collected in BenchPluginErrors.
+int BenchLoadPlugins();
+const std::vector<std::string>& BenchPluginErrors();
+
+const std::vector<BenchKernel>& BenchKernels();
+const BenchKernel* BenchFindKernel(const char* name);  // NULL if unknown
+int BenchKernelIndex(const char* name);                // -1 if unknown
+
+// Divisor and label for showing rates in a kernel's unit ("GB/s", "Mflop/s"),
+// the prefix (K, M, G) picked from `reference`, the score being shown
+struct BenchRateUnit {
+    double scale;
+    char label[48];
+};
+BenchRateUnit BenchRateUnitFor(double reference, const std::string& unit);
+
+// Name of a numeric benchmark type from history files written before the
+// registry (0 cpu, 1 gpu, 2 multicore, 3 scaling), NULL if out of range
+const char* BenchLegacyKernelName(int type);
+
+// Append a result to a history file (false if it can't be opened). Fields
+// after the score (M<unit>/s) are optional: precision, drop %, throttled flag,
+// sample interval, the M<unit>/s series (';'-separated) and, for pinned runs,
+// per-core M<unit>/s as group:cpu/class=value (';'-separated), then for SMT
+// modes smt:mode:physical:logical:yield. Scaling sweeps add
+// scaling:mode:serial:sigma:kappa:knee:threads=Mops/efficiency;... (the whole
+// curve); `extra`, if not NULL, is appended as one more tagged field.
+bool BenchAppendHistory(const char* path, const char* kernel, double score, double precision, const BenchTimeSeries& series,
+                        const BenchThrottleSummary& throttle, const std::vector<BenchThreadResult>& cores,
+                        const BenchSmtReport& smt, const BenchScalingReport& scaling, const char* extra);
+
+// Multiply every rate in a result by `factor` (a kernel's opsPerIter), so
+// scores read in the kernel's unit; op counts stay in iterations
+void BenchScaleRates(BenchResult* r, double factor);
+
+// Active logical processors in every group (cached after the first call)
+BenchTopology BenchGetTopology();
+
+// Data cache sizes seen by the first processor and installed memory, in
+// bytes; 0 where the OS doesn't say (cached after the first call)
+struct BenchCacheInfo {
+    int64_t l1d = 0;
+    int64_t l2 = 0;
+    int64_t l3 = 0;
+    int64_t memory = 0;
+};
+BenchCacheInfo BenchGetCacheInfo();
+
+// Last-level cache domain of each processor in topo.allowed: processors
+// sharing their largest cache (an L3 slice, a CCX on AMD) get the same
+// number, -1 where the OS doesn't say
+std::vector<int> BenchLlcDomains(const BenchTopology& topo);
+
+// Topology with the processors split into groups of `groupSize` and cores of
+// `threadsPerCore` siblings (simulation)
+BenchTopology BenchSimulateTopology(int logicalCount, int groupSize, int threadsPerCore);
+
+// The topology a run with `cfg` is planned on: the real one, or the simulated
+// layout with at least cfg.threadCount processors
+BenchTopology BenchTopologyFor(const BenchConfig& cfg);
+
+// Spread `threadCount` workers evenly over the allowed processors, so each
+// group gets threads in proportion to its allowed processors; processors
+// repeat when there are more threads than processors
+std::vector<BenchPlacement> BenchPlanPlacement(const BenchTopology& topo, int threadCount);
+
+// SMT phases: the first allowed processor of every physical core, and every
+// allowed processor ordered by core so siblings are adjacent
+std::vector<BenchPlacement> BenchPlanPhysical(const BenchTopology& topo);
+std::vector<BenchPlacement> BenchPlanLogical(const BenchTopology& topo);
+
+// Scaling sweep step: the first `threadCount` processors taking one per
+// physical core before any sibling, repeating past the allowed count
+std::vector<BenchPlacement> BenchPlanCoresFirst(const BenchTopology& topo, int threadCount);
+
+// Thread counts a sweep up to `maxThreads` visits
+std::vector<int> BenchScalingSteps(int mode, int maxThreads);
+
+// Speedup, efficiency, model fit and knee of measured (threads, score) steps;
+// the first step must be the single-thread run
+BenchScalingReport BenchAnalyzeScaling(const int* threads, const double* scores, int count);
+
+// Restrict the calling thread to its group (Windows with several groups), or
+// to exactly its processor when pinned; an unpinned call undoes an earlier pin
+void BenchApplyPlacement(const BenchPlacement& p, bool pin);
+
+// "P"/"E" on two-class hybrids, "C<n>" with more classes, "" when uniform
+const char* BenchClassLabel(int efficiencyClass, int classCount);
+
+// Monotonic high-resolution clock in nanoseconds
+int64_t BenchNowNs();
+
+// Workers in the run phase in progress, for kernels that split a working set
+// between them; 1 outside a run
+int BenchRunThreads();
+int BenchRunWorker();                        // this worker's index in the phase, 0 outside a run
+
+// The CPU kernel: x = sin(x) * cos(x) + sqrt(x + 1.0), `iters` times on a volatile
+double BenchCpuKernel(double x, int64_t iters);
+
+// SIMD kernels: acc = acc * m + c on 8 independent accumulators of each ISA's
+// widest double vector (FMA on AVX2/AVX-512), BenchIsaFlopsPerIter flop per iteration
+const char* BenchIsaName(int isa);
+int BenchIsaFromName(const char* name);      // -1 if unknown
+bool BenchIsaSupported(int isa);             // built in, and CPU and OS support it (CPUID, XCR0)
+int BenchIsaSelected();                      // BENCH_ISA_ENV if supported, else the widest supported
+BenchKernelRunFn BenchIsaKernel(int isa);    // NULL if unsupported
+double BenchIsaFlopsPerIter(int isa);
+
+// Core clock in GHz while `threads` threads alternate `load` with a chain of
+// fixed-latency multiplies, for about `durationMs`; shows frequency licences
+// (AVX-512 clocking down). 0 where there is no reference instruction (non-x86).
+double BenchMeasureClockGHz(BenchKernelRunFn load, int threads, int durationMs);
+
+// ILP kernels: `chains` independent x = x * m + a chains of float or double,
+// each written out `unroll` times per iteration (2 * chains * unroll flop).
+// One chain shows the latency of a multiply-add step, more chains the point
+// where the FP ports saturate. NULL for a combination that isn't built.
+#define BENCH_ILP_MAX_CHAINS 16
+enum BenchIlpType { BENCH_ILP_DOUBLE = 0, BENCH_ILP_FLOAT = 1 };
+BenchKernelRunFn BenchIlpKernel(int type, int chains, int unroll);
+const int* BenchIlpUnrolls(int* count);      // unroll factors that are built
+
+// Math kernels: sin(x) * cos(x) + sqrt(x + 1) on BENCH_MATH_LANES independent
+// lanes (one op per lane per iteration, like the CPU kernel) through libm, a
+// polynomial sincos, or a cheaper approximation (shorter polynomials, one-part
+// range reduction, estimated square root). The polynomial ones use AVX2/FMA
+// where the CPU has it.
+#define BENCH_MATH_LANES 8
+enum BenchMathImpl { BENCH_MATH_LIBM = 0, BENCH_MATH_POLY = 1, BENCH_MATH_FAST = 2, BENCH_MATH_COUNT };
+
+// Largest error in ULP over evenly spaced points against long double libm
+// (as precise as double where long double is double, as on MSVC)
+struct BenchMathAccuracy {
+    double sinUlp;
+    double cosUlp;
+    double sqrtUlp;
+    double formulaUlp;         // for x >= 0, where the formula is well conditioned
+    int samples;
+    int referenceBits;         // mantissa bits of the reference
+};
+
+const char* BenchMathName(int impl);         // libm, poly, fast
+const char* BenchMathIsa(int impl);          // what it runs on here: avx2 or scalar
+BenchKernelRunFn BenchMathKernel(int impl);
+BenchMathAccuracy BenchMathMeasureAccuracy(int impl);
+
+// GEMM kernels: C = A * B on N x N FP64 or FP32 matrices, packed and blocked
+// for the caches around a register-blocked micro-kernel in the widest of
+// AVX-512, AVX2/FMA or plain C++ (BenchGemmIsa). One iteration is one panel of
+// BENCH_GEMM_PANEL rows of C, 2 * BENCH_GEMM_PANEL * N^2 flop; A and the packed
+// B are shared by all threads, each thread cycles through the panels on its own.
+#define BENCH_GEMM_PANEL 96
+#define BENCH_GEMM_SIZE_COUNT 4
+const int* BenchGemmSizes(int* count);       // the N that are built, smallest first
+int BenchGemmIsa();                          // avx512, avx2, or scalar for the portable kernel
+BenchKernelRunFn BenchGemmKernel(bool fp32, int size);  // NULL for a size that isn't built
+
+// STREAM kernels: Copy c = a, Scale b = q * c, Add c = a + b, Triad a = b + q * c
+// on double arrays of at least 4x the largest cache (all three together at most
+// half of memory), split between the run's threads. Each worker allocates and
+// initializes its own share, so first touch puts its pages on its own NUMA
+// node. One iteration is one 64-byte line of each array; BenchStreamBytesPerIter
+// counts bytes the STREAM way (no write-allocate traffic). Non-temporal
+// variants write around the caches (x86 only, NULL elsewhere).
+enum BenchStreamOp { BENCH_STREAM_COPY = 0, BENCH_STREAM_SCALE = 1, BENCH_STREAM_ADD = 2, BENCH_STREAM_TRIAD = 3, BENCH_STREAM_COUNT };
+const char* BenchStreamName(int op);         // copy, scale, add, triad
+double BenchStreamBytesPerIter(int op);
+int64_t BenchStreamArrayBytes(int threads);  // one array, all threads' shares together
+BenchKernelRunFn BenchStreamKernel(int op, bool nonTemporal);
+
+// Page sizes for the memory-access kernels' buffers
+enum BenchPageMode {
+    BENCH_PAGES_DEFAULT = 0,   // plain anonymous memory: whatever the system's THP setting makes of it
+    BENCH_PAGES_4K = 1,        // base pages, THP ruled out (MADV_NOHUGEPAGE)
+    BENCH_PAGES_THP = 2,       // 2 MiB aligned with THP asked for (MADV_HUGEPAGE)
+    BENCH_PAGES_2M = 3,        // reserved 2 MiB pages (MAP_HUGETLB; MEM_LARGE_PAGES on Windows)
+    BENCH_PAGES_1G = 4,        // reserved 1 GiB pages (MAP_HUGETLB)
+    BENCH_PAGES_COUNT
+};
+
+// A buffer from BenchAllocPages. When the requested page size isn't
+// available it is ordinary memory instead: mode says what it is, fallback why.
+struct BenchPages {
+    void* base = NULL;
+    size_t bytes = 0;          // mapped, rounded up to the page size
+    int mode = BENCH_PAGES_DEFAULT;
+    const char* fallback = NULL;
+};
+
+const char* BenchPageModeName(int mode);
+int BenchPageModeFromName(const char* name);  // -1 if unknown
+int BenchPageModeSelected();                  // BENCH_PAGES_ENV, else default
+BenchPages BenchAllocPages(size_t bytes, int mode);  // base is NULL only when out of memory
+void BenchFreePages(BenchPages* pages);
+int64_t BenchHugeBytes(const BenchPages& pages);     // bytes on huge pages now, -1 if unknown
+std::string BenchThpSetting();                // "always [madvise] never" from sysfs, "" where there is none
+
+// Pointer-chase kernels: one dependent load per iteration around a random
+// single cycle through every 64-byte line of a working set (Sattolo's
+// shuffle, so no stride for the prefetchers). Sizes go 4 KiB, 6 KiB, 8 KiB,
+// 12 KiB, ... up to 4 GiB, those within a quarter of memory are built; the
+// chain is shared by the run's threads and rebuilt when the size or the page
+// mode (BenchPageModeSelected) changes.
+#define BENCH_LATENCY_MAX_SIZES 41
+int BenchLatencySizeCount();                 // sizes built on this machine
+int64_t BenchLatencySize(int index);         // bytes
+void BenchLatencyName(int index, char* buf, size_t size);  // registry name: latency-4k, latency-1536m, latency-1g
+BenchKernelRunFn BenchLatencyKernel(int index);
+
+// Random-access kernel: one read-modify-write of a pseudo-random word of a
+// table per iteration, the updates independent of each other (GUPS). The
+// table is a power of two up to 1 GiB, within a quarter of memory; each
+// worker updates only its own slice of it, so no update is shared or lost.
+int64_t BenchRandomBytes();
+BenchKernelRunFn BenchRandomKernel();
+
+// The buffer the memory-access kernels built last: its page mode, fallback
+// reason and, through BenchHugeBytes, how much of it is on huge pages
+BenchPages BenchLastMemoryPages();
+
+// A chase through a caller's own buffer: BenchBuildChase lays the random
+// cycle over `bytes` at `base`, writing every line; BenchChase follows it for
+// `loads` loads from `p` and returns where it stopped
+void BenchBuildChase(void* base, int64_t bytes);
+void* BenchChase(void* p, int64_t loads);
+
+// NUMA nodes with the allowed processors of each and its memory (MemTotal;
+// available memory on Windows), in bytes. A machine without NUMA information
+// is one node 0 holding every allowed processor and all of memory.
+struct BenchNumaNode {
+    int id = 0;
+    std::vector<BenchPlacement> cpus;   // empty on a memory-only node
+    int64_t memory = 0;
+};
+std::vector<BenchNumaNode> BenchNumaNodes();
+
+// One column of the node-to-node matrix: a buffer placed on nodes[mem], then
+// a Triad bandwidth run with up to `threadsPerNode` threads (0 = all) and a
+// pointer chase on one thread, pinned to the processors of each node in turn.
+// The buffer is bound with mbind, or set_mempolicy, or placed by first touch
+// from a processor of the node when the kernel refuses both (no libnuma);
+// VirtualAllocExNuma on Windows.
+struct BenchNumaColumn {
+    const char* binding = NULL;        // how the buffer was placed, NULL if it couldn't be
+    double onNode = -1.0;              // share of sampled pages found on the node, -1 if unknown
+    std::vector<double> bandwidth;     // bytes/s (STREAM Triad counting) by CPU node, 0 = not run
+    std::vector<double> latencyNs;     // per load by CPU node, 0 = not run
+};
+int64_t BenchNumaBytes(const BenchNumaNode& node);  // buffer per memory node
+BenchNumaColumn BenchMeasureNumaColumn(const std::vector<BenchNumaNode>& nodes, int mem, int threadsPerNode, int durationMs);
+
+// Synchronization kernels, one operation per iteration on every worker:
+// an atomic add on the thread's own line (uncontended) or on one shared line,
+// a compare-exchange increment loop, a lock held around a one-counter
+// critical section (test-and-test-and-set spinlock, ticket lock, std::mutex,
+// std::shared_mutex with one write in 8), and a load/store of a per-thread
+// counter padded to its own cache line or packed eight to a line (false sharing)
+enum BenchSyncKind {
+    BENCH_SYNC_ATOMIC_LOCAL = 0,
+    BENCH_SYNC_ATOMIC = 1,
+    BENCH_SYNC_CAS = 2,
+    BENCH_SYNC_TTAS = 3,
+    BENCH_SYNC_TICKET = 4,
+    BENCH_SYNC_MUTEX = 5,
+    BENCH_SYNC_RWLOCK = 6,
+    BENCH_SYNC_PADDED = 7,
+    BENCH_SYNC_UNPADDED = 8,
+    BENCH_SYNC_COUNT
+};
+const char* BenchSyncName(int kind);         // registry suffix: sync-atomic, sync-ttas, ...
+const char* BenchSyncLabel(int kind);
+BenchKernelRunFn BenchSyncKernel(int kind);
+
+// Percentiles of a set of samples, in ns
+struct BenchDistribution {
+    int count = 0;
+    double min = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0, mean = 0.0;
+};
+BenchDistribution BenchDistributionOf(std::vector<double> ns);
+
+// OS primitive costs, one sample per round trip or timed batch, in ns.
+// Wake-up: threads pinned to `a` and `b` wake each other through a futex (an
+// auto-reset event on Windows) and sleep in between; a sample is half a
+// round trip. Context switch: two threads pinned to one processor yield to
+// each other; a sample is half a yield that ran the partner. Both return
+// false when the threads didn't land where they were pinned.
+bool BenchWakeLatency(const BenchPlacement& a, const BenchPlacement& b, std::vector<double>* ns);
+bool BenchSwitchCost(const BenchPlacement& cpu, std::vector<double>* ns);
+const char* BenchSyscallName();              // the null system call timed
+void BenchSyscallCost(std::vector<double>* ns);
+int BenchClockCount();                       // clocks on this platform: steady_clock, clock_gettime / QPC, rdtsc ...
+const char* BenchClockName(int clock);
+void BenchClockCost(int clock, std::vector<double>* ns);
+
+// Allocator kernels, one allocation and one free per iteration. "system" is
+// malloc/free; "pool" is a thread-caching arena built in: per-thread free
+// lists by size class carved from large chunks, with a block freed by another
+// thread handed back to its owner through a lock-free list. Patterns: churn
+// (each thread frees its own blocks, a few hundred kept live, mixed sizes),
+// xthread (each thread passes its blocks to the next worker, which frees
+// them: producer-consumer) and size-<N> (churn at one size, for the sweep).
+enum BenchAllocator {
+    BENCH_ALLOC_SYSTEM = 0,
+    BENCH_ALLOC_POOL = 1,
+    BENCH_ALLOC_COUNT
+};
+// The build picks the default (cmake -DBENCH_ALLOCATOR=pool); BENCH_ALLOC_ENV overrides it
+#ifndef BENCH_ALLOC_DEFAULT
+#define BENCH_ALLOC_DEFAULT BENCH_ALLOC_SYSTEM
+#endif
+
+enum BenchAllocPattern {
+    BENCH_ALLOC_CHURN = 0,
+    BENCH_ALLOC_XTHREAD = 1,
+    BENCH_ALLOC_PATTERNS
+};
+
+const char* BenchAllocatorName(int allocator);
+int BenchAllocatorFromName(const char* name);  // -1 if unknown
+int BenchAllocatorSelected();                  // BENCH_ALLOC_ENV, else BENCH_ALLOC_DEFAULT
+const char* BenchAllocPatternName(int pattern);
+const int* BenchAllocSizes(int* count);        // the size sweep, 16 B ... 256 KiB
+BenchKernelRunFn BenchAllocKernel(int allocator, int pattern);
+BenchKernelRunFn BenchAllocSizeKernel(int allocator, int size);  // NULL unless one of BenchAllocSizes
+// Free the blocks xthread runs left in flight between workers; the mailboxes
+// outlive a run, and a later run with fewer threads never reads the higher
+// ones. Only while no run is active.
+void BenchAllocDrain();
+// Peak resident set of the process (VmHWM; PeakWorkingSetSize on Windows),
+// -1 if unknown. The reset (clear_refs) needs Linux 4.0+; without it the
+// peak covers the whole process lifetime.
+int64_t BenchPeakRss();
+bool BenchResetPeakRss();
+
+// Core-to-core latency: two threads pinned to a pair of processors bounce
+// one cache line, each storing the next count once it sees the other's, so a
+// round trip is two ownership transfers. Every pair of allowed processors is
+// measured once (the matrix is symmetric) and classed by what the two share.
+enum BenchC2cClass {
+    BENCH_C2C_SMT = 0,         // siblings of one physical core
+    BENCH_C2C_LLC = 1,         // cores sharing the last-level cache (intra-CCX)
+    BENCH_C2C_CROSS_LLC = 2,   // one package, different last-level caches (cross-CCX / CCD)
+    BENCH_C2C_CROSS_PACKAGE = 3,
+    BENCH_C2C_CLASSES
+};
+
+struct BenchC2cMatrix {
+    std::vector<BenchPlacement> cpus;  // rows and columns: BenchGetTopology().allowed
+    std::vector<int> llc;              // BenchLlcDomains of each
+    std::vector<double> ns;            // round trip, [a * cpus + b]; 0 on the diagonal
+    double median[BENCH_C2C_CLASSES] = {};  // over the pairs of each class, 0 if none
+    int pairs[BENCH_C2C_CLASSES] = {};
+};
+
+const char* BenchC2cClassName(int cls);
+int BenchC2cClassOf(const BenchC2cMatrix& m, int a, int b);
+double BenchC2cRoundTripNs(const BenchPlacement& a, const BenchPlacement& b);  // median of timed batches
+BenchC2cMatrix BenchMeasureC2c();      // no pairs below two allowed processors
+
+// Per-thread spread and stragglers, peers grouped by efficiency class if `byClass`
+BenchThreadSpread BenchAnalyzeSpread(const std::vector<BenchThreadResult>& threads, bool byClass);
+
+// Pinned-run subtotals of per-thread rates by efficiency class, fastest class first
+std::vector<BenchClassScore> BenchClassScores(const std::vector<BenchThreadResult>& threads);
+
+// 95 % confidence interval over per-batch rates
+BenchRateStats BenchComputeRateStats(const double* rates, int count);
+
+// Peak / sustained / drop analysis of a rate series, both from the smoothed
+// rates after the warm-up samples (at least the first, which holds start-up)
+BenchThrottleSummary BenchAnalyzeThrottling(const double* rates, int count, int warmupSamples);
+
+// Asynchronous run: start, poll, collect. Only one run may be active at a time.
+// Runs execute on a persistent pool that is created on first use and reused.
+bool BenchStart(const BenchConfig& cfg);
+bool BenchIsDone();
+int64_t BenchCancel();  // returns the measured cancel latency in ns
+BenchProgress BenchGetProgress();
+BenchResult BenchGetResult();  // joins the run; valid once BenchIsDone() is true
+const char* BenchRunError();   // "" unless a kernel failed the last run
+
+// Called by a kernel that cannot go on (its buffer could not be allocated):
+// stops the run, which then ends without `completed`. `why` must outlive the
+// run (a string literal); the first failure is kept.
+void BenchFailRun(const char* why);
+
+// Synchronous run for headless use
+BenchResult BenchRun(const BenchConfig& cfg);
+
+// Pool bookkeeping: threads created so far, cancel latency, and teardown
+// (registered with atexit, safe to call more than once)
+int BenchPoolSize();
+BenchCancelStats BenchGetCancelStats();
+void BenchShutdown();
@@ -0,0 +1,406 @@
+// Allocator kernels: malloc/free against a thread-caching pool, with blocks
+// freed by the thread that took them (churn, one size or a mix) or passed to
+// the next worker and freed there (producer-consumer), plus the process's
+// peak resident set so a faster allocator can't hide what it holds on to
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+#include "bench.h"
+
+// Blocks each thread keeps live in churn, fewer for the big sizes so a thread
+// holds at most ALLOC_LIVE_BYTES of them
+#define ALLOC_LIVE 256
+#define ALLOC_LIVE_BYTES ((size_t)4 << 20)
+
+// Blocks in flight from one worker to the next; a full mailbox means the
+// consumer is behind, and the producer frees the block itself
+#define ALLOC_MAILBOX 256
+
+#define ALLOC_PAGE 4096
+
+// Pool chunks come from malloc and are never given back: blocks are carved
+// from the current chunk until it runs out. Sizes above the largest class go
+// straight to malloc.
+#define POOL_CHUNK ((size_t)1 << 20)
+#define POOL_HEADER 16
+#define POOL_CLASSES 24
+#define POOL_SMALL 1024
+
+static const char* kAllocatorNames[BENCH_ALLOC_COUNT] = { "system", "pool" };
+static const char* kPatternNames[BENCH_ALLOC_PATTERNS] = { "churn", "xthread" };
+
+static const int kSizes[] = { 16, 64, 256, 1024, 4096, 16384, 65536, 262144 };
+#define ALLOC_SIZE_COUNT ((int)(sizeof(kSizes) / sizeof(kSizes[0])))
+
+// Half steps between powers of two keep the waste under a third
+static const uint32_t kClassSize[POOL_CLASSES] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024,
+    1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768, 49152, 65536,
+};
+
+// ---- the pool ----
+
+struct PoolHeap;
+
+// In front of every block; `next` overlaps the caller's first bytes and is
+// only used while the block is free
+struct PoolBlock {
+    PoolHeap* owner;           // NULL: a large block straight from malloc
+    uint32_t cls;
+    uint32_t unused;
+    PoolBlock* next;
+};
+
+// One per thread. Only the owner touches the free lists; other threads push
+// what they free onto `remote`, which the owner takes whole when a list runs dry.
+struct PoolHeap {
+    PoolBlock* free[POOL_CLASSES] = {};
+    char* bump = NULL;
+    char* end = NULL;
+    alignas(64) std::atomic<PoolBlock*> remote{NULL};
+};
+
+// Class of each 16-byte step up to POOL_SMALL, so small sizes skip the search
+struct SmallClasses {
+    uint8_t cls[POOL_SMALL / 16 + 1];
+    SmallClasses() {
+        int c = 0;
+        for (int i = 0; i <= POOL_SMALL / 16; i++) {
+            while (kClassSize[c] < (uint32_t)i * 16) c++;
+            cls[i] = (uint8_t)c;
+        }
+    }
+};
+static const SmallClasses g_small;
+
+static int ClassOf(size_t n) {
+    if (n <= POOL_SMALL) return g_small.cls[(n + 15) / 16];
+    return (int)(std::lower_bound(kClassSize, kClassSize + POOL_CLASSES, (uint32_t)n) - kClassSize);
+}
+
+// A heap outlives its thread: blocks it handed out may still be live. Blocks
+// freed to the heap of a thread that has exited are never reused.
+static thread_local PoolHeap* t_heap = NULL;
+
+static PoolHeap* ThisHeap() {
+    if (!t_heap) t_heap = new PoolHeap;
+    return t_heap;
+}
+
+static void DrainRemote(PoolHeap* h) {
+    PoolBlock* b = h->remote.exchange(NULL, std::memory_order_acquire);
+    while (b) {
+        PoolBlock* next = b->next;
+        b->next = h->free[b->cls];
+        h->free[b->cls] = b;
+        b = next;
+    }
+}
+
+static PoolBlock* Carve(PoolHeap* h, int cls) {
+    size_t bytes = kClassSize[cls] + POOL_HEADER;
+    if ((size_t)(h->end - h->bump) < bytes) {
+        char* chunk = (char*)malloc(POOL_CHUNK);
+        if (!chunk) return NULL;
+        h->bump = chunk;
+        h->end = chunk + POOL_CHUNK;
+    }
+    PoolBlock* b = (PoolBlock*)h->bump;
+    h->bump += bytes;
+    b->owner = h;
+    b->cls = (uint32_t)cls;
+    return b;
+}
+
+static void* PoolAlloc(size_t n) {
+    PoolBlock* b;
+    if (n > kClassSize[POOL_CLASSES - 1]) {
+        b = (PoolBlock*)malloc(n + POOL_HEADER);
+        if (!b) return NULL;
+        b->owner = NULL;
+        return (char*)b + POOL_HEADER;
+    }
+    int cls = ClassOf(n);
+    PoolHeap* h = ThisHeap();
+    if (!h->free[cls]) DrainRemote(h);
+    b = h->free[cls];
+    if (b) h->free[cls] = b->next;
+    else b = Carve(h, cls);
+    return b ? (char*)b + POOL_HEADER : NULL;
+}
+
+static void PoolFree(void* p) {
+    if (!p) return;
+    PoolBlock* b = (PoolBlock*)((char*)p - POOL_HEADER);
+    PoolHeap* owner = b->owner;
+    if (!owner) {
+        free(b);
+    } else if (owner == t_heap) {
+        b->next = owner->free[b->cls];
+        owner->free[b->cls] = b;
+    } else {
+        // The owner takes the whole list at once, so a plain push is ABA-free
+        PoolBlock* head = owner->remote.load(std::memory_order_relaxed);
+        do {
+            b->next = head;
+        } while (!owner->remote.compare_exchange_weak(head, b, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+template <int Allocator>
+static void* Get(size_t n) {
+    return Allocator == BENCH_ALLOC_POOL ? PoolAlloc(n) : malloc(n);
+}
+
+template <int Allocator>
+static void Put(void* p) {
+    if (Allocator == BENCH_ALLOC_POOL) PoolFree(p);
+    else free(p);
+}
+
+// ---- the kernels ----
+
+// A byte per page, as a caller would write it, so the pages are really
+// there (and count in the resident set)
+static uint64_t Touch(void* p, size_t n, int64_t i) {
+    if (!p) return 0;
+    char* c = (char*)p;
+    for (size_t off = 0; off < n; off += ALLOC_PAGE) c[off] = (char)i;
+    return (uint8_t)c[0];
+}
+
+static uint32_t NextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Mostly small objects, some buffers, the odd large one: 90% 16-512 B,
+// 9% up to 8 KiB, 1% up to 64 KiB
+static size_t MixedSize(uint32_t* state) {
+    uint32_t r = NextRandom(state);
+    uint32_t pick = r % 100, span = r >> 8;
+    if (pick < 90) return 16 + span % (512 - 16 + 1);
+    if (pick < 99) return 512 + span % (8192 - 512 + 1);
+    return 8192 + span % (65536 - 8192 + 1);
+}
+
+// A thread's live blocks and size stream for one allocator. Switching to
+// another size frees them all, so a pool thread never holds more than one
+// kernel's worth.
+struct LiveRing {
+    void* blocks[ALLOC_LIVE];
+    int count;
+    int pos;
+    int size;                  // of the kernel that filled it, 0 = mixed
+    uint32_t random;
+};
+
+template <int Allocator>
+static LiveRing& Ring(int size) {
+    static thread_local LiveRing ring = {};
+    if (ring.random == 0) ring.random = 0x9e3779b9u ^ (uint32_t)(uintptr_t)&ring;
+    if (ring.count == 0 || ring.size != size) {
+        for (int i = 0; i < ring.count; i++) Put<Allocator>(ring.blocks[i]);
+        size_t fit = size > 0 ? ALLOC_LIVE_BYTES / size : ALLOC_LIVE;
+        ring.count = fit < 1 ? 1 : fit > ALLOC_LIVE ? ALLOC_LIVE : (int)fit;
+        memset(ring.blocks, 0, sizeof(ring.blocks));
+        ring.pos = 0;
+        ring.size = size;
+    }
+    return ring;
+}
+
+// Each iteration frees the oldest live block and takes a new one in its place
+template <int Allocator, int Size>
+static double ChurnRun(double seed, int64_t iters) {
+    LiveRing& ring = Ring<Allocator>(Size);
+    uint64_t x = 0;
+    for (int64_t i = 0; i < iters; i++) {
+        size_t n = Size > 0 ? (size_t)Size : MixedSize(&ring.random);
+        void*& slot = ring.blocks[ring.pos];
+        Put<Allocator>(slot);
+        slot = Get<Allocator>(n);
+        x += Touch(slot, n, i);
+        if (++ring.pos == ring.count) ring.pos = 0;
+    }
+    return seed + (double)(x & 0xff);
+}
+
+// Single producer (the previous worker), single consumer (this one)
+struct alignas(64) Mailbox {
+    std::atomic<uint32_t> head;               // consumer's
+    alignas(64) std::atomic<uint32_t> tail;   // producer's
+    void* slots[ALLOC_MAILBOX];
+};
+
+// Kept between runs, so blocks still in flight when a run stops stay here
+// until BenchAllocDrain
+template <int Allocator>
+static Mailbox* Mailboxes() {
+    static Mailbox boxes[BENCH_MAX_THREADS];
+    return boxes;
+}
+
+template <int Allocator>
+static void DrainMailboxes() {
+    Mailbox* boxes = Mailboxes<Allocator>();
+    for (int i = 0; i < BENCH_MAX_THREADS; i++) {
+        Mailbox& box = boxes[i];
+        uint32_t tail = box.tail.load(std::memory_order_acquire);
+        for (uint32_t head = box.head.load(std::memory_order_relaxed); head != tail; head++) {
+            Put<Allocator>(box.slots[head % ALLOC_MAILBOX]);
+        }
+        box.head.store(0, std::memory_order_relaxed);
+        box.tail.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Each iteration frees a block the previous worker made, if one is waiting,
+// and passes a new one to the next worker: worker k feeds k + 1, the last
+// feeds the first. On one thread the ring closes on itself.
+template <int Allocator>
+static double CrossThreadRun(double seed, int64_t iters) {
+    int threads = BenchRunThreads();
+    int me = BenchRunWorker() % threads;
+    Mailbox* boxes = Mailboxes<Allocator>();
+    Mailbox& in = boxes[me];
+    Mailbox& out = boxes[(me + 1) % threads];
+    uint32_t& random = Ring<Allocator>(0).random;
+    uint64_t x = 0;
+    for (int64_t i = 0; i < iters; i++) {
+        uint32_t head = in.head.load(std::memory_order_relaxed);
+        if (head != in.tail.load(std::memory_order_acquire)) {
+            void* p = in.slots[head % ALLOC_MAILBOX];
+            in.head.store(head + 1, std::memory_order_release);
+            Put<Allocator>(p);
+        }
+        size_t n = MixedSize(&random);
+        void* p = Get<Allocator>(n);
+        x += Touch(p, n, i);
+        uint32_t tail = out.tail.load(std::memory_order_relaxed);
+        if (tail - out.head.load(std::memory_order_acquire) < ALLOC_MAILBOX) {
+            out.slots[tail % ALLOC_MAILBOX] = p;
+            out.tail.store(tail + 1, std::memory_order_release);
+        } else {
+            Put<Allocator>(p);
+        }
+    }
+    return seed + (double)(x & 0xff);
+}
+
+void BenchAllocDrain() {
+    DrainMailboxes<BENCH_ALLOC_SYSTEM>();
+    DrainMailboxes<BENCH_ALLOC_POOL>();
+}
+
+const char* BenchAllocatorName(int allocator) {
+    return allocator >= 0 && allocator < BENCH_ALLOC_COUNT ? kAllocatorNames[allocator] : "";
+}
+
+int BenchAllocatorFromName(const char* name) {
+    for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+        if (strcmp(name, kAllocatorNames[a]) == 0) return a;
+    }
+    return -1;
+}
+
+int BenchAllocatorSelected() {
+    const char* forced = getenv(BENCH_ALLOC_ENV);
+    int allocator = forced ? BenchAllocatorFromName(forced) : -1;
+    return allocator >= 0 ? allocator : BENCH_ALLOC_DEFAULT;
+}
+
+const char* BenchAllocPatternName(int pattern) {
+    return pattern >= 0 && pattern < BENCH_ALLOC_PATTERNS ? kPatternNames[pattern] : "";
+}
+
+const int* BenchAllocSizes(int* count) {
+    *count = ALLOC_SIZE_COUNT;
+    return kSizes;
+}
+
+BenchKernelRunFn BenchAllocKernel(int allocator, int pattern) {
+    static const BenchKernelRunFn kernels[BENCH_ALLOC_COUNT][BENCH_ALLOC_PATTERNS] = {
+        { ChurnRun<BENCH_ALLOC_SYSTEM, 0>, CrossThreadRun<BENCH_ALLOC_SYSTEM> },
+        { ChurnRun<BENCH_ALLOC_POOL, 0>, CrossThreadRun<BENCH_ALLOC_POOL> },
+    };
+    if (allocator < 0 || allocator >= BENCH_ALLOC_COUNT || pattern < 0 || pattern >= BENCH_ALLOC_PATTERNS) return NULL;
+    return kernels[allocator][pattern];
+}
+
+template <int Allocator>
+static BenchKernelRunFn SizeKernel(int size) {
+    switch (size) {
+    case 16: return ChurnRun<Allocator, 16>;
+    case 64: return ChurnRun<Allocator, 64>;
+    case 256: return ChurnRun<Allocator, 256>;
+    case 1024: return ChurnRun<Allocator, 1024>;
+    case 4096: return ChurnRun<Allocator, 4096>;
+    case 16384: return ChurnRun<Allocator, 16384>;
+    case 65536: return ChurnRun<Allocator, 65536>;
+    case 262144: return ChurnRun<Allocator, 262144>;
+    default: return NULL;
+    }
+}
+
+BenchKernelRunFn BenchAllocSizeKernel(int allocator, int size) {
+    if (allocator == BENCH_ALLOC_SYSTEM) return SizeKernel<BENCH_ALLOC_SYSTEM>(size);
+    if (allocator == BENCH_ALLOC_POOL) return SizeKernel<BENCH_ALLOC_POOL>(size);
+    return NULL;
+}
+
+// ---- resident set ----
+
+#ifdef _WIN32
+
+int64_t BenchPeakRss() {
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return -1;
+    return (int64_t)pmc.PeakWorkingSetSize;
+}
+
+// Windows keeps the peak for the life of the process
+bool BenchResetPeakRss() {
+    return false;
+}
+
+#else
+
+int64_t BenchPeakRss() {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    int64_t peak = -1;
+    char line[256];
+    long kb;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+            peak = (int64_t)kb << 10;
+            break;
+        }
+    }
+    fclose(f);
+    return peak;
+}
+
+// "5" resets the high-water mark to the current resident set
+bool BenchResetPeakRss() {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return false;
+    bool ok = fputs("5", f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+
+#endif
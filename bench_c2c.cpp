@@ -0,0 +1,114 @@
+// Core-to-core latency: the cost of moving one cache line between two
+// processors, for every pair, which shows where the SMT, last-level cache
+// (CCX / CCD) and socket boundaries are
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+// Round trips per timed batch, batches per pair (the median is kept), and
+// untimed round trips that settle both threads on their processors first
+#define C2C_ROUNDS 2000
+#define C2C_BATCHES 7
+#define C2C_WARMUP 500
+
+// Spins before yielding: only reached when the partner isn't running (both
+// threads on one processor, or a CPU quota)
+#define C2C_SPIN_LIMIT (1 << 16)
+
+static const char* kClassNames[BENCH_C2C_CLASSES] = { "SMT siblings", "same LLC", "cross LLC", "cross socket" };
+
+// The bounced line, alone in its cache line so nothing else rides along
+struct alignas(64) PingLine {
+    std::atomic<int64_t> value;
+};
+
+// No pause instruction: it would add its own latency to every hand-over
+static void WaitFor(const std::atomic<int64_t>& v, int64_t want) {
+    int spins = 0;
+    while (v.load(std::memory_order_acquire) != want) {
+        if (++spins == C2C_SPIN_LIMIT) {
+            spins = 0;
+            std::this_thread::yield();
+        }
+    }
+}
+
+const char* BenchC2cClassName(int cls) {
+    return cls >= 0 && cls < BENCH_C2C_CLASSES ? kClassNames[cls] : "";
+}
+
+// Without a known cache domain, cores of one package count as sharing it
+int BenchC2cClassOf(const BenchC2cMatrix& m, int a, int b) {
+    const BenchPlacement& pa = m.cpus[a];
+    const BenchPlacement& pb = m.cpus[b];
+    if (pa.package != pb.package) return BENCH_C2C_CROSS_PACKAGE;
+    if (pa.core == pb.core) return BENCH_C2C_SMT;
+    if (m.llc[a] >= 0 && m.llc[b] >= 0 && m.llc[a] != m.llc[b]) return BENCH_C2C_CROSS_LLC;
+    return BENCH_C2C_LLC;
+}
+
+// `a` starts each round trip with an odd count and waits for `b` to answer
+// with the next even one
+double BenchC2cRoundTripNs(const BenchPlacement& a, const BenchPlacement& b) {
+    PingLine* line = new PingLine;
+    line->value.store(0);
+    std::vector<double> batches;
+    std::thread pong([&] {
+        BenchApplyPlacement(b, true);
+        const int64_t total = C2C_WARMUP + (int64_t)C2C_BATCHES * C2C_ROUNDS;
+        for (int64_t i = 0; i < total; i++) {
+            WaitFor(line->value, 2 * i + 1);
+            line->value.store(2 * i + 2, std::memory_order_release);
+        }
+    });
+    std::thread ping([&] {
+        BenchApplyPlacement(a, true);
+        int64_t count = 0;
+        for (int i = 0; i < C2C_WARMUP; i++, count += 2) {
+            line->value.store(count + 1, std::memory_order_release);
+            WaitFor(line->value, count + 2);
+        }
+        for (int k = 0; k < C2C_BATCHES; k++) {
+            int64_t t0 = BenchNowNs();
+            for (int i = 0; i < C2C_ROUNDS; i++, count += 2) {
+                line->value.store(count + 1, std::memory_order_release);
+                WaitFor(line->value, count + 2);
+            }
+            batches.push_back((double)(BenchNowNs() - t0) / C2C_ROUNDS);
+        }
+    });
+    ping.join();
+    pong.join();
+    delete line;
+    std::sort(batches.begin(), batches.end());
+    return batches[batches.size() / 2];
+}
+
+BenchC2cMatrix BenchMeasureC2c() {
+    BenchC2cMatrix m;
+    BenchTopology topo = BenchGetTopology();
+    m.cpus = topo.allowed;
+    m.llc = BenchLlcDomains(topo);
+    int n = (int)m.cpus.size();
+    m.ns.assign((size_t)n * n, 0.0);
+    std::vector<double> byClass[BENCH_C2C_CLASSES];
+    for (int a = 0; a < n; a++) {
+        for (int b = a + 1; b < n; b++) {
+            double ns = BenchC2cRoundTripNs(m.cpus[a], m.cpus[b]);
+            m.ns[(size_t)a * n + b] = m.ns[(size_t)b * n + a] = ns;
+            byClass[BenchC2cClassOf(m, a, b)].push_back(ns);
+        }
+    }
+    for (int c = 0; c < BENCH_C2C_CLASSES; c++) {
+        std::vector<double>& v = byClass[c];
+        m.pairs[c] = (int)v.size();
+        if (v.empty()) continue;
+        std::sort(v.begin(), v.end());
+        m.median[c] = v[v.size() / 2];
+    }
+    return m;
+}
@@ -0,0 +1,1753 @@
+// Headless benchmark runner (ReactionTimeBench). Same kernels and timing as the GUI.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bench_host.h"
+
+// Ops between clock checks in the old worker loop
+#define LEGACY_CHUNK_OPS 0x10000
+
+// Clock probe per ISA in the --simd comparison
+#define SIMD_CLOCK_MS 300
+
+// --ilp windows per chain count unless --duration is given
+#define ILP_STEP_MS 1000
+#define ILP_WARMUP_MS 200
+
+// A chain count is saturated once it reaches this share of the best rate
+#define ILP_SATURATION 0.95
+
+// --gemm windows per size unless --duration is given; the warm-up covers
+// building the shared matrices
+#define GEMM_STEP_MS 1000
+#define GEMM_WARMUP_MS 300
+
+// --latency windows per working-set size unless --duration is given, and the
+// width of the plotted bars
+#define LATENCY_STEP_MS 300
+#define LATENCY_WARMUP_MS 200
+#define LATENCY_BAR_WIDTH 50
+
+// --hugepages windows per kernel and page mode; the warm-up covers building
+// the working set
+#define PAGES_STEP_MS 500
+#define PAGES_WARMUP_MS 300
+
+// --stream windows per kernel unless --duration is given; the first run at
+// a thread count also allocates and first-touches the arrays in its warm-up
+#define STREAM_STEP_MS 1000
+#define STREAM_WARMUP_MS 1000
+
+// --numa window per cell and kernel unless --duration is given
+#define NUMA_STEP_MS 500
+
+// --sync windows per kernel and thread count unless --duration is given
+#define SYNC_STEP_MS 300
+#define SYNC_WARMUP_MS 100
+
+// --malloc windows per cell unless --duration is given
+#define MALLOC_STEP_MS 300
+#define MALLOC_WARMUP_MS 100
+
+// --slow-thread check: runs cancelled part-way into the measurement
+#define SLOW_CANCELS 5
+
+// Options
+static const char* g_kernelName = NULL;   // --type; default cpu, or multicore with multicore options
+static bool g_listKernels = false;
+static char g_rate[48] = "Mops/s";        // score unit of the selected kernel
+static bool g_multicore = false;
+static int g_threads = 0;           // 0 = all logical CPUs
+static int g_repeat = 1;
+static bool g_compareLegacy = false;
+static const char* g_seriesPath = NULL;   // write the time series as CSV
+static const char* g_analyzePath = NULL;  // analyze a recorded CSV instead of running
+static int g_stressCycles = 0;            // start/cancel race test instead of a run
+static bool g_showTopology = false;
+static const char* g_coresPath = NULL;    // write the pinned per-core table (or the --c2c matrix) as CSV
+static const char* g_curvePath = NULL;    // write the scaling (or --latency) curve as CSV
+static bool g_useHost = false;            // run in a child process (--bench-host)
+static bool g_processes = false;          // one worker process per thread, compared with threads
+static bool g_simdCompare = false;        // every supported ISA, with clocks and speedup
+static bool g_mathCompare = false;        // libm vs polynomial vs approximate math, with ULP errors
+static bool g_ilpSweep = false;           // ILP family over 1..BENCH_ILP_MAX_CHAINS chains
+static int g_ilpUnroll = 4;
+static bool g_osCosts = false;            // wake-up, context switch, syscall and clock-read distributions
+static bool g_syncTable = false;          // synchronization kernels over thread counts, with fairness
+static bool g_mallocTable = false;        // allocator patterns and sizes over thread counts, with peak RSS
+static bool g_c2cMatrix = false;          // cache-line round trip between every pair of processors
+static const char* g_historyPath = NULL;  // append each result in the GUI's history format
+static bool g_numaMatrix = false;         // bandwidth and latency for every CPU node / memory node pair
+static bool g_pagesCompare = false;       // chase and random access on every page mode
+static bool g_latencySweep = false;       // pointer chase over working-set sizes
+static bool g_streamTable = false;        // STREAM kernels on one and all threads, with and without NT stores
+static bool g_gemmSweep = false;          // GEMM sizes in FP64 and FP32, one and all threads, against peak
+static bool g_durationSet = false;        // --duration given
+static BenchConfig g_config;
+
+static void PrintUsage() {
+    printf("Usage: ReactionTimeBench [options]\n");
+    printf("  --type NAME            kernel to run (default cpu):");
+    for (const BenchKernel& k : BenchKernels()) {
+        if (k.threadModel != BENCH_KERNEL_EXTERNAL && !k.variant) printf(" %s", k.name.c_str());
+    }
+    printf("\n                         (see --list-kernels for all variants)\n");
+    printf("  --plugin PATH          load kernels from a plugin library, or every one in a directory\n");
+    printf("  --list-kernels         list the registered kernels and any plugin errors, then exit\n");
+    printf("  --isa NAME             run the simd kernel as scalar | sse2 | avx2 | avx512 (default: widest supported)\n");
+    printf("  --simd                 compare the simd kernel under every supported ISA: rate, clock, speedup\n");
+    printf("  --math                 sin*cos+sqrt through libm, a polynomial and an approximation: rate and ULP error\n");
+    printf("  --ilp                  sweep 1..%d independent float and double chains: latency, peak, saturation\n", BENCH_ILP_MAX_CHAINS);
+    printf("  --pages MODE           page size of the latency and random kernels: default | 4k | thp | 2m | 1g\n");
+    printf("  --hugepages            latency and random access on base, transparent and reserved huge pages\n");
+    printf("  --latency              pointer-chase load latency from 4 KiB to GiB working sets, with the cache sizes marked\n");
+    printf("  --stream               STREAM copy/scale/add/triad on one and all threads, normal and non-temporal stores: GB/s\n");
+    printf("  --gemm                 cache-blocked SIMD GEMM over sizes, FP64 and FP32, one and all threads: GFLOPS, %% of peak\n");
+    printf("  --os                   wake-up (same/cross core), context switch, null syscall and clock-read costs: percentiles\n");
+    printf("  --sync                 atomics, CAS, spinlocks, mutex, rwlock, padded/unpadded counters at 1..N threads\n");
+    printf("  --alloc NAME           allocator of the alloc-churn and alloc-xthread kernels: system | pool (default: %s)\n",
+        BenchAllocatorName(BENCH_ALLOC_DEFAULT));
+    printf("  --malloc               system vs pool allocator: churn, cross-thread frees, size sweep at 1..N threads, peak RSS\n");
+    printf("  --c2c                  core-to-core cache-line round trip for every pair of CPUs, as a heatmap\n");
+    printf("  --numa                 Triad bandwidth and chase latency with threads on NUMA node i, memory on node j\n");
+    printf("  --unroll N             unroll factor of the --ilp kernels (default 4):");
+    int unrollCount;
+    const int* unrolls = BenchIlpUnrolls(&unrollCount);
+    for (int i = 0; i < unrollCount; i++) printf(" %d", unrolls[i]);
+    printf("\n");
+    printf("  --threads N            worker threads for multicore (default: usable CPUs, up to %d)\n", BENCH_MAX_THREADS);
+    printf("  --group-size N         simulate processor groups of N CPUs (placement is not applied)\n");
+    printf("  --topology             print processor groups and the placement plan, then exit\n");
+    printf("  --pin                  pin each worker to one logical CPU and report per-core scores\n");
+    printf("  --cores FILE           write the per-core table of a pinned run (or the --c2c matrix) as CSV\n");
+    printf("  --smt MODE             physical | all | pairs: pinned SMT placement with yield report\n");
+    printf("  --scaling pow2|every   sweep 1, 2, 4 ... --threads (or every count) with an Amdahl/USL fit\n");
+    printf("  --curve FILE           write the scaling curve (or the --latency curve) as CSV\n");
+    printf("  --simulate-smt N       simulate N siblings per core (placement is not applied)\n");
+    printf("  --slow-thread N[:PCT]  check: worker N idles PCT%% of its time (default 50); it must be flagged as a\n"
+           "                         straggler and cancels must stay within %d ms; OK / FAILED, exit code 1 on failure\n",
+           BENCH_CANCEL_BOUND_MS);
+    printf("  --duration MS          measurement window (default %d)\n", g_config.durationMs);
+    printf("  --warmup MS            warm-up excluded from the score (default %d)\n", g_config.warmupMs);
+    printf("  --adaptive             stop once the 95%% CI is within --target\n");
+    printf("  --target PCT           adaptive precision target, +-percent (default %.1f)\n", g_config.targetPrecision * 100.0);
+    printf("  --min MS / --max MS    adaptive duration bounds (default %d / %d)\n", g_config.minDurationMs, g_config.maxDurationMs);
+    printf("  --processes            multicore with one worker process per thread, next to the threaded score\n");
+    printf("  --host                 run each benchmark in a child process, isolated from this one\n");
+    printf("  --repeat N             run N times and report the spread\n");
+    printf("  --compare-legacy       also run the old fixed-denominator timing model; with --repeat N, exit 1 unless\n"
+           "                         the new model's run-to-run CV is lower\n");
+    printf("  --history FILE         append each result to FILE in the GUI's history format\n");
+    printf("  --series FILE          write the per-interval throughput series as CSV\n");
+    printf("  --analyze FILE         run the throttling analysis on a CSV written by --series\n");
+    printf("  --stress N             N randomized start/cancel/finish cycles on the worker pool (with --host: on child processes)\n");
+}
+
+// Every processor the process may use, in every group
+static int DefaultThreadCount() {
+    int n = BenchGetTopology().effectiveCount;
+    if (n > BENCH_MAX_THREADS) n = BENCH_MAX_THREADS;
+    return n;
+}
+
+// Effective vs machine processor counts and what limits them
+static void PrintCpuCounts(const BenchTopology& topo) {
+    printf("%d usable of %d logical processors, %d cores (affinity %d",
+        topo.effectiveCount, topo.logicalCount, topo.coreCount, (int)topo.allowed.size());
+    if (topo.cpuQuota > 0.0) printf(", quota %.2f CPUs", topo.cpuQuota);
+    printf(")");
+    if (topo.classCount > 1) printf(", %d efficiency classes", topo.classCount);
+    printf("\n");
+}
+
+static int PrintTopology(int threadCount) {
+    PrintCpuCounts(BenchGetTopology());
+    BenchTopology topo = BenchTopologyFor(g_config);
+    std::vector<BenchPlacement> plan = BenchPlanPlacement(topo, threadCount);
+    printf("%d logical processors, %d cores in %d group(s)%s\n", topo.logicalCount, topo.coreCount,
+        (int)topo.groupSizes.size(), topo.simulated ? " (simulated)" : "");
+    for (size_t g = 0; g < topo.groupSizes.size(); g++) {
+        int placed = 0;
+        for (const BenchPlacement& p : plan) {
+            if (p.group == (int)g) placed++;
+        }
+        printf("  group %d: %d processors, %d of %d threads\n", (int)g, topo.groupSizes[g], placed, threadCount);
+    }
+    return (int)plan.size() == threadCount ? 0 : 1;
+}
+
+// Per-core table and efficiency-class subtotals of a pinned run
+static void PrintCores(const BenchResult& res, int classCount) {
+    if (!res.pinned) return;
+    printf("        %-6s %-6s %-5s %-7s %s\n", "cpu", "core", "pkg", "class", g_rate);
+    for (const BenchThreadResult& t : res.threads) {
+        const BenchPlacement& p = t.placement;
+        char cpu[16];
+        if (res.groupCount > 1) snprintf(cpu, sizeof(cpu), "%d:%d", p.group, p.cpu);
+        else snprintf(cpu, sizeof(cpu), "%d", p.cpu);
+        printf("        %-6s %-6d %-5d %-2d %-4s %.3f\n", cpu, p.core, p.package, p.efficiencyClass,
+            BenchClassLabel(p.efficiencyClass, classCount), t.opsPerSec / 1e6);
+    }
+    for (const BenchClassScore& c : res.classes) {
+        printf("        class %d %-2s %3d threads  %.3f %s  (%.3f per thread)\n", c.efficiencyClass,
+            BenchClassLabel(c.efficiencyClass, classCount), c.threads, c.score / 1e6, g_rate, c.perThread / 1e6);
+    }
+}
+
+// CSV: group,cpu,core,package,class,ops_per_sec (kernel units/s)
+static void WriteCores(const char* path, const BenchResult& res) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "group,cpu,core,package,class,ops_per_sec\n");
+    for (const BenchThreadResult& t : res.threads) {
+        const BenchPlacement& p = t.placement;
+        fprintf(f, "%d,%d,%d,%d,%d,%.1f\n", p.group, p.cpu, p.core, p.package, p.efficiencyClass, t.opsPerSec);
+    }
+    fclose(f);
+}
+
+// SMT yield, and the per-core sibling breakdown in pairs mode
+static void PrintSmt(const BenchResult& res) {
+    const BenchSmtReport& smt = res.smt;
+    if (smt.mode == BENCH_SMT_OFF) return;
+    printf("        physical cores %.3f  all logical %.3f %s  SMT yield %.3f\n",
+        smt.physicalScore / 1e6, smt.logicalScore / 1e6, g_rate, smt.yield);
+    if (smt.pairs.empty()) return;
+    printf("        %-6s %-9s %-10s %-10s %-9s %s\n", "core", "cpus", "solo", "paired", "slowdown", "yield");
+    for (const BenchSmtPair& p : smt.pairs) {
+        char cpus[24];
+        if (p.cpuB >= 0) snprintf(cpus, sizeof(cpus), "%d+%d", p.cpuA, p.cpuB);
+        else snprintf(cpus, sizeof(cpus), "%d", p.cpuA);
+        printf("        %-6d %-9s %-10.3f %-10.3f %7.1f%%  %.3f\n", p.core, cpus, p.solo / 1e6, p.paired / 1e6,
+            p.slowdownPct, p.yield);
+    }
+}
+
+// Scaling curve, fitted models and the knee
+static void PrintScaling(const BenchResult& res) {
+    const BenchScalingReport& sc = res.scaling;
+    if (sc.mode == BENCH_SCALING_OFF) return;
+    printf("        %-8s %-10s %-8s %-10s %s\n", "threads", g_rate, "speedup", "efficiency", "precision");
+    for (const BenchScalingPoint& p : sc.points) {
+        printf("        %-8d %-10.3f %-8.2f %8.1f%%   +-%.2f%%%s\n", p.threads, p.score / 1e6, p.speedup,
+            p.efficiency * 100.0, p.precision * 100.0, p.threads == sc.fit.kneeThreads ? "  <- knee" : "");
+    }
+    printf("        Amdahl serial fraction %.2f%%", sc.fit.serialFraction * 100.0);
+    if (sc.fit.serialFraction > 0.0) printf(" (max speedup %.1fx)", 1.0 / sc.fit.serialFraction);
+    printf("\n");
+    printf("        USL sigma %.4f kappa %.6f", sc.fit.sigma, sc.fit.kappa);
+    if (sc.fit.peakThreads > 0.0) printf(", throughput peaks at %.1f threads", sc.fit.peakThreads);
+    printf("\n        knee at %d threads\n", sc.fit.kneeThreads);
+}
+
+// CSV: threads,ops_per_sec,speedup,efficiency,precision
+static void WriteCurve(const char* path, const BenchScalingReport& sc) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "threads,ops_per_sec,speedup,efficiency,precision\n");
+    for (const BenchScalingPoint& p : sc.points) {
+        fprintf(f, "%d,%.1f,%.4f,%.4f,%.5f\n", p.threads, p.score, p.speedup, p.efficiency, p.precision);
+    }
+    fclose(f);
+}
+
+// Per-thread min/median/max, CV and stragglers (with their CPUs when pinned)
+static void PrintThreadSpread(const BenchResult& res) {
+    const BenchThreadSpread& sp = res.spread;
+    if (res.threadCount < 2) return;
+    printf("        per thread min %.3f  median %.3f  max %.3f %s  cv %.2f%%\n",
+        sp.min / 1e6, sp.median / 1e6, sp.max / 1e6, g_rate, sp.cv * 100.0);
+    for (const BenchStraggler& s : sp.stragglers) {
+        const BenchThreadResult& t = res.threads[s.thread];
+        printf("        straggler: thread %d", s.thread);
+        if (res.pinned && res.groupCount > 1) printf(" on cpu %d:%d", t.placement.group, t.placement.cpu);
+        else if (res.pinned) printf(" on cpu %d", t.placement.cpu);
+        printf("  %.3f %s, %.1f%% below %s median\n", t.opsPerSec / 1e6, g_rate, s.deficitPct,
+            res.pinned ? "its class" : "the");
+    }
+}
+
+// Threads and summed score per processor group
+static void PrintGroups(const BenchResult& res) {
+    if (res.groupCount < 2) return;
+    for (int g = 0; g < res.groupCount; g++) {
+        int threads = 0;
+        double score = 0.0;
+        for (const BenchThreadResult& t : res.threads) {
+            if (t.placement.group != g) continue;
+            threads++;
+            score += t.opsPerSec;
+        }
+        printf("        group %d: %d threads, %.3f %s\n", g, threads, score / 1e6, g_rate);
+    }
+}
+
+// Coarse millisecond tick, the resolution the old model worked with
+static uint32_t LegacyTickMs() {
+#ifdef _WIN32
+    return GetTickCount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#endif
+}
+
+// Old timing model: threads created one by one after the start tick, coarse
+// clock checks, no warm-up, score divided by the nominal duration
+static double RunLegacy(int threadCount, int durationMs) {
+    std::vector<std::atomic<int64_t>> ops(threadCount);
+    uint32_t startTick = LegacyTickMs();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        ops[i].store(0);
+        threads.emplace_back([&, i]() {
+            double x = 1.0 + i;
+            int64_t n = 0;
+            while (true) {
+                x = BenchCpuKernel(x, LEGACY_CHUNK_OPS);
+                n += LEGACY_CHUNK_OPS;
+                if (LegacyTickMs() - startTick >= (uint32_t)durationMs) break;
+            }
+            ops[i].store(n);
+        });
+    }
+    int64_t total = 0;
+    for (int i = 0; i < threadCount; i++) {
+        threads[i].join();
+        total += ops[i].load();
+    }
+    return (double)total / ((double)durationMs / 1000.0);
+}
+
+static void PrintThrottle(const BenchThrottleSummary& t, int intervalMs) {
+    printf("        peak %.3f  sustained %.3f %s  drop %.1f%%", t.peak / 1e6, t.sustained / 1e6, g_rate, t.dropPct);
+    if (t.throttled) {
+        if (t.onsetSample >= 0) printf("  THROTTLING from %.1f s", t.onsetSample * intervalMs / 1000.0);
+        else printf("  THROTTLING");
+    }
+    printf("\n");
+}
+
+// CSV: time_s,total,thread0,thread1,... (kernel units/s); warm-up rows are included
+static void WriteSeries(const char* path, const BenchTimeSeries& ts) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "time_s,total");
+    for (size_t i = 0; i < ts.perThread.size(); i++) fprintf(f, ",thread%d", (int)i);
+    fprintf(f, "\n");
+    for (size_t k = 0; k < ts.total.size(); k++) {
+        fprintf(f, "%.3f,%.1f", (k + 1) * ts.intervalMs / 1000.0, ts.total[k]);
+        for (size_t i = 0; i < ts.perThread.size(); i++) fprintf(f, ",%.1f", ts.perThread[i][k]);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+// Read the total column back from a --series CSV and analyze it
+static int AnalyzeSeries(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    std::vector<double> rates;
+    double t0 = 0.0, t1 = 0.0;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        double t, rate;
+        if (sscanf(line, "%lf,%lf", &t, &rate) == 2) {
+            if (rates.empty()) t0 = t;
+            t1 = t;
+            rates.push_back(rate);
+        }
+    }
+    fclose(f);
+    int intervalMs = rates.size() > 1 ? (int)((t1 - t0) * 1000.0 / (rates.size() - 1) + 0.5) : 100;
+    BenchThrottleSummary t = BenchAnalyzeThrottling(rates.data(), (int)rates.size(), 0);
+    printf("%d samples at %d ms\n", (int)rates.size(), intervalMs);
+    PrintThrottle(t, intervalMs);
+    return 0;
+}
+
+// Hammer the pool with back-to-back runs cancelled at random points (including
+// before the barrier releases) and check that every cancel stays within the
+// bound, completed runs produce a score and no threads are created after the first run
+static int RunStress(int cycles) {
+    BenchConfig cfg = g_config;
+    cfg.warmupMs = 0;
+    cfg.adaptive = false;
+    int completed = 0, cancelled = 0, failures = 0, poolSize = -1;
+    srand(12345);
+    for (int c = 0; c < cycles; c++) {
+        cfg.durationMs = 1 + rand() % 20;
+        if (!BenchStart(cfg)) {
+            printf("cycle %d: BenchStart refused\n", c);
+            failures++;
+            continue;
+        }
+        int action = rand() % 3;
+        if (action == 0) {
+            BenchCancel();  // immediately, usually before the barrier releases
+            cancelled++;
+        } else if (action == 1) {
+            std::this_thread::sleep_for(std::chrono::microseconds(rand() % 15000));
+            if (BenchIsDone()) {
+                BenchGetResult();
+                completed++;
+            } else {
+                BenchCancel();
+                cancelled++;
+            }
+        } else {
+            BenchResult r = BenchGetResult();
+            completed++;
+            if (!r.completed || r.score <= 0.0) {
+                printf("cycle %d: completed run without a score\n", c);
+                failures++;
+            }
+        }
+        if (poolSize < 0) {
+            poolSize = BenchPoolSize();
+        } else if (BenchPoolSize() != poolSize) {
+            printf("cycle %d: pool grew from %d to %d threads\n", c, poolSize, BenchPoolSize());
+            failures++;
+        }
+    }
+    BenchCancelStats cs = BenchGetCancelStats();
+    printf("%d cycles: %d completed, %d cancelled, pool %d threads\n", cycles, completed, cancelled, BenchPoolSize());
+    printf("cancel latency: max %.3f ms, %d over the %d ms bound\n", cs.maxNs / 1e6, cs.overBound, BENCH_CANCEL_BOUND_MS);
+    failures += cs.overBound;
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
+
+// The same randomized cycles against the child benchmark host: every cycle
+// must end with a result or a cancel, and the child must be gone afterwards
+static int RunHostStress(int cycles) {
+    BenchConfig cfg = g_config;
+    cfg.warmupMs = 0;
+    cfg.adaptive = false;
+    int completed = 0, cancelled = 0, failures = 0;
+    int64_t maxCancelNs = 0;
+    srand(12345);
+    for (int c = 0; c < cycles; c++) {
+        cfg.durationMs = 1 + rand() % 20;
+        if (!BenchHostStart(cfg, BENCH_HOST_JOB_CPU, NULL)) {
+            printf("cycle %d: %s\n", c, BenchHostError());
+            failures++;
+            continue;
+        }
+        int action = rand() % 3;
+        if (action == 1) std::this_thread::sleep_for(std::chrono::microseconds(rand() % 15000));
+        if (action == 2) {
+            while (!BenchHostIsDone()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (action != 0 && BenchHostIsDone()) {
+            BenchResult r = BenchHostGetResult();
+            completed++;
+            if (!r.completed || r.score <= 0.0) {
+                printf("cycle %d: %s\n", c, BenchHostError()[0] ? BenchHostError() : "completed run without a score");
+                failures++;
+            }
+        } else {
+            int64_t ns = BenchHostCancel();
+            if (ns > maxCancelNs) maxCancelNs = ns;
+            cancelled++;
+        }
+    }
+    printf("%d cycles: %d completed, %d cancelled in a child process\n", cycles, completed, cancelled);
+    printf("cancel latency: max %.3f ms (child killed after %d ms)\n", maxCancelNs / 1e6, BENCH_CANCEL_BOUND_MS);
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
+
+// A run that ended without a result, with the reason a kernel gave if any
+static void ReportFailedRun(const char* kernel) {
+    const char* why = BenchRunError();
+    fprintf(stderr, "%s run failed%s%s\n", kernel, why[0] ? ": " : "", why);
+}
+
+// With --history, the result as the GUI would have saved it
+static void AppendHistory(const char* kernel, const BenchResult& res, const char* extra) {
+    if (!g_historyPath) return;
+    BenchAppendHistory(g_historyPath, kernel, res.score / 1e6, res.stats.precision, res.series, res.throttle,
+        res.pinned ? res.threads : std::vector<BenchThreadResult>(), res.smt, res.scaling, extra);
+}
+
+// --slow-thread as a check: one run with worker N idling, which the spread
+// report must flag as a straggler, then runs cancelled during measurement,
+// each of which must park every worker (the sleeping one included) within
+// BENCH_CANCEL_BOUND_MS
+static int RunSlowThreadCheck() {
+    BenchConfig cfg = g_config;
+    if (cfg.threadCount < 2 || cfg.slowThread >= cfg.threadCount) {
+        fprintf(stderr, "--slow-thread %d needs a multicore run with at least %d threads\n", cfg.slowThread,
+            cfg.slowThread + 1 > 2 ? cfg.slowThread + 1 : 2);
+        return 1;
+    }
+    BenchResult res = BenchRun(cfg);
+    if (!res.completed) {
+        ReportFailedRun(cfg.kernel);
+        return 1;
+    }
+    printf("worker %d idling %d%%: %.3f %s over %d threads\n", cfg.slowThread, cfg.slowPct, res.score / 1e6, g_rate, res.threadCount);
+    PrintThreadSpread(res);
+    int failures = 0;
+    bool flagged = false;
+    for (const BenchStraggler& st : res.spread.stragglers) flagged = flagged || st.thread == cfg.slowThread;
+    if (!flagged) {
+        printf("worker %d was not flagged as a straggler\n", cfg.slowThread);
+        failures++;
+    }
+    int64_t maxCancelNs = 0;
+    int cancels = 0;
+    for (int c = 0; c < SLOW_CANCELS; c++) {
+        if (!BenchStart(cfg)) {
+            printf("cancel %d: BenchStart refused\n", c);
+            failures++;
+            continue;
+        }
+        // Spread over the first half of the measurement window
+        int delayMs = cfg.warmupMs + cfg.durationMs * (c + 1) / (2 * SLOW_CANCELS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        if (BenchIsDone()) {
+            BenchGetResult();
+            continue;
+        }
+        int64_t ns = BenchCancel();
+        cancels++;
+        if (ns > maxCancelNs) maxCancelNs = ns;
+        if (ns > (int64_t)BENCH_CANCEL_BOUND_MS * 1000000) {
+            printf("cancel %d: %.3f ms, over the %d ms bound\n", c, ns / 1e6, BENCH_CANCEL_BOUND_MS);
+            failures++;
+        }
+    }
+    if (cancels == 0) {
+        printf("no run was still going to cancel\n");
+        failures++;
+    }
+    printf("cancel latency: max %.3f ms over %d cancels (bound %d ms)\n", maxCancelNs / 1e6, cancels, BENCH_CANCEL_BOUND_MS);
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
+
+// One run in a child benchmark host, with the same result as BenchRun
+static bool RunHosted(const BenchConfig& cfg, BenchResult* res) {
+    if (!BenchHostStart(cfg, g_processes ? BENCH_HOST_JOB_PROCESSES : BENCH_HOST_JOB_CPU, NULL)) {
+        fprintf(stderr, "%s\n", BenchHostError());
+        return false;
+    }
+    while (!BenchHostIsDone()) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    *res = BenchHostGetResult();
+    if (!res->completed) {
+        fprintf(stderr, "%s\n", BenchHostError());
+        return false;
+    }
+    return true;
+}
+
+// The threaded run, then one worker process per thread
+static bool RunProcesses(const BenchConfig& cfg, BenchResult* res) {
+    if (!BenchProcStart(cfg)) {
+        fprintf(stderr, "%s\n", BenchProcError());
+        return false;
+    }
+    while (!BenchProcIsDone()) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    *res = BenchProcGetResult();
+    if (!res->completed) {
+        fprintf(stderr, "%s\n", BenchProcError());
+        return false;
+    }
+    return true;
+}
+
+// Process-per-core score next to the threaded one
+static void PrintProcesses(const BenchResult& res) {
+    if (!res.processes) return;
+    printf("        processes %.3f %s  threads %.3f %s  processes/threads %.3f\n",
+        res.score / 1e6, g_rate, res.threadedScore / 1e6, g_rate, res.threadedScore > 0.0 ? res.score / res.threadedScore : 0.0);
+}
+
+static const char* ThreadModelName(int model) {
+    switch (model) {
+        case BENCH_KERNEL_SINGLE: return "single";
+        case BENCH_KERNEL_MULTI: return "multi";
+        case BENCH_KERNEL_SWEEP: return "sweep";
+        default: return "external";
+    }
+}
+
+// The registry as --type sees it, plugin problems last
+static int ListKernels() {
+    printf("%-16s %-20s %-8s %-10s %-8s %s\n", "name", "label", "unit", "ops/iter", "threads", "source");
+    for (const BenchKernel& k : BenchKernels()) {
+        printf("%-16s %-20s %-8s %-10g %-8s %s\n", k.name.c_str(), k.label.c_str(), k.unit.c_str(), k.opsPerIter,
+            ThreadModelName(k.threadModel), k.source.empty() ? "built-in" : k.source.c_str());
+    }
+    for (const std::string& e : BenchPluginErrors()) printf("plugin error: %s\n", e.c_str());
+    return BenchPluginErrors().empty() ? 0 : 1;
+}
+
+// Set an environment variable this process and its children read
+static void SetEnvVar(const char* name, const char* value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+// Put back a variable as it was before a SetEnvVar; NULL removes it
+static void RestoreEnvVar(const char* name, const char* old) {
+    if (old) SetEnvVar(name, old);
+#ifdef _WIN32
+    else _putenv_s(name, "");
+#else
+    else unsetenv(name);
+#endif
+}
+
+// Add a plugin path to BENCH_PLUGIN_ENV, where child processes find it too
+static void AddPluginPath(const char* path) {
+    const char* old = getenv(BENCH_PLUGIN_ENV);
+    std::string list = old && old[0] ? std::string(old) : std::string();
+#ifdef _WIN32
+    if (!list.empty()) list += ';';
+#else
+    if (!list.empty()) list += ':';
+#endif
+    list += path;
+    SetEnvVar(BENCH_PLUGIN_ENV, list.c_str());
+}
+
+// The same recurrence under every ISA the CPU supports: throughput, the core
+// clock under that load, and both against the scalar run. A wider ISA that
+// runs at a lower clock is paying a frequency licence.
+static int RunSimdCompare() {
+    BenchConfig cfg = g_config;
+    int threads = cfg.threadCount;
+    PrintCpuCounts(BenchGetTopology());
+    printf("%-8s %-12s %-8s %-14s %-10s %s\n", "isa", "Mflop/s", "GHz", "flop/cycle/thr", "speedup", "clock vs scalar");
+    double scalarScore = 0.0, scalarGhz = 0.0;
+    for (int isa = 0; isa < BENCH_ISA_COUNT; isa++) {
+        if (!BenchIsaSupported(isa)) {
+            printf("%-8s not supported by this CPU or build\n", BenchIsaName(isa));
+            continue;
+        }
+        snprintf(cfg.kernel, sizeof(cfg.kernel), "simd-%s", BenchIsaName(isa));
+        BenchResult res = BenchRun(cfg);
+        if (!res.completed) {
+            ReportFailedRun(cfg.kernel);
+            return 1;
+        }
+        double ghz = BenchMeasureClockGHz(BenchIsaKernel(isa), threads, SIMD_CLOCK_MS);
+        if (isa == BENCH_ISA_SCALAR) {
+            scalarScore = res.score;
+            scalarGhz = ghz;
+        }
+        char ghzBuf[16] = "-", perCycle[16] = "-", clock[16] = "-";
+        if (ghz > 0.0) {
+            snprintf(ghzBuf, sizeof(ghzBuf), "%.3f", ghz);
+            snprintf(perCycle, sizeof(perCycle), "%.2f", res.score / threads / (ghz * 1e9));
+            if (scalarGhz > 0.0) snprintf(clock, sizeof(clock), "%+.1f%%", (ghz / scalarGhz - 1.0) * 100.0);
+        }
+        printf("%-8s %-12.1f %-8s %-14s %-10.2f %s\n", BenchIsaName(isa), res.score / 1e6, ghzBuf, perCycle,
+            scalarScore > 0.0 ? res.score / scalarScore : 0.0, clock);
+    }
+    printf("%d thread(s); the clock is measured with the same load running (\"-\" where it can't be)\n", threads);
+    return 0;
+}
+
+// One element type of the ILP family on one thread, 1..BENCH_ILP_MAX_CHAINS
+// chains: the rate per chain count, the latency of a step from the single
+// chain, the peak steps per cycle and the fewest chains that reach it
+static bool RunIlpType(BenchConfig cfg, int type) {
+    const char* typeName = type == BENCH_ILP_FLOAT ? "float" : "double";
+    char tc = type == BENCH_ILP_FLOAT ? 'f' : 'd';
+    double ghz = BenchMeasureClockGHz(BenchIlpKernel(type, BENCH_ILP_MAX_CHAINS, g_ilpUnroll), 1, SIMD_CLOCK_MS);
+    printf("%s, unroll %d", typeName, g_ilpUnroll);
+    if (ghz > 0.0) printf(", clock %.3f GHz", ghz);
+    printf("\n        %-8s %-12s %-14s %s\n", "chains", "Mflop/s", ghz > 0.0 ? "steps/cycle" : "steps/ns", "vs 1 chain");
+    double rates[BENCH_ILP_MAX_CHAINS];
+    double peak = 0.0;
+    for (int chains = 1; chains <= BENCH_ILP_MAX_CHAINS; chains++) {
+        snprintf(cfg.kernel, sizeof(cfg.kernel), "ilp-%c%dx%d", tc, chains, g_ilpUnroll);
+        BenchResult res = BenchRun(cfg);
+        if (!res.completed) {
+            ReportFailedRun(cfg.kernel);
+            return false;
+        }
+        rates[chains - 1] = res.score;
+        if (res.score > peak) peak = res.score;
+        // Two flop per multiply-add step
+        double steps = res.score / 2.0 / (ghz > 0.0 ? ghz * 1e9 : 1e9);
+        printf("        %-8d %-12.1f %-14.3f %.2fx\n", chains, res.score / 1e6, steps, res.score / rates[0]);
+    }
+    int saturation = BENCH_ILP_MAX_CHAINS;
+    for (int chains = BENCH_ILP_MAX_CHAINS; chains >= 1; chains--) {
+        if (rates[chains - 1] >= peak * ILP_SATURATION) saturation = chains;
+    }
+    double latency = 2.0 / rates[0] * (ghz > 0.0 ? ghz * 1e9 : 1e9);
+    double peakSteps = peak / 2.0 / (ghz > 0.0 ? ghz * 1e9 : 1e9);
+    const char* per = ghz > 0.0 ? "cycles" : "ns";
+    printf("        latency %.2f %s per step, peak %.2f steps/%s, saturated from %d chains (%.0f%% of peak)\n",
+        latency, per, peakSteps, ghz > 0.0 ? "cycle" : "ns", saturation, ILP_SATURATION * 100.0);
+    return true;
+}
+
+// The CPU kernel's formula through each math implementation on one thread:
+// throughput next to the worst error, so a library change shows up as
+// such rather than as a different CPU
+static int RunMathCompare() {
+    BenchConfig cfg = g_config;
+    cfg.threadCount = 1;
+    printf("sin(x) * cos(x) + sqrt(x + 1), %d independent lanes, one thread\n", BENCH_MATH_LANES);
+    printf("%-6s %-7s %-10s %-8s %-10s %-10s %-10s %s\n", "impl", "isa", "Mops/s", "vs libm", "sin ulp", "cos ulp",
+        "sqrt ulp", "formula ulp");
+    double libm = 0.0;
+    BenchMathAccuracy acc = {};
+    for (int impl = 0; impl < BENCH_MATH_COUNT; impl++) {
+        snprintf(cfg.kernel, sizeof(cfg.kernel), "math-%s", BenchMathName(impl));
+        BenchResult res = BenchRun(cfg);
+        if (!res.completed) {
+            ReportFailedRun(cfg.kernel);
+            return 1;
+        }
+        if (impl == BENCH_MATH_LIBM) libm = res.score;
+        acc = BenchMathMeasureAccuracy(impl);
+        printf("%-6s %-7s %-10.2f %-8.2f %-10.3g %-10.3g %-10.3g %.3g\n", BenchMathName(impl), BenchMathIsa(impl),
+            res.score / 1e6, libm > 0.0 ? res.score / libm : 0.0, acc.sinUlp, acc.cosUlp, acc.sqrtUlp, acc.formulaUlp);
+    }
+    printf("max error over %d points in [-100, 100] against a %d-bit reference%s\n", acc.samples, acc.referenceBits,
+        acc.referenceBits <= 53 ? " (no wider long double here: libm is its own reference)" : "");
+    return 0;
+}
+
+static int RunIlp() {
+    BenchConfig cfg = g_config;
+    cfg.threadCount = 1;
+    if (!g_durationSet) {
+        cfg.durationMs = ILP_STEP_MS;
+        cfg.warmupMs = ILP_WARMUP_MS;
+    }
+    printf("x = x * m + a on independent chains, one thread, %d ms per chain count\n", cfg.durationMs);
+    if (!RunIlpType(cfg, BENCH_ILP_DOUBLE)) return 1;
+    if (!RunIlpType(cfg, BENCH_ILP_FLOAT)) return 1;
+    return 0;
+}
+
+// Bytes with a binary unit, "768.0 MiB"
+static void FormatBytes(int64_t bytes, char* buf, size_t size) {
+    if (bytes >= ((int64_t)1 << 30)) snprintf(buf, size, "%.1f GiB", bytes / 1073741824.0);
+    else if (bytes >= ((int64_t)1 << 20)) snprintf(buf, size, "%.1f MiB", bytes / 1048576.0);
+    else snprintf(buf, size, "%.0f KiB", bytes / 1024.0);
+}
+
+// STREAM's four kernels on one thread and on every usable thread (--threads
+// N), each with ordinary and, on x86, non-temporal stores, in GB/s (1e9 bytes
+// as STREAM counts them). Memory-bound code tops out near the all-thread Triad.
+static int RunStreamTable() {
+    BenchConfig cfg = g_config;
+    if (!g_durationSet) {
+        cfg.durationMs = STREAM_STEP_MS;
+        cfg.warmupMs = STREAM_WARMUP_MS;
+    }
+    PrintCpuCounts(BenchGetTopology());
+    int counts[2] = { 1, g_threads > 0 ? g_threads : DefaultThreadCount() };
+    if (counts[1] > BENCH_MAX_THREADS) counts[1] = BENCH_MAX_THREADS;
+    int runs = counts[1] > 1 ? 2 : 1;
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    char arrayBuf[32], cacheBuf[32], memBuf[32];
+    int64_t arrayBytes = BenchStreamArrayBytes(counts[runs - 1]);
+    int64_t cacheBytes = caches.l3 ? caches.l3 : caches.l2;
+    FormatBytes(arrayBytes, arrayBuf, sizeof(arrayBuf));
+    FormatBytes(cacheBytes, cacheBuf, sizeof(cacheBuf));
+    FormatBytes(caches.memory, memBuf, sizeof(memBuf));
+    printf("3 arrays of %s (largest cache %s, memory %s), %d ms per kernel\n", arrayBuf, cacheBuf, memBuf, cfg.durationMs);
+    if (arrayBytes < cacheBytes * 4) printf("memory caps the arrays below 4x the cache: part of the traffic may hit it\n");
+    bool nt = BenchStreamKernel(BENCH_STREAM_COPY, true) != NULL;
+    printf("%-8s", "GB/s");
+    for (int t = 0; t < runs; t++) {
+        char head[32];
+        snprintf(head, sizeof(head), "%d thr", counts[t]);
+        printf(" %-12s", head);
+        if (nt) {
+            snprintf(head, sizeof(head), "%d thr NT", counts[t]);
+            printf(" %-12s", head);
+        }
+    }
+    printf("\n");
+    for (int op = 0; op < BENCH_STREAM_COUNT; op++) {
+        printf("%-8s", BenchStreamName(op));
+        for (int t = 0; t < runs; t++) {
+            cfg.threadCount = counts[t];
+            for (int n = 0; n <= (nt ? 1 : 0); n++) {
+                snprintf(cfg.kernel, sizeof(cfg.kernel), "stream-%s%s", BenchStreamName(op), n ? "-nt" : "");
+                BenchResult res = BenchRun(cfg);
+                if (!res.completed) {
+                    ReportFailedRun(cfg.kernel);
+                    return 1;
+                }
+                // One line per cell, tagged like the --sync cells
+                char extra[64];
+                snprintf(extra, sizeof(extra), "stream:kernel=%s:threads=%d:nt=%d", BenchStreamName(op), counts[t], n);
+                AppendHistory(cfg.kernel, res, extra);
+                printf(" %-12.2f", res.score / 1e9);
+                fflush(stdout);
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+// Cache level a working set of `bytes` fits in, or "DRAM"
+static const char* LatencyLevel(const BenchCacheInfo& caches, int64_t bytes) {
+    if (bytes <= caches.l1d) return "L1d";
+    if (bytes <= caches.l2) return "L2";
+    if (bytes <= caches.l3) return "L3";
+    return "DRAM";
+}
+
+// CSV: bytes,ns_per_load,level
+static void WriteLatencyCurve(const char* path, const std::vector<int64_t>& sizes, const std::vector<double>& ns,
+                              const BenchCacheInfo& caches) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "bytes,ns_per_load,level\n");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        fprintf(f, "%lld,%.3f,%s\n", (long long)sizes[i], ns[i], LatencyLevel(caches, sizes[i]));
+    }
+    fclose(f);
+}
+
+// Load-to-use latency over every built working-set size on one thread, as
+// a log-scaled bar per size with a rule where each detected cache ends, then
+// the latency of each level: the largest size that still fits it
+static int RunLatency() {
+    BenchConfig cfg = g_config;
+    cfg.threadCount = 1;
+    if (!g_durationSet) {
+        cfg.durationMs = LATENCY_STEP_MS;
+        cfg.warmupMs = LATENCY_WARMUP_MS;
+    }
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    double ghz = BenchMeasureClockGHz(BenchIsaKernel(BENCH_ISA_SCALAR), 1, SIMD_CLOCK_MS);
+    char l1[32], l2[32], l3[32];
+    FormatBytes(caches.l1d, l1, sizeof(l1));
+    FormatBytes(caches.l2, l2, sizeof(l2));
+    FormatBytes(caches.l3, l3, sizeof(l3));
+    printf("pointer chase over a random cycle of 64-byte lines, one thread, %d ms per size\n", cfg.durationMs);
+    printf("caches: L1d %s, L2 %s, L3 %s", l1, l2, l3);
+    if (ghz > 0.0) printf(", clock %.3f GHz", ghz);
+    printf("\n");
+    std::vector<int64_t> sizes;
+    std::vector<double> ns;
+    for (int i = 0; i < BenchLatencySizeCount(); i++) {
+        BenchLatencyName(i, cfg.kernel, sizeof(cfg.kernel));
+        BenchResult res = BenchRun(cfg);
+        if (!res.completed || res.score <= 0.0) {
+            ReportFailedRun(cfg.kernel);
+            return 1;
+        }
+        sizes.push_back(BenchLatencySize(i));
+        ns.push_back(1e9 / res.score);
+    }
+    double lo = ns[0], hi = ns[0];
+    for (double v : ns) {
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    const int64_t bounds[3] = { caches.l1d, caches.l2, caches.l3 };
+    const char* boundNames[3] = { "L1d", "L2", "L3" };
+    printf("%-12s %-10s %-8s\n", "size", "ns/load", ghz > 0.0 ? "cycles" : "");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        // A rule before the first size past each cache
+        for (int b = 0; b < 3; b++) {
+            if (bounds[b] > 0 && sizes[i] > bounds[b] && (i == 0 || sizes[i - 1] <= bounds[b])) {
+                char size[32];
+                FormatBytes(bounds[b], size, sizeof(size));
+                printf("------------ %s %s ------------\n", boundNames[b], size);
+            }
+        }
+        char size[32], cycles[16] = "";
+        FormatBytes(sizes[i], size, sizeof(size));
+        if (ghz > 0.0) snprintf(cycles, sizeof(cycles), "%.1f", ns[i] * ghz);
+        int bar = hi > lo ? 1 + (int)(log(ns[i] / lo) / log(hi / lo) * (LATENCY_BAR_WIDTH - 1)) : 1;
+        printf("%-12s %-10.2f %-8s %s\n", size, ns[i], cycles, std::string(bar, '#').c_str());
+    }
+    // Each cache: median of the sizes that fit it but not the level below, which
+    // skips the transition at the edge; DRAM: the largest size
+    printf("latency per level:");
+    for (int b = 0; b < 3; b++) {
+        std::vector<double> level;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            if (sizes[i] <= bounds[b] && (b == 0 || sizes[i] > bounds[b - 1])) level.push_back(ns[i]);
+        }
+        if (level.empty()) continue;
+        std::sort(level.begin(), level.end());
+        printf("  %s %.2f ns", boundNames[b], level[level.size() / 2]);
+    }
+    if (sizes.back() > caches.l3) printf("  DRAM %.2f ns", ns.back());
+    printf("\n");
+    if (g_curvePath) WriteLatencyCurve(g_curvePath, sizes, ns, caches);
+    return 0;
+}
+
+// One memory kernel under the selected page mode; the rate, and in *huge the
+// share of its buffer on huge pages (-1 if unknown)
+static bool RunPagesKernel(BenchConfig cfg, const char* kernel, double* rate, double* huge) {
+    snprintf(cfg.kernel, sizeof(cfg.kernel), "%s", kernel);
+    BenchResult res = BenchRun(cfg);
+    if (!res.completed || res.score <= 0.0) {
+        ReportFailedRun(kernel);
+        return false;
+    }
+    *rate = res.score;
+    BenchPages pages = BenchLastMemoryPages();
+    int64_t hugeBytes = BenchHugeBytes(pages);
+    *huge = hugeBytes < 0 || pages.bytes == 0 ? -1.0 : (double)hugeBytes / (double)pages.bytes;
+    return true;
+}
+
+// The pointer chase at a few sizes past the reach of the TLBs and the random
+// updates, once per page mode, each against 4k pages. A mode the machine
+// can't provide is reported with the reason and skipped, not run on a fallback.
+static int RunPagesTable() {
+    BenchConfig cfg = g_config;
+    cfg.threadCount = 1;
+    if (!g_durationSet) {
+        cfg.durationMs = PAGES_STEP_MS;
+        cfg.warmupMs = PAGES_WARMUP_MS;
+    }
+    std::vector<int> chase;
+    const int64_t wanted[3] = { (int64_t)16 << 20, (int64_t)256 << 20, (int64_t)1 << 30 };
+    for (int64_t w : wanted) {
+        int best = -1;
+        for (int i = 0; i < BenchLatencySizeCount() && BenchLatencySize(i) <= w; i++) best = i;
+        if (best >= 0 && (chase.empty() || chase.back() != best)) chase.push_back(best);
+    }
+    std::string thp = BenchThpSetting();
+    if (!thp.empty()) printf("transparent huge pages: %s\n", thp.c_str());
+    printf("one thread, %d ms per kernel; chase in ns/load, random in Mupdates/s, change against 4k\n", cfg.durationMs);
+    printf("random: plain XORs, each thread on its own slice of the table (one thread: all of it)\n");
+    printf("%-8s %-10s", "pages", "huge");
+    char head[32];
+    for (int i : chase) {
+        FormatBytes(BenchLatencySize(i), head, sizeof(head));
+        printf(" %-16s", head);
+    }
+    FormatBytes(BenchRandomBytes(), head, sizeof(head));
+    printf(" random %s\n", head);
+    const int64_t largest = BenchLatencySize(chase.back()) > BenchRandomBytes() ? BenchLatencySize(chase.back()) : BenchRandomBytes();
+    std::vector<double> base(chase.size() + 1, 0.0);
+    // 4k first, so every other mode has its reference
+    const int order[BENCH_PAGES_COUNT] = { BENCH_PAGES_4K, BENCH_PAGES_DEFAULT, BENCH_PAGES_THP, BENCH_PAGES_2M, BENCH_PAGES_1G };
+    for (int mode : order) {
+        printf("%-8s ", BenchPageModeName(mode));
+        BenchPages probe = BenchAllocPages((size_t)largest, mode);
+        const char* why = probe.fallback;
+        BenchFreePages(&probe);
+        if (why) {
+            printf("unavailable: %s\n", why);
+            continue;
+        }
+        SetEnvVar(BENCH_PAGES_ENV, BenchPageModeName(mode));
+        std::vector<double> values;
+        double huge = -1.0;
+        for (size_t k = 0; k <= chase.size(); k++) {
+            char name[BENCH_KERNEL_NAME_MAX] = "random";
+            if (k < chase.size()) BenchLatencyName(chase[k], name, sizeof(name));
+            double rate, share;
+            if (!RunPagesKernel(cfg, name, &rate, &share)) return 1;
+            // ns per load for the chase, updates/s for random
+            values.push_back(k < chase.size() ? 1e9 / rate : rate);
+            if (k + 1 == chase.size()) huge = share;
+        }
+        char hugeBuf[16] = "?";
+        if (huge >= 0.0) snprintf(hugeBuf, sizeof(hugeBuf), "%.0f%%", huge * 100.0);
+        printf("%-10s", hugeBuf);
+        for (size_t k = 0; k < values.size(); k++) {
+            if (mode == BENCH_PAGES_4K) base[k] = values[k];
+            char cell[32];
+            double v = k < chase.size() ? values[k] : values[k] / 1e6;
+            if (mode == BENCH_PAGES_4K || base[k] <= 0.0) snprintf(cell, sizeof(cell), "%.2f", v);
+            else snprintf(cell, sizeof(cell), "%.2f (%+.0f%%)", v, (values[k] / base[k] - 1.0) * 100.0);
+            printf(" %-16s", cell);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    printf("huge: share of the largest chase buffer on huge pages after the run\n");
+    return 0;
+}
+
+// The table selects each mode through BENCH_PAGES_ENV; whatever was there
+// before is put back for the kernels that run after it
+static int RunPagesCompare() {
+    const char* old = getenv(BENCH_PAGES_ENV);
+    std::string saved = old ? old : "";
+    int rc = RunPagesTable();
+    RestoreEnvVar(BENCH_PAGES_ENV, old ? saved.c_str() : NULL);
+    return rc;
+}
+
+// Jain's index of the per-thread rates: 1 when every thread got the same
+// share, 1/n when one thread got everything
+static double JainFairness(const std::vector<BenchThreadResult>& threads) {
+    double sum = 0.0, squares = 0.0;
+    for (const BenchThreadResult& t : threads) {
+        sum += t.opsPerSec;
+        squares += t.opsPerSec * t.opsPerSec;
+    }
+    return squares > 0.0 ? sum * sum / (threads.size() * squares) : 0.0;
+}
+
+// Every synchronization kernel at 1, 2, 4 ... usable threads (--threads N):
+// total Mops/s and Jain's fairness over the threads' shares, then what
+// packing per-thread counters into shared lines costs against padding them
+static int RunSync() {
+    BenchConfig cfg = g_config;
+    if (!g_durationSet) {
+        cfg.durationMs = SYNC_STEP_MS;
+        cfg.warmupMs = SYNC_WARMUP_MS;
+    }
+    int maxThreads = g_threads > 0 ? g_threads : DefaultThreadCount();
+    if (maxThreads > BENCH_MAX_THREADS) maxThreads = BENCH_MAX_THREADS;
+    std::vector<int> steps = BenchScalingSteps(BENCH_SCALING_POW2, maxThreads);
+    PrintCpuCounts(BenchGetTopology());
+    printf("%d ms per cell; Mops/s (Jain fairness, 1 = equal shares)\n%-14s", cfg.durationMs, "threads");
+    for (int t : steps) printf(" %-16d", t);
+    printf("\n");
+    std::vector<double> padded, unpadded;
+    for (int kind = 0; kind < BENCH_SYNC_COUNT; kind++) {
+        printf("%-14s", BenchSyncName(kind));
+        for (int t : steps) {
+            cfg.threadCount = t;
+            snprintf(cfg.kernel, sizeof(cfg.kernel), "sync-%s", BenchSyncName(kind));
+            BenchResult res = BenchRun(cfg);
+            if (!res.completed) {
+                ReportFailedRun(cfg.kernel);
+                return 1;
+            }
+            // One line per cell: the thread count tells them apart
+            double fairness = JainFairness(res.threads);
+            char extra[64];
+            snprintf(extra, sizeof(extra), "sync:threads=%d:fairness=%.3f", t, fairness);
+            AppendHistory(cfg.kernel, res, extra);
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%.1f (%.2f)", res.score / 1e6, fairness);
+            printf(" %-16s", cell);
+            fflush(stdout);
+            if (kind == BENCH_SYNC_PADDED) padded.push_back(res.score);
+            if (kind == BENCH_SYNC_UNPADDED) unpadded.push_back(res.score);
+        }
+        printf("\n");
+    }
+    printf("false sharing (unpadded vs padded):");
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (padded[i] > 0.0) printf(" %d thr %+.0f%%", steps[i], (unpadded[i] / padded[i] - 1.0) * 100.0);
+    }
+    printf("\n");
+    return 0;
+}
+
+// One allocator kernel at `threads`, M allocations/s, 0 if the run failed. The
+// history line carries the thread count, allocator and peak RSS so far (bytes,
+// -1 if unknown), which is per row where the peak can be reset.
+static double RunMallocCell(BenchConfig cfg, const char* kernel, int allocator, int threads) {
+    cfg.threadCount = threads;
+    snprintf(cfg.kernel, sizeof(cfg.kernel), "%s", kernel);
+    BenchAllocDrain();
+    BenchResult res = BenchRun(cfg);
+    BenchAllocDrain();
+    if (!res.completed) {
+        ReportFailedRun(cfg.kernel);
+        return 0.0;
+    }
+    char extra[96];
+    snprintf(extra, sizeof(extra), "alloc:threads=%d:allocator=%s:peakrss=%lld", threads, BenchAllocatorName(allocator),
+        (long long)BenchPeakRss());
+    AppendHistory(cfg.kernel, res, extra);
+    return res.score / 1e6;
+}
+
+// Both allocators at 1, 2, 4 ... usable threads (--threads N): same-thread
+// churn and producer-consumer frees over mixed sizes in M allocations/s with
+// the scaling efficiency (rate / (threads x one-thread rate)) and the peak
+// resident set of each row, then churn at each size on one and all threads.
+// Memory an allocator kept from earlier rows counts in later peaks.
+static int RunMalloc() {
+    BenchConfig cfg = g_config;
+    if (!g_durationSet) {
+        cfg.durationMs = MALLOC_STEP_MS;
+        cfg.warmupMs = MALLOC_WARMUP_MS;
+    }
+    int maxThreads = g_threads > 0 ? g_threads : DefaultThreadCount();
+    if (maxThreads > BENCH_MAX_THREADS) maxThreads = BENCH_MAX_THREADS;
+    std::vector<int> steps = BenchScalingSteps(BENCH_SCALING_POW2, maxThreads);
+    PrintCpuCounts(BenchGetTopology());
+    bool reset = BenchResetPeakRss();
+    printf("%d ms per cell; M allocs/s (scaling efficiency); peak RSS %s\n%-18s", cfg.durationMs,
+        reset ? "per row" : "since start (no reset here)", "threads");
+    for (int t : steps) printf(" %-14d", t);
+    printf(" %s\n", "peak RSS");
+    for (int pattern = 0; pattern < BENCH_ALLOC_PATTERNS; pattern++) {
+        for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+            char kernel[BENCH_KERNEL_NAME_MAX], head[32];
+            snprintf(kernel, sizeof(kernel), "alloc-%s-%s", BenchAllocPatternName(pattern), BenchAllocatorName(a));
+            snprintf(head, sizeof(head), "%s %s", BenchAllocPatternName(pattern), BenchAllocatorName(a));
+            printf("%-18s", head);
+            if (reset) BenchResetPeakRss();
+            double one = 0.0;
+            for (int t : steps) {
+                double rate = RunMallocCell(cfg, kernel, a, t);
+                if (rate <= 0.0) return 1;
+                if (t == 1) one = rate;
+                char cell[32];
+                snprintf(cell, sizeof(cell), "%.1f (%.2f)", rate, one > 0.0 ? rate / (t * one) : 0.0);
+                printf(" %-14s", cell);
+                fflush(stdout);
+            }
+            char rss[32] = "?";
+            int64_t peak = BenchPeakRss();
+            if (peak >= 0) FormatBytes(peak, rss, sizeof(rss));
+            printf(" %s\n", rss);
+        }
+    }
+    std::vector<int> sweepThreads(1, 1);
+    if (maxThreads > 1) sweepThreads.push_back(maxThreads);
+    printf("size sweep (churn at one size), M allocs/s\n%-10s", "size");
+    for (int t : sweepThreads) {
+        for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+            char head[32];
+            snprintf(head, sizeof(head), "%s %d thr", BenchAllocatorName(a), t);
+            printf(" %-14s", head);
+        }
+    }
+    printf("\n");
+    if (reset) BenchResetPeakRss();
+    int sizeCount;
+    const int* sizes = BenchAllocSizes(&sizeCount);
+    for (int i = 0; i < sizeCount; i++) {
+        char size[32];
+        if (sizes[i] < 1024) snprintf(size, sizeof(size), "%d B", sizes[i]);
+        else FormatBytes(sizes[i], size, sizeof(size));
+        printf("%-10s", size);
+        for (int t : sweepThreads) {
+            for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+                char kernel[BENCH_KERNEL_NAME_MAX];
+                snprintf(kernel, sizeof(kernel), "alloc-size-%d-%s", sizes[i], BenchAllocatorName(a));
+                double rate = RunMallocCell(cfg, kernel, a, t);
+                if (rate <= 0.0) return 1;
+                printf(" %-14.1f", rate);
+                fflush(stdout);
+            }
+        }
+        printf("\n");
+    }
+    int64_t peak = BenchPeakRss();
+    if (peak >= 0) {
+        char rss[32];
+        FormatBytes(peak, rss, sizeof(rss));
+        printf("peak RSS %s: %s (the pool keeps what it carved; above 64 KiB it is malloc)\n",
+            reset ? "of the sweep" : "since start", rss);
+    }
+    return 0;
+}
+
+static void PrintDistribution(const char* label, const std::vector<double>& ns) {
+    BenchDistribution d = BenchDistributionOf(ns);
+    printf("%-38s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", label, d.min, d.p50, d.p90, d.p99, d.p999, d.max, d.mean);
+}
+
+// OS primitive costs as percentiles: a futex / event wake-up with both
+// threads on one processor and on two cores, a context switch, a null system
+// call and every clock the platform has. Tail percentiles are where the
+// scheduler and power states show.
+static int RunOsCosts() {
+    BenchTopology topo = BenchGetTopology();
+    PrintCpuCounts(topo);
+#ifndef _WIN32
+    char source[64] = "";
+    FILE* f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (f) {
+        if (fgets(source, sizeof(source), f)) source[strcspn(source, "\n")] = '\0';
+        fclose(f);
+        printf("clocksource: %s\n", source);
+    }
+#endif
+    const BenchPlacement& first = topo.allowed[0];
+    const BenchPlacement* other = NULL;
+    for (const BenchPlacement& p : topo.allowed) {
+        if (p.core != first.core) {
+            other = &p;
+            break;
+        }
+    }
+    printf("%-38s %9s %9s %9s %9s %9s %9s %9s\n", "ns", "min", "p50", "p90", "p99", "p99.9", "max", "mean");
+    std::vector<double> ns;
+    if (BenchWakeLatency(first, first, &ns)) PrintDistribution("wake-up, same CPU", ns);
+    else printf("%-38s could not pin both threads to CPU %d\n", "wake-up, same CPU", first.cpu);
+    if (!other) printf("%-38s needs a second usable core\n", "wake-up, cross core");
+    else if (BenchWakeLatency(first, *other, &ns)) PrintDistribution("wake-up, cross core", ns);
+    else printf("%-38s could not pin the threads to CPUs %d and %d\n", "wake-up, cross core", first.cpu, other->cpu);
+    if (BenchSwitchCost(first, &ns)) PrintDistribution("context switch", ns);
+    else printf("%-38s the yielding threads did not alternate on CPU %d\n", "context switch", first.cpu);
+    BenchSyscallCost(&ns);
+    char label[64];
+    snprintf(label, sizeof(label), "syscall: %s", BenchSyscallName());
+    PrintDistribution(label, ns);
+    for (int c = 0; c < BenchClockCount(); c++) {
+        BenchClockCost(c, &ns);
+        snprintf(label, sizeof(label), "clock: %s", BenchClockName(c));
+        PrintDistribution(label, ns);
+    }
+    printf("wake-up and switch: per event; syscall and clocks: per call, over batches of calls\n");
+    return 0;
+}
+
+// Shades of the --c2c heatmap, fastest first
+static const char kHeat[] = " .:-=+*#%@";
+
+// Round trips as a heatmap, one character pair per cell scaled from the
+// fastest to the slowest pair, and as numbers when the matrix is small
+static void PrintC2cMatrix(const BenchC2cMatrix& m) {
+    int n = (int)m.cpus.size();
+    double lo = 0.0, hi = 0.0;
+    for (double v : m.ns) {
+        if (v <= 0.0) continue;
+        if (lo == 0.0 || v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    const int shades = (int)sizeof(kHeat) - 1;
+    printf("round trip, ns: '%c' %.0f ... '%c' %.0f (columns: CPU id mod 10)\n%6s ", kHeat[0], lo, kHeat[shades - 1], hi, "");
+    for (int b = 0; b < n; b++) printf("%d ", m.cpus[b].cpu % 10);
+    printf("\n");
+    for (int a = 0; a < n; a++) {
+        printf("%6d ", m.cpus[a].cpu);
+        for (int b = 0; b < n; b++) {
+            double v = m.ns[(size_t)a * n + b];
+            int shade = hi > lo ? (int)((v - lo) / (hi - lo) * (shades - 1) + 0.5) : 0;
+            char c = v > 0.0 ? kHeat[shade] : '\\';
+            printf("%c%c", c, c);
+        }
+        printf("\n");
+    }
+    if (n > 16) return;
+    printf("%6s", "");
+    for (int b = 0; b < n; b++) printf(" %6d", m.cpus[b].cpu);
+    printf("\n");
+    for (int a = 0; a < n; a++) {
+        printf("%6d", m.cpus[a].cpu);
+        for (int b = 0; b < n; b++) {
+            double v = m.ns[(size_t)a * n + b];
+            if (v > 0.0) printf(" %6.1f", v);
+            else printf(" %6s", "-");
+        }
+        printf("\n");
+    }
+}
+
+static void WriteC2cMatrix(const char* path, const BenchC2cMatrix& m) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    int n = (int)m.cpus.size();
+    fprintf(f, "cpu");
+    for (int b = 0; b < n; b++) fprintf(f, ",%d:%d", m.cpus[b].group, m.cpus[b].cpu);
+    fprintf(f, "\n");
+    for (int a = 0; a < n; a++) {
+        fprintf(f, "%d:%d", m.cpus[a].group, m.cpus[a].cpu);
+        for (int b = 0; b < n; b++) fprintf(f, ",%.2f", m.ns[(size_t)a * n + b]);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+// Core-to-core round trips for every pair of usable processors, the medians
+// of each sharing class (SMT siblings, one last-level cache, across LLCs,
+// across sockets) and, with --history, a c2c entry scored in Mroundtrip/s
+// from the median over all pairs with the class medians in ns after it
+static int RunC2c() {
+    BenchTopology topo = BenchGetTopology();
+    PrintCpuCounts(topo);
+    int n = (int)topo.allowed.size();
+    if (n < 2) {
+        fprintf(stderr, "--c2c needs at least two usable logical processors\n");
+        return 1;
+    }
+    printf("%d pairs, two pinned threads bouncing one cache line each\n", n * (n - 1) / 2);
+    fflush(stdout);
+    BenchC2cMatrix m = BenchMeasureC2c();
+    n = (int)m.cpus.size();
+    PrintC2cMatrix(m);
+    std::vector<double> all;
+    for (int a = 0; a < n; a++) {
+        for (int b = a + 1; b < n; b++) all.push_back(m.ns[(size_t)a * n + b]);
+    }
+    std::sort(all.begin(), all.end());
+    double median = all[all.size() / 2];
+    for (int c = 0; c < BENCH_C2C_CLASSES; c++) {
+        if (m.pairs[c] > 0) printf("%-14s median %7.1f ns over %d pairs\n", BenchC2cClassName(c), m.median[c], m.pairs[c]);
+    }
+    printf("%-14s median %7.1f ns\n", "all pairs", median);
+    if (g_coresPath) WriteC2cMatrix(g_coresPath, m);
+    if (g_historyPath) {
+        char extra[128];
+        snprintf(extra, sizeof(extra), "c2c:%.2f:%.2f:%.2f:%.2f", m.median[BENCH_C2C_SMT], m.median[BENCH_C2C_LLC],
+            m.median[BENCH_C2C_CROSS_LLC], m.median[BENCH_C2C_CROSS_PACKAGE]);
+        BenchAppendHistory(g_historyPath, "c2c", 1e3 / median, 0.0, BenchTimeSeries(), BenchThrottleSummary{},
+            std::vector<BenchThreadResult>(), BenchSmtReport(), BenchScalingReport(), extra);
+    }
+    return 0;
+}
+
+// One matrix of --numa: a row per node with processors, a column per node
+// with memory, "-" where a cell didn't run
+static void PrintNumaMatrix(const char* title, const std::vector<BenchNumaNode>& nodes,
+                            const std::vector<BenchNumaColumn>& cols, bool latency) {
+    printf("%s\n%-10s", title, "");
+    for (size_t m = 0; m < nodes.size(); m++) {
+        char head[32];
+        snprintf(head, sizeof(head), "mem %d", nodes[m].id);
+        printf(" %-10s", head);
+    }
+    printf("\n");
+    for (size_t c = 0; c < nodes.size(); c++) {
+        if (nodes[c].cpus.empty()) continue;
+        char head[32];
+        snprintf(head, sizeof(head), "cpu %d", nodes[c].id);
+        printf("%-10s", head);
+        for (size_t m = 0; m < nodes.size(); m++) {
+            double v = latency ? cols[m].latencyNs[c] : cols[m].bandwidth[c] / 1e9;
+            if (v > 0.0) printf(" %-10.2f", v);
+            else printf(" %-10s", "-");
+        }
+        printf("\n");
+    }
+}
+
+// Threads on node i, memory on node j, for every pair: the Triad bandwidth of
+// the node's processors (--threads N per node) and one thread's load latency.
+// The diagonal is local memory, the rest remote; a machine with one node
+// gives the single local cell, which is what "all cores" measures anyway.
+// Exits 1 when a node with processors didn't get its local cell.
+static int RunNuma() {
+    int durationMs = g_durationSet ? g_config.durationMs : NUMA_STEP_MS;
+    std::vector<BenchNumaNode> nodes = BenchNumaNodes();
+    PrintCpuCounts(BenchGetTopology());
+    for (const BenchNumaNode& n : nodes) {
+        char mem[32] = "?";
+        if (n.memory > 0) FormatBytes(n.memory, mem, sizeof(mem));
+        int threads = g_threads > 0 && g_threads < (int)n.cpus.size() ? g_threads : (int)n.cpus.size();
+        printf("node %d: %d processors (%d bandwidth threads), memory %s\n", n.id, (int)n.cpus.size(), threads, mem);
+    }
+    if (nodes.size() == 1) printf("one NUMA node: the matrix is the single local cell\n");
+    printf("%d ms per cell and kernel; Triad GB/s (1e9 bytes), chase ns/load\n", durationMs);
+    std::vector<BenchNumaColumn> cols;
+    for (const BenchNumaNode& n : nodes) {
+        char size[32];
+        FormatBytes(BenchNumaBytes(n), size, sizeof(size));
+        printf("memory on node %d (%s): ", n.id, size);
+        fflush(stdout);
+        cols.push_back(BenchMeasureNumaColumn(nodes, (int)cols.size(), g_threads, durationMs));
+        const BenchNumaColumn& col = cols.back();
+        if (!col.binding) printf("could not be placed (no processors there and mbind refused)\n");
+        else if (col.onNode < 0.0) printf("%s, placement not verified\n", col.binding);
+        else printf("%s, %.0f%% of sampled pages on the node\n", col.binding, col.onNode * 100.0);
+    }
+    PrintNumaMatrix("bandwidth, GB/s", nodes, cols, false);
+    PrintNumaMatrix("latency, ns", nodes, cols, true);
+    // Local against remote, averaged over the cells that ran
+    double local[2] = { 0.0, 0.0 }, remote[2] = { 0.0, 0.0 };
+    int localCount = 0, remoteCount = 0;
+    for (size_t m = 0; m < nodes.size(); m++) {
+        for (size_t c = 0; c < nodes.size(); c++) {
+            if (cols[m].bandwidth[c] <= 0.0 || cols[m].latencyNs[c] <= 0.0) continue;
+            double* sum = c == m ? local : remote;
+            sum[0] += cols[m].bandwidth[c];
+            sum[1] += cols[m].latencyNs[c];
+            (c == m ? localCount : remoteCount)++;
+        }
+    }
+    if (localCount > 0 && remoteCount > 0) {
+        printf("remote vs local: %.2fx bandwidth, %.2fx latency\n",
+            remote[0] / remoteCount / (local[0] / localCount), remote[1] / remoteCount / (local[1] / localCount));
+    }
+    // One line a script can match instead of parsing a 1x1 matrix
+    if (nodes.size() == 1) {
+        if (localCount > 0) printf("single node: 1x1 matrix, local %.2f GB/s, %.2f ns\n", local[0] / 1e9, local[1]);
+        else printf("single node: 1x1 matrix, local cell did not run\n");
+    }
+    int missing = 0;
+    for (size_t n = 0; n < nodes.size(); n++) {
+        if (!nodes[n].cpus.empty() && (cols[n].bandwidth[n] <= 0.0 || cols[n].latencyNs[n] <= 0.0)) missing++;
+    }
+    if (missing > 0) {
+        fprintf(stderr, "--numa: %d of the local cells did not run\n", missing);
+        return 1;
+    }
+    return 0;
+}
+
+// Peak of one core in flop/cycle for the GEMM ISA: FMA units x lanes x 2.
+// The FMA unit count isn't in CPUID, so it comes from the simd kernel of the
+// same ISA, which keeps enough independent FMAs in flight to fill every unit.
+static double GemmUnitsPerCore(int isa, int lanes, double* measured) {
+    BenchConfig cfg = g_config;
+    cfg.threadCount = 1;
+    cfg.durationMs = 500;
+    cfg.warmupMs = 100;
+    snprintf(cfg.kernel, sizeof(cfg.kernel), "simd-%s", BenchIsaName(isa));
+    BenchResult res = BenchRun(cfg);
+    double ghz = BenchMeasureClockGHz(BenchIsaKernel(isa), 1, SIMD_CLOCK_MS);
+    *measured = 0.0;
+    if (!res.completed || ghz <= 0.0) return 0.0;
+    *measured = res.score / (ghz * 1e9);
+    // simd flop/cycle = 2 per FMA x lanes x units
+    double units = floor(*measured / (2.0 * lanes) + 0.5);
+    return units < 1.0 ? 1.0 : units;
+}
+
+// The GEMM size sweep at one thread count and element type; `peak` in flop/s, 0 if unknown
+static bool RunGemmSizes(BenchConfig cfg, bool fp32, double peak) {
+    printf("        %-8s %-10s %s\n", "N", "GFLOPS", "% of peak");
+    int sizeCount;
+    const int* sizes = BenchGemmSizes(&sizeCount);
+    for (int i = 0; i < sizeCount; i++) {
+        snprintf(cfg.kernel, sizeof(cfg.kernel), "gemm-%c%d", fp32 ? 'f' : 'd', sizes[i]);
+        BenchResult res = BenchRun(cfg);
+        if (!res.completed) {
+            ReportFailedRun(cfg.kernel);
+            return false;
+        }
+        char pct[16] = "-";
+        if (peak > 0.0) snprintf(pct, sizeof(pct), "%.1f", res.score / peak * 100.0);
+        printf("        %-8d %-10.2f %s\n", sizes[i], res.score / 1e9, pct);
+    }
+    return true;
+}
+
+// Cache-blocked GEMM on one thread and on every thread, FP64 and FP32, over
+// the built sizes. Peak = cores x FMA units x lanes x 2 x the clock measured
+// under the same ISA's load at that thread count; SMT siblings share a core's
+// units, so threads beyond the physical cores don't raise it.
+static int RunGemm() {
+    BenchConfig cfg = g_config;
+    if (!g_durationSet) {
+        cfg.durationMs = GEMM_STEP_MS;
+        cfg.warmupMs = GEMM_WARMUP_MS;
+    }
+    BenchTopology topo = BenchGetTopology();
+    PrintCpuCounts(topo);
+    int isa = BenchGemmIsa();
+    // Lanes of a double vector (2 flop x 8 accumulators x lanes per simd iteration); float has twice as many
+    int lanes = (int)(BenchIsaFlopsPerIter(isa) / (2.0 * 8));
+    double measured = 0.0;
+    // The portable kernel is whatever the compiler vectorizes it to, without FMA: no peak to hold it to
+    double units = isa >= BENCH_ISA_AVX2 ? GemmUnitsPerCore(isa, lanes, &measured) : 0.0;
+    printf("C = A * B, %s micro-kernel, packed %d-row panels, %d ms per size\n",
+        isa >= BENCH_ISA_AVX2 ? BenchIsaName(isa) : "portable C++", BENCH_GEMM_PANEL, cfg.durationMs);
+    if (units > 0.0) {
+        printf("peak per core: %.0f FMA unit(s) x %d fp64 / %d fp32 lanes x 2 (simd-%s measured %.2f flop/cycle)\n",
+            units, lanes, lanes * 2, BenchIsaName(isa), measured);
+    } else {
+        printf("peak unknown: %s\n", isa >= BENCH_ISA_AVX2 ? "no clock reference on this CPU" : "no FMA micro-kernel");
+    }
+    int counts[2] = { 1, g_threads > 0 ? g_threads : DefaultThreadCount() };
+    if (counts[1] > BENCH_MAX_THREADS) counts[1] = BENCH_MAX_THREADS;
+    for (int t = 0; t < (counts[1] > 1 ? 2 : 1); t++) {
+        cfg.threadCount = counts[t];
+        double ghz = units > 0.0 ? BenchMeasureClockGHz(BenchIsaKernel(isa), counts[t], SIMD_CLOCK_MS) : 0.0;
+        int cores = counts[t] < topo.coreCount ? counts[t] : topo.coreCount;
+        for (int fp32 = 0; fp32 <= 1; fp32++) {
+            double peak = cores * units * lanes * (fp32 ? 2 : 1) * 2.0 * ghz * 1e9;
+            printf("%s, %d thread(s)", fp32 ? "fp32" : "fp64", counts[t]);
+            if (peak > 0.0) printf(", %d core(s) at %.3f GHz: peak %.1f GFLOPS", cores, ghz, peak / 1e9);
+            printf("\n");
+            if (!RunGemmSizes(cfg, fp32 != 0, peak)) return 1;
+        }
+    }
+    return 0;
+}
+
+// Mean, sample standard deviation and coefficient of variation; returns the CV
+static double PrintSpread(const char* label, const std::vector<double>& v) {
+    double mean = 0.0;
+    for (double s : v) mean += s;
+    mean /= (double)v.size();
+    double var = 0.0;
+    for (double s : v) var += (s - mean) * (s - mean);
+    double sd = v.size() > 1 ? sqrt(var / (double)(v.size() - 1)) : 0.0;
+    printf("%-8s mean %.3f %s  stddev %.3f  cv %.3f%%\n",
+        label, mean / 1e6, g_rate, sd / 1e6, mean > 0.0 ? sd / mean * 100.0 : 0.0);
+    return mean > 0.0 ? sd / mean : 0.0;
+}
+
+int main(int argc, char** argv) {
+    // Child processes run kernels by name, so they load the same plugins first
+    if ((argc == 3 && strcmp(argv[1], BENCH_HOST_ARG) == 0) || (argc == 4 && strcmp(argv[1], BENCH_PROC_ARG) == 0)) {
+        BenchLoadPlugins();
+    }
+    if (argc == 3 && strcmp(argv[1], BENCH_HOST_ARG) == 0) {
+        BenchHostJob jobs[2] = { BenchHostCpuJob(), BenchHostProcessJob() };
+        return BenchHostMain(argv[2], jobs, 2);
+    }
+    if (argc == 4 && strcmp(argv[1], BENCH_PROC_ARG) == 0) return BenchProcWorkerMain(argv[2], atoi(argv[3]));
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* next = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(a, "--type") == 0 && next) {
+            g_kernelName = next; i++;
+        } else if (strcmp(a, "--plugin") == 0 && next) {
+            AddPluginPath(next); i++;
+        } else if (strcmp(a, "--list-kernels") == 0) {
+            g_listKernels = true;
+        } else if (strcmp(a, "--isa") == 0 && next) {
+            int isa = BenchIsaFromName(next);
+            if (!BenchIsaSupported(isa)) {
+                fprintf(stderr, isa < 0 ? "unknown ISA %s (scalar, sse2, avx2, avx512)\n" : "%s is not supported by this CPU or build\n", next);
+                return 1;
+            }
+            SetEnvVar(BENCH_ISA_ENV, next);  // before the registry is built, and for child processes
+            g_kernelName = "simd";
+            i++;
+        } else if (strcmp(a, "--simd") == 0) {
+            g_simdCompare = true;
+            g_kernelName = "simd";
+        } else if (strcmp(a, "--math") == 0) {
+            g_mathCompare = true;
+        } else if (strcmp(a, "--pages") == 0 && next) {
+            if (BenchPageModeFromName(next) < 0) {
+                fprintf(stderr, "unknown page mode %s (default, 4k, thp, 2m, 1g)\n", next);
+                return 1;
+            }
+            SetEnvVar(BENCH_PAGES_ENV, next); i++;
+        } else if (strcmp(a, "--os") == 0) {
+            g_osCosts = true;
+        } else if (strcmp(a, "--sync") == 0) {
+            g_syncTable = true;
+        } else if (strcmp(a, "--alloc") == 0 && next) {
+            if (BenchAllocatorFromName(next) < 0) {
+                fprintf(stderr, "unknown allocator %s (system, pool)\n", next);
+                return 1;
+            }
+            SetEnvVar(BENCH_ALLOC_ENV, next); i++;
+        } else if (strcmp(a, "--malloc") == 0) {
+            g_mallocTable = true;
+        } else if (strcmp(a, "--c2c") == 0) {
+            g_c2cMatrix = true;
+        } else if (strcmp(a, "--numa") == 0) {
+            g_numaMatrix = true;
+        } else if (strcmp(a, "--hugepages") == 0) {
+            g_pagesCompare = true;
+        } else if (strcmp(a, "--latency") == 0) {
+            g_latencySweep = true;
+        } else if (strcmp(a, "--stream") == 0) {
+            g_streamTable = true;
+        } else if (strcmp(a, "--gemm") == 0) {
+            g_gemmSweep = true;
+        } else if (strcmp(a, "--ilp") == 0) {
+            g_ilpSweep = true;
+        } else if (strcmp(a, "--unroll") == 0 && next) {
+            g_ilpUnroll = atoi(next); i++;
+        } else if (strcmp(a, "--threads") == 0 && next) {
+            g_threads = atoi(next); i++;
+        } else if (strcmp(a, "--group-size") == 0 && next) {
+            g_config.simulatedGroupSize = atoi(next); i++;
+        } else if (strcmp(a, "--pin") == 0) {
+            g_config.pinThreads = true;
+        } else if (strcmp(a, "--cores") == 0 && next) {
+            g_coresPath = next; i++;
+        } else if (strcmp(a, "--smt") == 0 && next) {
+            if (strcmp(next, "physical") == 0) g_config.smtMode = BENCH_SMT_PHYSICAL;
+            else if (strcmp(next, "all") == 0) g_config.smtMode = BENCH_SMT_ALL;
+            else if (strcmp(next, "pairs") == 0) g_config.smtMode = BENCH_SMT_PAIRS;
+            else {
+                PrintUsage();
+                return 1;
+            }
+            g_multicore = true;
+            i++;
+        } else if (strcmp(a, "--scaling") == 0 && next) {
+            if (strcmp(next, "pow2") == 0) g_config.scalingMode = BENCH_SCALING_POW2;
+            else if (strcmp(next, "every") == 0) g_config.scalingMode = BENCH_SCALING_EVERY;
+            else {
+                PrintUsage();
+                return 1;
+            }
+            g_multicore = true;
+            i++;
+        } else if (strcmp(a, "--curve") == 0 && next) {
+            g_curvePath = next; i++;
+        } else if (strcmp(a, "--simulate-smt") == 0 && next) {
+            g_config.simulatedSmt = atoi(next); i++;
+        } else if (strcmp(a, "--topology") == 0) {
+            g_showTopology = true;
+        } else if (strcmp(a, "--slow-thread") == 0 && next) {
+            const char* pct = strchr(next, ':');
+            g_config.slowThread = atoi(next);
+            g_config.slowPct = pct ? atoi(pct + 1) : 50;
+            i++;
+        } else if (strcmp(a, "--duration") == 0 && next) {
+            g_config.durationMs = atoi(next);
+            g_durationSet = true;
+            i++;
+        } else if (strcmp(a, "--warmup") == 0 && next) {
+            g_config.warmupMs = atoi(next); i++;
+        } else if (strcmp(a, "--adaptive") == 0) {
+            g_config.adaptive = true;
+        } else if (strcmp(a, "--target") == 0 && next) {
+            g_config.targetPrecision = atof(next) / 100.0; i++;
+        } else if (strcmp(a, "--min") == 0 && next) {
+            g_config.minDurationMs = atoi(next); i++;
+        } else if (strcmp(a, "--max") == 0 && next) {
+            g_config.maxDurationMs = atoi(next); i++;
+        } else if (strcmp(a, "--processes") == 0) {
+            g_processes = true;
+            g_multicore = true;
+        } else if (strcmp(a, "--host") == 0) {
+            g_useHost = true;
+        } else if (strcmp(a, "--repeat") == 0 && next) {
+            g_repeat = atoi(next); i++;
+        } else if (strcmp(a, "--compare-legacy") == 0) {
+            g_compareLegacy = true;
+        } else if (strcmp(a, "--history") == 0 && next) {
+            g_historyPath = next; i++;
+        } else if (strcmp(a, "--series") == 0 && next) {
+            g_seriesPath = next; i++;
+        } else if (strcmp(a, "--analyze") == 0 && next) {
+            g_analyzePath = next; i++;
+        } else if (strcmp(a, "--stress") == 0 && next) {
+            g_stressCycles = atoi(next); i++;
+        } else {
+            PrintUsage();
+            return strcmp(a, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (g_analyzePath) return AnalyzeSeries(g_analyzePath);
+    BenchLoadPlugins();
+    if (g_listKernels) return ListKernels();
+    const BenchKernel* kernel = BenchFindKernel(g_kernelName ? g_kernelName : g_multicore ? "multicore" : "cpu");
+    if (!kernel || kernel->threadModel == BENCH_KERNEL_EXTERNAL) {
+        fprintf(stderr, kernel ? "kernel %s only runs in the GUI\n" : "unknown kernel %s (see --list-kernels)\n", g_kernelName);
+        for (const std::string& e : BenchPluginErrors()) fprintf(stderr, "plugin error: %s\n", e.c_str());
+        return 1;
+    }
+    snprintf(g_config.kernel, sizeof(g_config.kernel), "%s", kernel->name.c_str());
+    snprintf(g_rate, sizeof(g_rate), "M%s/s", kernel->unit.c_str());
+    if (kernel->threadModel != BENCH_KERNEL_SINGLE) g_multicore = true;
+    if (kernel->threadModel == BENCH_KERNEL_SWEEP && g_config.scalingMode == BENCH_SCALING_OFF) {
+        g_config.scalingMode = BENCH_SCALING_POW2;
+    }
+    if (g_repeat < 1) g_repeat = 1;
+    g_config.threadCount = g_multicore ? (g_threads > 0 ? g_threads : DefaultThreadCount()) : 1;
+    if (g_config.threadCount > BENCH_MAX_THREADS) g_config.threadCount = BENCH_MAX_THREADS;
+    if (g_showTopology) return PrintTopology(g_config.threadCount);
+    if (g_stressCycles > 0) return g_useHost ? RunHostStress(g_stressCycles) : RunStress(g_stressCycles);
+    if (g_simdCompare) return RunSimdCompare();
+    if (g_mathCompare) return RunMathCompare();
+    if (g_pagesCompare) return RunPagesCompare();
+    if (g_latencySweep) return RunLatency();
+    if (g_streamTable) return RunStreamTable();
+    if (g_gemmSweep) return RunGemm();
+    if (g_numaMatrix) return RunNuma();
+    if (g_c2cMatrix) return RunC2c();
+    if (g_syncTable) return RunSync();
+    if (g_mallocTable) return RunMalloc();
+    if (g_osCosts) return RunOsCosts();
+    if (g_ilpSweep) {
+        if (!BenchIlpKernel(BENCH_ILP_DOUBLE, 1, g_ilpUnroll)) {
+            fprintf(stderr, "no ILP kernels with unroll %d\n", g_ilpUnroll);
+            return 1;
+        }
+        return RunIlp();
+    }
+
+    if (g_compareLegacy && (g_repeat < 2 || kernel->run != BenchCpuKernel)) {
+        fprintf(stderr, "--compare-legacy needs the cpu or multicore kernel and --repeat 2 or more\n");
+        return 1;
+    }
+    if (g_multicore) PrintCpuCounts(BenchGetTopology());
+    if (g_config.slowThread >= 0) return RunSlowThreadCheck();
+    std::vector<double> scores, legacyScores;
+    for (int r = 0; r < g_repeat; r++) {
+        BenchResult res;
+        if (g_useHost) {
+            if (!RunHosted(g_config, &res)) return 1;
+        } else if (g_processes) {
+            if (!RunProcesses(g_config, &res)) return 1;
+        } else {
+            res = BenchRun(g_config);
+            BenchAllocDrain();  // what an alloc-xthread run left in flight
+            if (!res.completed) {
+                ReportFailedRun(g_config.kernel);
+                return 1;
+            }
+        }
+        scores.push_back(res.score);
+        printf("run %d: %.3f %s +-%.2f%%  (%d threads in %d group(s), %.3f s measured, %d batches, start skew %.1f us)%s\n",
+            r + 1, res.score / 1e6, g_rate, res.stats.precision * 100.0, res.threadCount, res.groupCount, res.elapsedSec,
+            res.stats.batches, (double)res.startSkewNs / 1000.0,
+            res.adaptive ? (res.converged ? "  converged" : "  hit max duration") : "");
+        PrintThrottle(res.throttle, res.series.intervalMs);
+        PrintGroups(res);
+        PrintThreadSpread(res);
+        PrintProcesses(res);
+        PrintCores(res, BenchGetTopology().classCount);
+        PrintSmt(res);
+        PrintScaling(res);
+        if (g_curvePath && res.scaling.mode != BENCH_SCALING_OFF) WriteCurve(g_curvePath, res.scaling);
+        if (g_coresPath && res.pinned) WriteCores(g_coresPath, res);
+        if (g_seriesPath) WriteSeries(g_seriesPath, res.series);
+        AppendHistory(kernel->name.c_str(), res, NULL);
+        if (g_compareLegacy && kernel->run == BenchCpuKernel) {
+            double legacy = RunLegacy(g_config.threadCount, g_config.durationMs);
+            legacyScores.push_back(legacy);
+            printf("        legacy %.3f Mops/s\n", legacy / 1e6);
+        }
+    }
+    if (g_repeat > 1) {
+        double cv = PrintSpread("measured", scores);
+        if (g_compareLegacy) {
+            // The per-thread windows exist to cut run-to-run variance; fail if they don't
+            double legacyCv = PrintSpread("legacy", legacyScores);
+            bool better = cv < legacyCv;
+            printf("run-to-run cv %.3f%% vs legacy %.3f%%\n%s\n", cv * 100.0, legacyCv * 100.0, better ? "OK" : "FAILED");
+            if (!better) return 1;
+        }
+    }
+    return 0;
+}
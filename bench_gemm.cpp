@@ -0,0 +1,262 @@
+// GEMM kernels: C = A * B on square FP64 and FP32 matrices, blocked for the
+// caches the Goto way (B packed once into NR-wide panels, an MC x KC block of A
+// packed per call) around a register-blocked MR x NR micro-kernel in AVX-512,
+// AVX2/FMA or plain C++
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BENCH_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(BENCH_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+// Micro-kernel rows; BENCH_GEMM_PANEL is a multiple of it. Its columns (NR)
+// are two vectors of the ISA, and every size in kSizes is a multiple of both.
+#define GEMM_MR 6
+// Depth of a packed block: an MC x KC block of A stays in L2 and a KC x NR
+// panel of B in L1 while the micro-kernels sweep them
+#define GEMM_KC 256
+
+static const int kSizes[BENCH_GEMM_SIZE_COUNT] = { 192, 384, 768, 1536 };
+
+// ---- micro-kernels: c[MR x NR] += a[MR x kc] * b[kc x NR] ----
+// a is packed column by column (MR values per k), b row by row (NR per k)
+
+template <typename T, int NR>
+static void MicroGeneric(int kc, const T* a, const T* b, T* c, int ldc) {
+    T acc[GEMM_MR][NR] = {};
+    for (int k = 0; k < kc; k++) {
+        for (int r = 0; r < GEMM_MR; r++) {
+            for (int j = 0; j < NR; j++) acc[r][j] += a[r] * b[j];
+        }
+        a += GEMM_MR;
+        b += NR;
+    }
+    for (int r = 0; r < GEMM_MR; r++) {
+        for (int j = 0; j < NR; j++) c[r * ldc + j] += acc[r][j];
+    }
+}
+
+#ifdef BENCH_X86
+
+// Vector operations of one ISA and element type, for the micro-kernel templates
+struct Avx2D {
+    typedef double T; typedef __m256d V; enum { L = 4 };
+    TARGET_AVX2 static V Load(const T* p) { return _mm256_loadu_pd(p); }
+    TARGET_AVX2 static V Splat(T v) { return _mm256_set1_pd(v); }
+    TARGET_AVX2 static V Fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+    TARGET_AVX2 static V Zero() { return _mm256_setzero_pd(); }
+    TARGET_AVX2 static void AddStore(T* p, V v) { _mm256_storeu_pd(p, _mm256_add_pd(_mm256_loadu_pd(p), v)); }
+};
+struct Avx2F {
+    typedef float T; typedef __m256 V; enum { L = 8 };
+    TARGET_AVX2 static V Load(const T* p) { return _mm256_loadu_ps(p); }
+    TARGET_AVX2 static V Splat(T v) { return _mm256_set1_ps(v); }
+    TARGET_AVX2 static V Fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    TARGET_AVX2 static V Zero() { return _mm256_setzero_ps(); }
+    TARGET_AVX2 static void AddStore(T* p, V v) { _mm256_storeu_ps(p, _mm256_add_ps(_mm256_loadu_ps(p), v)); }
+};
+struct Avx512D {
+    typedef double T; typedef __m512d V; enum { L = 8 };
+    TARGET_AVX512 static V Load(const T* p) { return _mm512_loadu_pd(p); }
+    TARGET_AVX512 static V Splat(T v) { return _mm512_set1_pd(v); }
+    TARGET_AVX512 static V Fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+    TARGET_AVX512 static V Zero() { return _mm512_setzero_pd(); }
+    TARGET_AVX512 static void AddStore(T* p, V v) { _mm512_storeu_pd(p, _mm512_add_pd(_mm512_loadu_pd(p), v)); }
+};
+struct Avx512F {
+    typedef float T; typedef __m512 V; enum { L = 16 };
+    TARGET_AVX512 static V Load(const T* p) { return _mm512_loadu_ps(p); }
+    TARGET_AVX512 static V Splat(T v) { return _mm512_set1_ps(v); }
+    TARGET_AVX512 static V Fma(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    TARGET_AVX512 static V Zero() { return _mm512_setzero_ps(); }
+    TARGET_AVX512 static void AddStore(T* p, V v) { _mm512_storeu_ps(p, _mm512_add_ps(_mm512_loadu_ps(p), v)); }
+};
+
+// 6 x 2 vectors: twelve accumulators, two loads of b and six broadcasts of a
+// per k, which leaves the FMA ports as the limit. The same body twice because
+// the target attribute has to sit on the function that uses the intrinsics.
+template <typename S>
+TARGET_AVX2 static void MicroAvx2(int kc, const typename S::T* a, const typename S::T* b, typename S::T* c, int ldc) {
+    typename S::V acc[GEMM_MR][2];
+    for (int r = 0; r < GEMM_MR; r++) acc[r][0] = acc[r][1] = S::Zero();
+    for (int k = 0; k < kc; k++) {
+        typename S::V b0 = S::Load(b), b1 = S::Load(b + S::L);
+        for (int r = 0; r < GEMM_MR; r++) {
+            typename S::V ar = S::Splat(a[r]);
+            acc[r][0] = S::Fma(ar, b0, acc[r][0]);
+            acc[r][1] = S::Fma(ar, b1, acc[r][1]);
+        }
+        a += GEMM_MR;
+        b += 2 * S::L;
+    }
+    for (int r = 0; r < GEMM_MR; r++) {
+        S::AddStore(c + r * ldc, acc[r][0]);
+        S::AddStore(c + r * ldc + S::L, acc[r][1]);
+    }
+}
+
+template <typename S>
+TARGET_AVX512 static void MicroAvx512(int kc, const typename S::T* a, const typename S::T* b, typename S::T* c, int ldc) {
+    typename S::V acc[GEMM_MR][2];
+    for (int r = 0; r < GEMM_MR; r++) acc[r][0] = acc[r][1] = S::Zero();
+    for (int k = 0; k < kc; k++) {
+        typename S::V b0 = S::Load(b), b1 = S::Load(b + S::L);
+        for (int r = 0; r < GEMM_MR; r++) {
+            typename S::V ar = S::Splat(a[r]);
+            acc[r][0] = S::Fma(ar, b0, acc[r][0]);
+            acc[r][1] = S::Fma(ar, b1, acc[r][1]);
+        }
+        a += GEMM_MR;
+        b += 2 * S::L;
+    }
+    for (int r = 0; r < GEMM_MR; r++) {
+        S::AddStore(c + r * ldc, acc[r][0]);
+        S::AddStore(c + r * ldc + S::L, acc[r][1]);
+    }
+}
+
+#endif
+
+// ---- blocking ----
+
+// A, and B packed into NR-wide panels per KC block, shared read-only by every
+// thread; built by the first call for the size
+template <typename T>
+struct GemmShared {
+    std::once_flag once;
+    std::vector<T> a;          // n x n row-major
+    std::vector<T> b;          // block pc at pc * n, panel j of it at j * NR * kc, NR values per k
+};
+
+// Per thread: the packed A block, the C panel and which panel comes next
+template <typename T>
+struct GemmLocal {
+    std::vector<T> a;
+    std::vector<T> c;
+    int64_t panel = 0;
+};
+
+// Deterministic values in [-0.5, 0.5), so C stays small and never denormal
+static double GemmValue(uint64_t i) {
+    i = i * 6364136223846793005ull + 1442695040888963407ull;
+    return (double)(i >> 11) / 9007199254740992.0 - 0.5;
+}
+
+template <typename T, int NR>
+static void GemmSetup(GemmShared<T>* sh, int n) {
+    sh->a.resize((size_t)n * n);
+    std::vector<T> b((size_t)n * n);
+    for (size_t i = 0; i < sh->a.size(); i++) {
+        sh->a[i] = (T)GemmValue(i);
+        b[i] = (T)GemmValue(i + sh->a.size());
+    }
+    sh->b.resize((size_t)n * n);
+    for (int pc = 0; pc < n; pc += GEMM_KC) {
+        int kc = n - pc < GEMM_KC ? n - pc : GEMM_KC;
+        T* block = sh->b.data() + (size_t)pc * n;
+        for (int j = 0; j < n / NR; j++) {
+            for (int k = 0; k < kc; k++) {
+                memcpy(block + (size_t)j * NR * kc + (size_t)k * NR, b.data() + (size_t)(pc + k) * n + j * NR, NR * sizeof(T));
+            }
+        }
+    }
+}
+
+// `iters` panels of BENCH_GEMM_PANEL rows of C = A * B, cycling over the panels
+template <typename T, int NR, void (*Micro)(int, const T*, const T*, T*, int)>
+static double GemmRun(GemmShared<T>* sh, int n, double seed, int64_t iters) {
+    std::call_once(sh->once, GemmSetup<T, NR>, sh, n);
+    static thread_local GemmLocal<T> local;
+    local.a.resize((size_t)BENCH_GEMM_PANEL * GEMM_KC);
+    local.c.resize((size_t)BENCH_GEMM_PANEL * n);
+    const int panels = n / BENCH_GEMM_PANEL;
+    double sum = seed;
+    for (int64_t it = 0; it < iters; it++) {
+        int i0 = (int)(local.panel++ % panels) * BENCH_GEMM_PANEL;
+        T* c = local.c.data();
+        memset(c, 0, local.c.size() * sizeof(T));
+        for (int pc = 0; pc < n; pc += GEMM_KC) {
+            int kc = n - pc < GEMM_KC ? n - pc : GEMM_KC;
+            // Pack the MC x kc block of A into MR-row slivers, one column of MR per k
+            T* ap = local.a.data();
+            for (int ir = 0; ir < BENCH_GEMM_PANEL; ir += GEMM_MR) {
+                for (int k = 0; k < kc; k++) {
+                    for (int r = 0; r < GEMM_MR; r++) *ap++ = sh->a[(size_t)(i0 + ir + r) * n + pc + k];
+                }
+            }
+            const T* block = sh->b.data() + (size_t)pc * n;
+            for (int j = 0; j < n / NR; j++) {
+                for (int ir = 0; ir < BENCH_GEMM_PANEL; ir += GEMM_MR) {
+                    Micro(kc, local.a.data() + (size_t)ir * kc, block + (size_t)j * NR * kc, c + (size_t)ir * n + j * NR, n);
+                }
+            }
+        }
+        sum += c[(it * 7919) % local.c.size()];
+    }
+    return sum;
+}
+
+// Run functions per (type, size, ISA): the size is a template argument so each
+// is a plain BenchKernelRunFn, and its shared matrices a static per instance
+template <typename T, int NR, void (*Micro)(int, const T*, const T*, T*, int), int SizeIndex>
+static double GemmKernel(double seed, int64_t iters) {
+    static GemmShared<T> shared;
+    return GemmRun<T, NR, Micro>(&shared, kSizes[SizeIndex], seed, iters);
+}
+
+template <typename T, int NR, void (*Micro)(int, const T*, const T*, T*, int)>
+static void FillSizes(BenchKernelRunFn* out) {
+    out[0] = GemmKernel<T, NR, Micro, 0>;
+    out[1] = GemmKernel<T, NR, Micro, 1>;
+    out[2] = GemmKernel<T, NR, Micro, 2>;
+    out[3] = GemmKernel<T, NR, Micro, 3>;
+}
+
+int BenchGemmIsa() {
+    int isa = BenchIsaSelected();
+    return isa >= BENCH_ISA_AVX2 ? isa : BENCH_ISA_SCALAR;
+}
+
+const int* BenchGemmSizes(int* count) {
+    *count = BENCH_GEMM_SIZE_COUNT;
+    return kSizes;
+}
+
+BenchKernelRunFn BenchGemmKernel(bool fp32, int size) {
+    int index = -1;
+    for (int i = 0; i < BENCH_GEMM_SIZE_COUNT; i++) {
+        if (kSizes[i] == size) index = i;
+    }
+    if (index < 0) return NULL;
+    BenchKernelRunFn table[BENCH_GEMM_SIZE_COUNT];
+    int isa = BenchGemmIsa();
+#ifdef BENCH_X86
+    if (isa == BENCH_ISA_AVX512) {
+        if (fp32) FillSizes<float, 32, MicroAvx512<Avx512F>>(table);
+        else FillSizes<double, 16, MicroAvx512<Avx512D>>(table);
+        return table[index];
+    }
+    if (isa == BENCH_ISA_AVX2) {
+        if (fp32) FillSizes<float, 16, MicroAvx2<Avx2F>>(table);
+        else FillSizes<double, 8, MicroAvx2<Avx2D>>(table);
+        return table[index];
+    }
+#endif
+    (void)isa;
+    if (fp32) FillSizes<float, 16, MicroGeneric<float, 16>>(table);
+    else FillSizes<double, 8, MicroGeneric<double, 8>>(table);
+    return table[index];
+}
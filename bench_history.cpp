@@ -0,0 +1,49 @@
+// Benchmark history: one line per result appended to a text file, written by
+// the GUI next to its executable and by ReactionTimeBench --history
+#include <stdio.h>
+#include <time.h>
+
+#include "bench.h"
+
+// Longest time series kept in the history file (samples)
+#define BENCH_HISTORY_MAX_SAMPLES 600
+
+bool BenchAppendHistory(const char* path, const char* kernel, double score, double precision, const BenchTimeSeries& series,
+                        const BenchThrottleSummary& throttle, const std::vector<BenchThreadResult>& cores,
+                        const BenchSmtReport& smt, const BenchScalingReport& scaling, const char* extra) {
+    FILE* f = fopen(path, "a");
+    if (!f) return false;
+    time_t now = time(NULL);
+    struct tm* t = localtime(&now);
+    fprintf(f, "%s,%02d/%02d %02d:%02d,%.6f,%.6f,%.2f,%d,%d,",
+        kernel, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, score, precision,
+        throttle.dropPct, throttle.throttled ? 1 : 0, series.intervalMs);
+    int count = (int)series.total.size();
+    if (count > BENCH_HISTORY_MAX_SAMPLES) count = BENCH_HISTORY_MAX_SAMPLES;
+    for (int i = 0; i < count; i++) {
+        fprintf(f, i ? ";%.3f" : "%.3f", series.total[i] / 1000000.0);
+    }
+    if (!cores.empty()) {
+        fprintf(f, ",");
+        for (size_t i = 0; i < cores.size(); i++) {
+            const BenchPlacement& p = cores[i].placement;
+            fprintf(f, "%s%d:%d/%d=%.3f", i ? ";" : "", p.group, p.cpu, p.efficiencyClass, cores[i].opsPerSec / 1000000.0);
+        }
+        if (smt.mode != BENCH_SMT_OFF) {
+            fprintf(f, ",smt:%d:%.3f:%.3f:%.4f", smt.mode, smt.physicalScore / 1000000.0,
+                smt.logicalScore / 1000000.0, smt.yield);
+        }
+    }
+    if (scaling.mode != BENCH_SCALING_OFF) {
+        fprintf(f, ",scaling:%d:%.5f:%.5f:%.7f:%d:", scaling.mode, scaling.fit.serialFraction,
+            scaling.fit.sigma, scaling.fit.kappa, scaling.fit.kneeThreads);
+        for (size_t i = 0; i < scaling.points.size(); i++) {
+            const BenchScalingPoint& p = scaling.points[i];
+            fprintf(f, "%s%d=%.3f/%.4f", i ? ";" : "", p.threads, p.score / 1000000.0, p.efficiency);
+        }
+    }
+    if (extra && *extra) fprintf(f, ",%s", extra);
+    fprintf(f, "\n");
+    fclose(f);
+    return true;
+}
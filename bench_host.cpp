@@ -0,0 +1,1052 @@
+// Out-of-process benchmark host: the shared segment, result serialization and
+// child process management for both sides, and the process-per-core mode
+// built on the same segments and processes
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+extern char** environ;
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "bench_host.h"
+
+#define BENCH_HOST_MAGIC 0x48425452u  // "RTBH"
+#define BENCH_HOST_VERSION 3
+#define BENCH_PROC_MAGIC 0x50425452u  // "RTBP"
+
+enum HostState {
+    HOST_STARTING,             // segment created, child not attached yet
+    HOST_RUNNING,
+    HOST_READY,                // result written
+    HOST_FAILED,               // child could not run the job, see error
+    HOST_CANCELLED
+};
+
+// One progress snapshot; seq is odd while the child is rewriting the slot
+struct HostRecord {
+    std::atomic<uint64_t> seq;
+    BenchProgress progress;
+};
+
+// Everything the two processes share. The parent fills in the job before the
+// child starts; afterwards only the atomics are written by both sides.
+struct HostShared {
+    uint32_t magic;
+    uint32_t version;
+    int32_t job;
+    BenchConfig config;
+    std::atomic<uint32_t> cancel;
+    std::atomic<uint32_t> state;
+    std::atomic<uint64_t> head;        // progress records published
+    HostRecord ring[BENCH_HOST_RING];
+    char error[256];
+    uint64_t resultSize;
+    char result[BENCH_HOST_RESULT_BYTES];
+};
+
+static_assert(std::is_trivially_copyable<BenchConfig>::value, "BenchConfig is copied into the segment");
+static_assert(std::is_trivially_copyable<BenchProgress>::value, "BenchProgress is copied into the segment");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must not need a lock");
+
+// Result serialization. TransferResult walks the fields once for both
+// directions; a vector is its element count followed by the elements.
+struct BlobWriter {
+    std::vector<char> bytes;
+    bool ok = true;
+    template<class T> void Pod(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain data only");
+        const char* p = (const char*)&v;
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+    template<class T> void Resize(std::vector<T>&, uint64_t) {}
+};
+
+struct BlobReader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+    template<class T> void Pod(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "plain data only");
+        if (!ok || (size_t)(end - p) < sizeof(T)) {
+            ok = false;
+            return;
+        }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+    }
+    template<class T> void Resize(std::vector<T>& v, uint64_t n) {
+        // Every element takes at least a byte; a larger count is corrupt
+        if (n > (uint64_t)(end - p)) {
+            ok = false;
+            n = 0;
+        }
+        v.resize((size_t)n);
+    }
+};
+
+template<class A, class T> static void Field(A& a, T& v) {
+    a.Pod(v);
+}
+
+template<class A, class T> static void Field(A& a, std::vector<T>& v) {
+    uint64_t n = v.size();
+    a.Pod(n);
+    if (!a.ok) return;
+    a.Resize(v, n);
+    for (T& e : v) Field(a, e);
+}
+
+// Every BenchResult member, in declaration order; keep in step with bench.h
+template<class A> static void TransferResult(A& a, BenchResult& r) {
+    Field(a, r.completed);
+    Field(a, r.threadCount);
+    Field(a, r.groupCount);
+    Field(a, r.logicalCount);
+    Field(a, r.effectiveCount);
+    Field(a, r.score);
+    Field(a, r.elapsedSec);
+    Field(a, r.totalOps);
+    Field(a, r.startSkewNs);
+    Field(a, r.stats);
+    Field(a, r.adaptive);
+    Field(a, r.converged);
+    Field(a, r.series.intervalMs);
+    Field(a, r.series.warmupSamples);
+    Field(a, r.series.total);
+    Field(a, r.series.perThread);
+    Field(a, r.throttle);
+    Field(a, r.threads);
+    Field(a, r.spread.min);
+    Field(a, r.spread.median);
+    Field(a, r.spread.max);
+    Field(a, r.spread.cv);
+    Field(a, r.spread.stragglers);
+    Field(a, r.pinned);
+    Field(a, r.classes);
+    Field(a, r.smt.mode);
+    Field(a, r.smt.physicalScore);
+    Field(a, r.smt.logicalScore);
+    Field(a, r.smt.yield);
+    Field(a, r.smt.pairs);
+    Field(a, r.scaling.mode);
+    Field(a, r.scaling.points);
+    Field(a, r.scaling.fit);
+    Field(a, r.processes);
+    Field(a, r.threadedScore);
+}
+
+// A named shared mapping. The creator keeps `handle` on Windows so the name
+// stays valid until every other process has opened it.
+struct SharedMapping {
+    void* base = NULL;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE handle = NULL;
+#endif
+};
+
+// Create (parent) or open (child) a shared segment of `size` bytes by name
+static bool MapShared(const char* name, size_t size, bool create, SharedMapping* m) {
+#ifdef _WIN32
+    HANDLE mapping = create
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name)
+        : OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (!mapping) return false;
+    if (create && GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (create && view) m->handle = mapping;
+    else CloseHandle(mapping);
+    m->base = view;
+#else
+    int fd = shm_open(name, create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+    if (fd < 0) return false;
+    if (create && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        if (create) shm_unlink(name);
+        return false;
+    }
+    m->base = mem;
+#endif
+    m->size = size;
+    return m->base != NULL;
+}
+
+// Drop the name once every process has the segment mapped, so nothing is
+// left behind if this process dies
+static void ReleaseSharedName(const char* name, SharedMapping* m) {
+#ifdef _WIN32
+    (void)name;
+    if (m->handle) CloseHandle(m->handle);
+    m->handle = NULL;
+#else
+    (void)m;
+    shm_unlink(name);
+#endif
+}
+
+static void UnmapShared(SharedMapping* m) {
+    if (!m->base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(m->base);
+    if (m->handle) CloseHandle(m->handle);
+    m->handle = NULL;
+#else
+    munmap(m->base, m->size);
+#endif
+    m->base = NULL;
+}
+
+// A child copy of this executable
+struct HostProcess {
+#ifdef _WIN32
+    HANDLE handle = NULL;
+    HANDLE job = NULL;         // kills the child if this process dies
+#else
+    pid_t pid = 0;
+    int status = 0;
+#endif
+    bool exited = false;
+};
+
+// Launch `exePath` (NULL: this executable) with `arg segment [extra]`
+static bool SpawnSelf(HostProcess* p, const char* exePath, const char* arg, const char* segment, const char* extra) {
+    *p = HostProcess();
+#ifdef _WIN32
+    char exe[MAX_PATH];
+    if (exePath) snprintf(exe, sizeof(exe), "%s", exePath);
+    else if (!GetModuleFileNameA(NULL, exe, sizeof(exe))) return false;
+    char cmd[MAX_PATH + 160];
+    snprintf(cmd, sizeof(cmd), "\"%s\" %s %s%s%s", exe, arg, segment, extra ? " " : "", extra ? extra : "");
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessA(exe, cmd, NULL, NULL, FALSE, CREATE_SUSPENDED, NULL, NULL, &si, &pi)) return false;
+    p->job = CreateJobObjectA(NULL, NULL);
+    if (p->job) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+        limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        SetInformationJobObject(p->job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+        AssignProcessToJobObject(p->job, pi.hProcess);
+    }
+    ResumeThread(pi.hThread);
+    CloseHandle(pi.hThread);
+    p->handle = pi.hProcess;
+    return true;
+#else
+    char exe[4096];
+    if (exePath) {
+        snprintf(exe, sizeof(exe), "%s", exePath);
+    } else {
+        ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        if (n <= 0) return false;
+        exe[n] = '\0';
+    }
+    std::string a = arg, seg = segment, x = extra ? extra : "";
+    char* argv[] = { exe, &a[0], &seg[0], extra ? &x[0] : NULL, NULL };
+    return posix_spawn(&p->pid, exe, NULL, NULL, argv, environ) == 0;
+#endif
+}
+
+static bool ProcessExited(HostProcess* p) {
+    if (p->exited) return true;
+#ifdef _WIN32
+    p->exited = WaitForSingleObject(p->handle, 0) == WAIT_OBJECT_0;
+#else
+    int status = 0;
+    if (waitpid(p->pid, &status, WNOHANG) == p->pid) {
+        p->status = status;
+        p->exited = true;
+    }
+#endif
+    return p->exited;
+}
+
+static bool WaitProcess(HostProcess* p, int ms) {
+#ifdef _WIN32
+    if (!p->exited) p->exited = WaitForSingleObject(p->handle, (DWORD)(ms > 0 ? ms : 0)) == WAIT_OBJECT_0;
+    return p->exited;
+#else
+    int64_t deadline = BenchNowNs() + (int64_t)ms * 1000000;
+    while (!ProcessExited(p)) {
+        if (BenchNowNs() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+#endif
+}
+
+static void KillProcess(HostProcess* p) {
+    if (p->exited) return;
+#ifdef _WIN32
+    TerminateProcess(p->handle, 1);
+    WaitForSingleObject(p->handle, INFINITE);
+#else
+    kill(p->pid, SIGKILL);
+    waitpid(p->pid, &p->status, 0);
+#endif
+    p->exited = true;
+}
+
+static void CloseProcess(HostProcess* p) {
+#ifdef _WIN32
+    if (p->handle) CloseHandle(p->handle);
+    if (p->job) CloseHandle(p->job);
+#endif
+    *p = HostProcess();
+}
+
+// True for an exited child that returned 0
+static bool ExitedCleanly(const HostProcess& p) {
+    if (!p.exited) return false;
+#ifdef _WIN32
+    DWORD code = 1;
+    GetExitCodeProcess(p.handle, &code);
+    return code == 0;
+#else
+    return WIFEXITED(p.status) && WEXITSTATUS(p.status) == 0;
+#endif
+}
+
+// How a child ended when it did not deliver a result, e.g. "benchmark host
+// killed by signal 11 (Segmentation fault)"
+static std::string DescribeExit(const HostProcess& p, const char* what) {
+    char buf[160];
+#ifdef _WIN32
+    DWORD code = 0;
+    GetExitCodeProcess(p.handle, &code);
+    snprintf(buf, sizeof(buf), "%s exited with code 0x%08lx", what, (unsigned long)code);
+#else
+    if (WIFSIGNALED(p.status))
+        snprintf(buf, sizeof(buf), "%s killed by signal %d (%s)", what, WTERMSIG(p.status), strsignal(WTERMSIG(p.status)));
+    else
+        snprintf(buf, sizeof(buf), "%s exited with code %d", what, WEXITSTATUS(p.status));
+#endif
+    return buf;
+}
+
+// ---- Child side ----
+
+static void Publish(HostShared* sh, const BenchProgress& p) {
+    uint64_t h = sh->head.load(std::memory_order_relaxed);
+    HostRecord& rec = sh->ring[h % BENCH_HOST_RING];
+    rec.seq.store(2 * h + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    rec.progress = p;
+    rec.seq.store(2 * h + 2, std::memory_order_release);
+    sh->head.store(h + 1, std::memory_order_release);
+}
+
+static int FailJob(SharedMapping* m, const char* why) {
+    HostShared* sh = (HostShared*)m->base;
+    snprintf(sh->error, sizeof(sh->error), "%s", why);
+    sh->state.store(HOST_FAILED, std::memory_order_release);
+    UnmapShared(m);
+    return 3;
+}
+
+BenchHostJob BenchHostCpuJob() {
+    BenchHostJob job = { BenchStart, BenchIsDone, BenchGetProgress, BenchGetResult, BenchCancel, BenchRunError };
+    return job;
+}
+
+int BenchHostMain(const char* segment, const BenchHostJob* jobs, int jobCount) {
+    SharedMapping m;
+    if (!MapShared(segment, sizeof(HostShared), false, &m)) return 2;
+    HostShared* sh = (HostShared*)m.base;
+    if (sh->magic != BENCH_HOST_MAGIC || sh->version != BENCH_HOST_VERSION) {
+        UnmapShared(&m);
+        return 2;
+    }
+#ifdef __linux__
+    // Don't outlive a parent that dies without cancelling
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    if (sh->job < 0 || sh->job >= jobCount || !jobs[sh->job].start)
+        return FailJob(&m, "this executable cannot run the requested benchmark");
+    const BenchHostJob& job = jobs[sh->job];
+    sh->state.store(HOST_RUNNING, std::memory_order_release);
+    BenchConfig cfg = sh->config;
+    cfg.kernel[sizeof(cfg.kernel) - 1] = '\0';
+    if (!BenchFindKernel(cfg.kernel)) {
+        std::string why = std::string("this executable has no kernel named ") + cfg.kernel;
+        return FailJob(&m, why.c_str());
+    }
+    if (!job.start(cfg)) return FailJob(&m, job.error && job.error()[0] ? job.error() : "the benchmark could not start");
+
+    while (!job.isDone()) {
+        if (sh->cancel.load(std::memory_order_acquire)) {
+            job.cancel();
+            sh->state.store(HOST_CANCELLED, std::memory_order_release);
+            UnmapShared(&m);
+            return 4;
+        }
+        Publish(sh, job.progress());
+        std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_HOST_PUBLISH_MS));
+    }
+    Publish(sh, job.progress());
+
+    BenchResult r = job.result();
+    if (!r.completed && job.error && job.error()[0]) return FailJob(&m, job.error());
+    BlobWriter w;
+    TransferResult(w, r);
+    if (w.bytes.size() > sizeof(sh->result)) {
+        // The per-thread series is the only part that grows with threads x time
+        r.series.perThread.clear();
+        w = BlobWriter();
+        TransferResult(w, r);
+    }
+    if (w.bytes.size() > sizeof(sh->result)) return FailJob(&m, "the result does not fit the shared segment");
+    memcpy(sh->result, w.bytes.data(), w.bytes.size());
+    sh->resultSize = w.bytes.size();
+    sh->state.store(HOST_READY, std::memory_order_release);
+    UnmapShared(&m);
+    return 0;
+}
+
+// ---- Parent side ----
+
+static SharedMapping g_hostMap;
+static HostShared* g_shared = NULL;
+static char g_segmentName[64];
+static bool g_hostActive = false;
+static bool g_segmentUnlinked = false;
+static BenchConfig g_hostCfg;
+static BenchProgress g_lastProgress = {};
+static std::string g_hostError;
+static HostProcess g_child;
+
+// The child has the segment mapped once it leaves STARTING
+static void ReleaseSegmentName() {
+    if (!g_segmentUnlinked) ReleaseSharedName(g_segmentName, &g_hostMap);
+    g_segmentUnlinked = true;
+}
+
+static void CloseHost() {
+    ReleaseSegmentName();
+    UnmapShared(&g_hostMap);
+    g_shared = NULL;
+    CloseProcess(&g_child);
+    g_hostActive = false;
+}
+
+static void KillHostAtExit() {
+    if (!g_hostActive) return;
+    KillProcess(&g_child);
+    CloseHost();
+}
+
+// Unique per process and call, e.g. "/rtbench-1234-1"
+static void MakeSegmentName(char* buf, size_t size, const char* kind) {
+    static int s_segments = 0;
+#ifdef _WIN32
+    snprintf(buf, size, "Local\\RTBench%s-%lu-%d", kind, (unsigned long)GetCurrentProcessId(), ++s_segments);
+#else
+    snprintf(buf, size, "/rtbench%s-%d-%d", kind, (int)getpid(), ++s_segments);
+#endif
+}
+
+bool BenchHostStart(const BenchConfig& cfg, int job, const char* exePath) {
+    if (g_hostActive) return false;
+    static bool s_atexit = false;
+    if (!s_atexit) {
+        atexit(KillHostAtExit);
+        s_atexit = true;
+    }
+    MakeSegmentName(g_segmentName, sizeof(g_segmentName), "");
+    g_hostError.clear();
+    g_segmentUnlinked = false;
+    if (!MapShared(g_segmentName, sizeof(HostShared), true, &g_hostMap)) {
+        g_hostError = "cannot create the shared memory segment";
+        return false;
+    }
+    g_shared = (HostShared*)g_hostMap.base;
+    g_shared->magic = BENCH_HOST_MAGIC;
+    g_shared->version = BENCH_HOST_VERSION;
+    g_shared->job = job;
+    g_shared->config = cfg;
+    g_shared->cancel.store(0, std::memory_order_relaxed);
+    g_shared->head.store(0, std::memory_order_relaxed);
+    g_shared->state.store(HOST_STARTING, std::memory_order_release);
+    if (!SpawnSelf(&g_child, exePath, BENCH_HOST_ARG, g_segmentName, NULL)) {
+        g_hostError = "cannot launch the benchmark host process";
+        CloseHost();
+        return false;
+    }
+    g_hostCfg = cfg;
+    g_lastProgress = BenchProgress();
+    g_lastProgress.phase = BENCH_PHASE_STARTING;
+    g_lastProgress.runPhaseCount = 1;
+    g_lastProgress.totalNs = ((int64_t)cfg.warmupMs + (cfg.adaptive ? cfg.maxDurationMs : cfg.durationMs)) * 1000000;
+    g_hostActive = true;
+    return true;
+}
+
+bool BenchHostIsDone() {
+    if (!g_hostActive) return true;
+    uint32_t state = g_shared->state.load(std::memory_order_acquire);
+    if (state != HOST_STARTING) ReleaseSegmentName();
+    return state == HOST_READY || state == HOST_FAILED || ProcessExited(&g_child);
+}
+
+BenchProgress BenchHostGetProgress() {
+    if (!g_hostActive) {
+        BenchProgress idle = {};
+        idle.phase = BENCH_PHASE_IDLE;
+        idle.runPhaseCount = 1;
+        return idle;
+    }
+    // Latest record; retry if the child rewrote the slot while it was copied
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint64_t h = g_shared->head.load(std::memory_order_acquire);
+        if (h == 0) break;
+        HostRecord& rec = g_shared->ring[(h - 1) % BENCH_HOST_RING];
+        uint64_t s1 = rec.seq.load(std::memory_order_acquire);
+        if (s1 != 2 * (h - 1) + 2) continue;
+        BenchProgress p = rec.progress;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (rec.seq.load(std::memory_order_relaxed) != s1) continue;
+        g_lastProgress = p;
+        break;
+    }
+    return g_lastProgress;
+}
+
+BenchResult BenchHostGetResult() {
+    BenchResult r;
+    if (!g_hostActive) return r;
+    // The child exits right after publishing its result
+    if (!WaitProcess(&g_child, 1000)) KillProcess(&g_child);
+    uint32_t state = g_shared->state.load(std::memory_order_acquire);
+    if (state == HOST_READY) {
+        BlobReader rd;
+        rd.p = g_shared->result;
+        rd.end = g_shared->result + (g_shared->resultSize < sizeof(g_shared->result) ? g_shared->resultSize : sizeof(g_shared->result));
+        TransferResult(rd, r);
+        if (!rd.ok) {
+            r = BenchResult();
+            g_hostError = "the benchmark host returned a corrupt result";
+        }
+    } else if (state == HOST_FAILED) {
+        g_shared->error[sizeof(g_shared->error) - 1] = '\0';
+        g_hostError = g_shared->error;
+    } else {
+        g_hostError = DescribeExit(g_child, "benchmark host");
+    }
+    CloseHost();
+    return r;
+}
+
+int64_t BenchHostCancel() {
+    if (!g_hostActive) return 0;
+    int64_t t0 = BenchNowNs();
+    g_shared->cancel.store(1, std::memory_order_release);
+    if (!WaitProcess(&g_child, BENCH_CANCEL_BOUND_MS)) KillProcess(&g_child);
+    int64_t latency = BenchNowNs() - t0;
+    CloseHost();
+    return latency;
+}
+
+const char* BenchHostError() {
+    return g_hostError.c_str();
+}
+
+// ---- Process-per-core ----
+
+// One worker process; a cache line of its own so the counters the parent
+// polls are not falsely shared
+struct alignas(64) ProcSlot {
+    std::atomic<int64_t> ops;          // published after every chunk
+    std::atomic<uint32_t> finished;    // result below is complete
+    BenchThreadResult result;
+};
+
+// The parent fills in the header and plan before any worker starts
+struct ProcShared {
+    uint32_t magic;
+    uint32_t version;
+    BenchConfig config;
+    int32_t workers;
+    uint32_t applyPlacement;           // 0 on a simulated layout
+    std::atomic<int32_t> arrived;
+    std::atomic<uint32_t> go;
+    std::atomic<uint32_t> cancel;
+    std::atomic<int64_t> releaseNs;
+    std::atomic<int64_t> warmupEndNs;
+    std::atomic<int64_t> stopNs;       // adaptive runs pull this in early
+    BenchPlacement plan[BENCH_MAX_THREADS];
+    ProcSlot slots[BENCH_MAX_THREADS];
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free, "shared atomics must not need a lock");
+
+// The chunked loop of the threaded workers, against the shared barrier and
+// stop stamp instead of the pool's
+int BenchProcWorkerMain(const char* segment, int index) {
+    SharedMapping m;
+    if (!MapShared(segment, sizeof(ProcShared), false, &m)) return 2;
+    ProcShared* sh = (ProcShared*)m.base;
+    if (sh->magic != BENCH_PROC_MAGIC || sh->version != BENCH_HOST_VERSION || index < 0 || index >= sh->workers) {
+        UnmapShared(&m);
+        return 2;
+    }
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    BenchConfig cfg = sh->config;
+    cfg.kernel[sizeof(cfg.kernel) - 1] = '\0';
+    const BenchKernel* kernel = BenchFindKernel(cfg.kernel);
+    if (!kernel || !kernel->run) {
+        UnmapShared(&m);
+        return 3;
+    }
+    ProcSlot& slot = sh->slots[index];
+    if (sh->applyPlacement) BenchApplyPlacement(sh->plan[index], cfg.pinThreads);
+    sh->arrived.fetch_add(1, std::memory_order_acq_rel);
+    while (!sh->go.load(std::memory_order_acquire)) {
+        if (sh->cancel.load(std::memory_order_relaxed)) {
+            UnmapShared(&m);
+            return 4;
+        }
+        std::this_thread::yield();
+    }
+    const int64_t release = sh->releaseNs.load(std::memory_order_relaxed);
+    const int64_t warmupEnd = sh->warmupEndNs.load(std::memory_order_relaxed);
+
+    const int64_t chunkTargetNs = (int64_t)BENCH_CHUNK_TARGET_US * 1000;
+    double x = 1.0 + index;
+    int64_t chunk = BENCH_CHUNK_MIN_OPS;
+    int64_t ops = 0, startOps = 0, startNs = 0;
+    int64_t now = BenchNowNs();
+    bool measuring = now >= warmupEnd;
+    if (measuring) startNs = now;
+    while (true) {
+        x = kernel->run(x, chunk);
+        ops += chunk;
+        slot.ops.store(ops, std::memory_order_relaxed);
+        if (sh->cancel.load(std::memory_order_relaxed)) {
+            UnmapShared(&m);
+            return 4;
+        }
+        int64_t prev = now;
+        now = BenchNowNs();
+        if (now - prev < chunkTargetNs / 2 && chunk < BENCH_CHUNK_MAX_OPS) chunk *= 2;
+        else if (now - prev > chunkTargetNs * 2 && chunk > BENCH_CHUNK_MIN_OPS) chunk /= 2;
+        if (index == cfg.slowThread && cfg.slowPct > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds((now - prev) * cfg.slowPct / (100 - cfg.slowPct)));
+            now = BenchNowNs();
+        }
+        if (!measuring) {
+            if (now >= warmupEnd) {
+                measuring = true;
+                startNs = now;
+                startOps = ops;
+            }
+        } else if (now >= sh->stopNs.load(std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    BenchThreadResult& r = slot.result;
+    r.ops = ops - startOps;
+    r.startNs = startNs - release;
+    r.stopNs = now - release;
+    r.opsPerSec = (now > startNs) ? (double)r.ops * 1e9 / (double)(now - startNs) : 0.0;
+    r.placement = sh->plan[index];
+    slot.finished.store(1, std::memory_order_release);
+    UnmapShared(&m);
+    return 0;
+}
+
+// Parent: the caller's thread owns g_procActive; the coordinator thread runs
+// both halves and publishes progress and the result under g_procLock
+static std::thread g_procThread;
+static bool g_procActive = false;
+static std::atomic<bool> g_procCancel(false);
+static std::atomic<bool> g_procDone(false);
+static BenchConfig g_procCfg;
+static std::mutex g_procLock;
+static BenchProgress g_procProgress = {};
+static BenchResult g_procResult;
+static std::string g_procError;
+
+static int64_t ProcPhaseNs(const BenchConfig& cfg) {
+    return ((int64_t)cfg.warmupMs + (cfg.adaptive ? cfg.maxDurationMs : cfg.durationMs)) * 1000000;
+}
+
+static void SetProcProgress(const BenchProgress& p) {
+    std::lock_guard<std::mutex> lock(g_procLock);
+    g_procProgress = p;
+}
+
+// First half: the threaded run of the same configuration
+static bool RunThreadedHalf(BenchResult* res) {
+    if (!BenchStart(g_procCfg)) return false;
+    while (!BenchIsDone()) {
+        if (g_procCancel.load(std::memory_order_relaxed)) {
+            BenchCancel();
+            return false;
+        }
+        BenchProgress p = BenchGetProgress();
+        p.runPhase = 0;
+        p.runPhaseCount = 2;
+        p.totalNs = 2 * ProcPhaseNs(g_procCfg);
+        SetProcProgress(p);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    *res = BenchGetResult();
+    return res->completed;
+}
+
+// Op counts of every worker at one instant, relative to the barrier release
+struct ProcSample {
+    int64_t tNs;
+    std::vector<int64_t> ops;
+};
+
+// Batch rates of the summed counters over the measurement phase
+static BenchRateStats ProcRateStats(const std::vector<ProcSample>& samples, int first) {
+    std::vector<double> rates;
+    for (int b = first; b + BENCH_BATCH_INTERVALS < (int)samples.size(); b += BENCH_BATCH_INTERVALS) {
+        const ProcSample& s0 = samples[b];
+        const ProcSample& s1 = samples[b + BENCH_BATCH_INTERVALS];
+        int64_t d = 0;
+        for (size_t i = 0; i < s0.ops.size(); i++) d += s1.ops[i] - s0.ops[i];
+        if (s1.tNs > s0.tNs) rates.push_back((double)d * 1e9 / (double)(s1.tNs - s0.tNs));
+    }
+    return BenchComputeRateStats(rates.data(), (int)rates.size());
+}
+
+// Second half: one process per planned placement, sampled by this thread
+static bool RunProcessHalf(BenchResult* res, std::string* error) {
+    const BenchConfig& cfg = g_procCfg;
+    BenchTopology topo = BenchTopologyFor(cfg);
+    std::vector<BenchPlacement> plan = BenchPlanPlacement(topo, cfg.threadCount);
+    int n = (int)plan.size();
+    char name[64];
+    MakeSegmentName(name, sizeof(name), "w");
+    SharedMapping m;
+    if (!MapShared(name, sizeof(ProcShared), true, &m)) {
+        *error = "cannot create the shared memory segment";
+        return false;
+    }
+    ProcShared* sh = (ProcShared*)m.base;
+    sh->magic = BENCH_PROC_MAGIC;
+    sh->version = BENCH_HOST_VERSION;
+    sh->config = cfg;
+    sh->workers = n;
+    sh->applyPlacement = topo.simulated ? 0 : 1;
+    for (int i = 0; i < n; i++) sh->plan[i] = plan[i];
+    bool named = true;
+
+    std::vector<HostProcess> procs(n);
+    int spawned = 0;
+    bool ok = true;
+    while (ok && spawned < n) {
+        char idx[16];
+        snprintf(idx, sizeof(idx), "%d", spawned);
+        if (SpawnSelf(&procs[spawned], NULL, BENCH_PROC_ARG, name, idx)) {
+            spawned++;
+        } else {
+            *error = "cannot launch a worker process";
+            ok = false;
+        }
+    }
+
+    // Every worker at the barrier, or the reason one never got there
+    const int64_t phaseNs = ProcPhaseNs(cfg);
+    BenchProgress p = {};
+    p.phase = BENCH_PHASE_STARTING;
+    p.runPhase = 1;
+    p.runPhaseCount = 2;
+    p.totalNs = 2 * phaseNs;
+    p.elapsedNs = phaseNs;
+    SetProcProgress(p);
+    int64_t deadline = BenchNowNs() + (int64_t)BENCH_PROC_START_MS * 1000000;
+    while (ok && sh->arrived.load(std::memory_order_acquire) < n) {
+        if (g_procCancel.load(std::memory_order_relaxed)) ok = false;
+        for (int i = 0; ok && i < spawned; i++) {
+            if (ProcessExited(&procs[i])) {
+                *error = DescribeExit(procs[i], "worker process");
+                ok = false;
+            }
+        }
+        if (ok && BenchNowNs() >= deadline) {
+            *error = "worker processes did not reach the start barrier";
+            ok = false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (ok) {
+        ReleaseSharedName(name, &m);
+        named = false;
+    }
+
+    std::vector<ProcSample> samples;
+    bool converged = false;
+    if (ok) {
+        int64_t release = BenchNowNs();
+        int64_t warmupEnd = release + (int64_t)cfg.warmupMs * 1000000;
+        int64_t windowMs = cfg.adaptive ? cfg.maxDurationMs : cfg.durationMs;
+        int64_t minStop = warmupEnd + (int64_t)cfg.minDurationMs * 1000000;
+        const int64_t interval = (int64_t)cfg.sampleIntervalMs * 1000000;
+        const int first = (int)(((int64_t)cfg.warmupMs * 1000000 + interval - 1) / interval);
+        sh->releaseNs.store(release, std::memory_order_relaxed);
+        sh->warmupEndNs.store(warmupEnd, std::memory_order_relaxed);
+        sh->stopNs.store(warmupEnd + windowMs * 1000000, std::memory_order_relaxed);
+        sh->go.store(1, std::memory_order_release);
+
+        // Sample every counter at each interval boundary; the rates use the
+        // read time, so a late wakeup widens an interval but doesn't skew it
+        int64_t nextSample = release;
+        while (true) {
+            int64_t now = BenchNowNs();
+            int finished = 0;
+            int64_t total = 0;
+            for (int i = 0; i < n; i++) {
+                finished += sh->slots[i].finished.load(std::memory_order_acquire) ? 1 : 0;
+                total += sh->slots[i].ops.load(std::memory_order_relaxed);
+            }
+            if (finished == n) break;
+            if (now >= nextSample) {
+                ProcSample s;
+                s.tNs = now - release;
+                s.ops.resize(n);
+                for (int i = 0; i < n; i++) s.ops[i] = sh->slots[i].ops.load(std::memory_order_relaxed);
+                samples.push_back(s);
+                while (nextSample <= now) nextSample += interval;
+            }
+            if (g_procCancel.load(std::memory_order_relaxed)) {
+                ok = false;
+                break;
+            }
+            for (int i = 0; ok && i < n; i++) {
+                if (ProcessExited(&procs[i]) && !sh->slots[i].finished.load(std::memory_order_acquire)) {
+                    *error = DescribeExit(procs[i], "worker process");
+                    ok = false;
+                }
+            }
+            if (!ok) break;
+
+            BenchRateStats st = ProcRateStats(samples, first);
+            if (cfg.adaptive && !converged && now >= minStop && st.batches >= 3 &&
+                st.precision > 0.0 && st.precision <= cfg.targetPrecision) {
+                sh->stopNs.store(now, std::memory_order_relaxed);
+                converged = true;
+            }
+            p.phase = now < warmupEnd ? BENCH_PHASE_WARMUP : BENCH_PHASE_MEASURE;
+            p.elapsedNs = phaseNs + now - release;
+            p.ops = total;
+            p.stats = st;
+            SetProcProgress(p);
+            int64_t wait = nextSample - BenchNowNs();
+            if (wait > 5000000) wait = 5000000;
+            if (wait > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+    }
+
+    // Reap: finished workers exit on their own, the rest are told to stop
+    // and killed past the cancel bound
+    if (!ok) sh->cancel.store(1, std::memory_order_release);
+    int64_t reapDeadline = BenchNowNs() + (int64_t)(ok ? 1000 : BENCH_CANCEL_BOUND_MS) * 1000000;
+    for (int i = 0; i < spawned; i++) {
+        int left = (int)((reapDeadline - BenchNowNs()) / 1000000);
+        if (!WaitProcess(&procs[i], left > 0 ? left : 0)) KillProcess(&procs[i]);
+    }
+    for (int i = 0; i < spawned && ok; i++) {
+        if (!ExitedCleanly(procs[i])) {
+            *error = DescribeExit(procs[i], "worker process");
+            ok = false;
+        }
+    }
+    if (ok) {
+        BenchResult& r = *res;
+        r = BenchResult();
+        r.processes = true;
+        r.threadCount = n;
+        r.logicalCount = topo.logicalCount;
+        r.effectiveCount = topo.effectiveCount;
+        int64_t firstStart = 0, lastStart = 0, lastStop = 0;
+        for (int i = 0; i < n; i++) {
+            const BenchThreadResult& t = sh->slots[i].result;
+            r.threads.push_back(t);
+            if (i == 0 || plan[i].group != plan[i - 1].group) r.groupCount++;
+            r.score += t.opsPerSec;
+            r.totalOps += t.ops;
+            if (i == 0 || t.startNs < firstStart) firstStart = t.startNs;
+            if (i == 0 || t.startNs > lastStart) lastStart = t.startNs;
+            if (i == 0 || t.stopNs > lastStop) lastStop = t.stopNs;
+        }
+        r.elapsedSec = (double)(lastStop - firstStart) / 1e9;
+        r.startSkewNs = lastStart - firstStart;
+        const int64_t interval = (int64_t)cfg.sampleIntervalMs * 1000000;
+        const int first = (int)(((int64_t)cfg.warmupMs * 1000000 + interval - 1) / interval);
+        r.stats = ProcRateStats(samples, first);
+        r.adaptive = cfg.adaptive;
+        r.converged = converged;
+        BenchTimeSeries& ts = r.series;
+        ts.intervalMs = cfg.sampleIntervalMs;
+        ts.warmupSamples = first;
+        int count = samples.size() > 1 ? (int)samples.size() - 1 : 0;
+        ts.total.assign(count, 0.0);
+        ts.perThread.assign(n, std::vector<double>(count, 0.0));
+        for (int k = 0; k < count; k++) {
+            int64_t dt = samples[k + 1].tNs - samples[k].tNs;
+            for (int i = 0; i < n && dt > 0; i++) {
+                double rate = (double)(samples[k + 1].ops[i] - samples[k].ops[i]) * 1e9 / (double)dt;
+                ts.perThread[i][k] = rate;
+                ts.total[k] += rate;
+            }
+        }
+        r.throttle = BenchAnalyzeThrottling(ts.total.data(), (int)ts.total.size(), ts.warmupSamples);
+        r.pinned = cfg.pinThreads && !topo.simulated;
+        if (r.pinned) r.classes = BenchClassScores(r.threads);
+        r.spread = BenchAnalyzeSpread(r.threads, r.pinned);
+        const BenchKernel* kernel = BenchFindKernel(cfg.kernel);
+        if (kernel && kernel->opsPerIter != 1.0) BenchScaleRates(&r, kernel->opsPerIter);
+        r.completed = true;
+    }
+    for (int i = 0; i < spawned; i++) CloseProcess(&procs[i]);
+    if (named) ReleaseSharedName(name, &m);
+    UnmapShared(&m);
+    return ok;
+}
+
+static void ProcCoordinator() {
+    BenchResult threaded, r;
+    std::string error;
+    if (RunThreadedHalf(&threaded) && RunProcessHalf(&r, &error)) {
+        r.threadedScore = threaded.score;
+    } else {
+        r = BenchResult();
+        if (error.empty() && !g_procCancel.load(std::memory_order_relaxed)) error = "the threaded run did not complete";
+    }
+    BenchProgress p = {};
+    p.phase = BENCH_PHASE_DONE;
+    p.runPhase = 1;
+    p.runPhaseCount = 2;
+    p.totalNs = p.elapsedNs = 2 * ProcPhaseNs(g_procCfg);
+    {
+        std::lock_guard<std::mutex> lock(g_procLock);
+        g_procProgress = p;
+        g_procResult = r;
+        g_procError = error;
+    }
+    g_procDone.store(true, std::memory_order_release);
+}
+
+static void CancelProcsAtExit() {
+    BenchProcCancel();
+}
+
+bool BenchProcStart(const BenchConfig& cfg) {
+    if (g_procActive) return false;
+    char kernelName[BENCH_KERNEL_NAME_MAX];
+    memcpy(kernelName, cfg.kernel, sizeof(kernelName));
+    kernelName[sizeof(kernelName) - 1] = '\0';
+    const BenchKernel* kernel = BenchFindKernel(kernelName);
+    if (!kernel || !kernel->run) {
+        g_procError = std::string("unknown kernel ") + kernelName;
+        return false;
+    }
+    static bool s_atexit = false;
+    if (!s_atexit) {
+        atexit(CancelProcsAtExit);
+        s_atexit = true;
+    }
+    g_procCfg = cfg;
+    memcpy(g_procCfg.kernel, kernelName, sizeof(kernelName));
+    if (g_procCfg.threadCount < 1) g_procCfg.threadCount = 1;
+    if (g_procCfg.threadCount > BENCH_MAX_THREADS) g_procCfg.threadCount = BENCH_MAX_THREADS;
+    if (g_procCfg.sampleIntervalMs < 1) g_procCfg.sampleIntervalMs = 1;
+    if (g_procCfg.slowPct < 0) g_procCfg.slowPct = 0;
+    if (g_procCfg.slowPct > 90) g_procCfg.slowPct = 90;
+    // One placement, compared both ways; the sweeps and SMT modes have their own
+    g_procCfg.smtMode = BENCH_SMT_OFF;
+    g_procCfg.scalingMode = BENCH_SCALING_OFF;
+    g_procCancel.store(false, std::memory_order_relaxed);
+    g_procDone.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(g_procLock);
+        g_procProgress = BenchProgress();
+        g_procProgress.phase = BENCH_PHASE_STARTING;
+        g_procProgress.runPhaseCount = 2;
+        g_procProgress.totalNs = 2 * ProcPhaseNs(g_procCfg);
+        g_procResult = BenchResult();
+        g_procError.clear();
+    }
+    g_procThread = std::thread(ProcCoordinator);
+    g_procActive = true;
+    return true;
+}
+
+bool BenchProcIsDone() {
+    return !g_procActive || g_procDone.load(std::memory_order_acquire);
+}
+
+BenchProgress BenchProcGetProgress() {
+    if (!g_procActive) {
+        BenchProgress idle = {};
+        idle.phase = BENCH_PHASE_IDLE;
+        idle.runPhaseCount = 1;
+        return idle;
+    }
+    std::lock_guard<std::mutex> lock(g_procLock);
+    return g_procProgress;
+}
+
+BenchResult BenchProcGetResult() {
+    if (!g_procActive) return BenchResult();
+    g_procThread.join();
+    g_procActive = false;
+    std::lock_guard<std::mutex> lock(g_procLock);
+    return g_procResult;
+}
+
+int64_t BenchProcCancel() {
+    if (!g_procActive) return 0;
+    int64_t t0 = BenchNowNs();
+    g_procCancel.store(true, std::memory_order_relaxed);
+    g_procThread.join();
+    g_procActive = false;
+    return BenchNowNs() - t0;
+}
+
+const char* BenchProcError() {
+    return g_procError.c_str();
+}
+
+BenchHostJob BenchHostProcessJob() {
+    BenchHostJob job = { BenchProcStart, BenchProcIsDone, BenchProcGetProgress, BenchProcGetResult,
+        BenchProcCancel, BenchProcError };
+    return job;
+}
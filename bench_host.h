@@ -0,0 +1,67 @@
+// Out-of-process benchmark host. The parent launches its own executable with
+// BENCH_HOST_ARG and a shared-memory segment name; the child runs one job,
+// publishes progress into a ring in the segment and writes the result back.
+// A kernel or driver that crashes or hangs takes down only the child, and the
+// child has no UI threads competing with the workers.
+#pragma once
+
+#include "bench.h"
+
+#define BENCH_HOST_ARG "--bench-host"
+#define BENCH_HOST_RING 64            // progress records kept in the segment
+#define BENCH_HOST_PUBLISH_MS 10      // child progress interval
+#define BENCH_HOST_RESULT_BYTES (16 << 20)  // serialized result capacity
+
+// A job the child can run, in the shape of the in-process async API
+struct BenchHostJob {
+    bool (*start)(const BenchConfig& cfg);
+    bool (*isDone)();
+    BenchProgress (*progress)();
+    BenchResult (*result)();
+    int64_t (*cancel)();
+    const char* (*error)();        // why start or the run failed; may be NULL
+};
+
+// Job ids index the table handed to BenchHostMain; 0 is always the CPU core
+enum BenchHostJobId {
+    BENCH_HOST_JOB_CPU,
+    BENCH_HOST_JOB_PROCESSES,      // BenchProcStart
+    BENCH_HOST_JOB_GPU             // GUI executable only
+};
+
+// BenchStart / BenchIsDone / ... of the portable core, and the BenchProc* set
+BenchHostJob BenchHostCpuJob();
+BenchHostJob BenchHostProcessJob();
+
+// Child side: map `segment`, run the job the parent asked for from `jobs`,
+// and return the process exit code
+int BenchHostMain(const char* segment, const BenchHostJob* jobs, int jobCount);
+
+// Parent side, one child at a time. `exePath` NULL launches this executable.
+// BenchHostIsDone is also true once the child has died; BenchHostGetResult
+// then returns a result with completed = false and BenchHostError says why.
+bool BenchHostStart(const BenchConfig& cfg, int job, const char* exePath);
+bool BenchHostIsDone();
+BenchProgress BenchHostGetProgress();
+BenchResult BenchHostGetResult();     // reaps the child
+int64_t BenchHostCancel();            // asks the child to stop, kills it after BENCH_CANCEL_BOUND_MS
+const char* BenchHostError();         // "" unless the last start or run failed
+
+// Process-per-core mode: the multicore run with one worker process per thread
+// (own page tables, allocator and cache lines) instead of threads sharing this
+// process. Workers are this executable started with BENCH_PROC_ARG, a segment
+// name and their index; they wait at a start barrier in the segment and
+// publish their op counters there. The threaded run of the same configuration
+// runs first, and the result carries its score in threadedScore.
+#define BENCH_PROC_ARG "--bench-worker"
+#define BENCH_PROC_START_MS 10000     // all workers must reach the barrier by then
+
+bool BenchProcStart(const BenchConfig& cfg);
+bool BenchProcIsDone();
+BenchProgress BenchProcGetProgress();
+BenchResult BenchProcGetResult();     // joins the run; completed = false on failure
+int64_t BenchProcCancel();            // kills workers still running after BENCH_CANCEL_BOUND_MS
+const char* BenchProcError();         // "" unless the last run failed
+
+// Worker side: map `segment`, run as worker `index`, return the exit code
+int BenchProcWorkerMain(const char* segment, int index);
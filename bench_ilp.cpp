@@ -0,0 +1,92 @@
+// ILP kernel family: 1..BENCH_ILP_MAX_CHAINS independent multiply-add chains
+// of float or double, unrolled at compile time, so one sweep over the chain
+// count shows the latency of a step and where the FP ports saturate
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+#include "bench.h"
+
+// A register barrier per step, as in bench_simd.cpp: the chains stay scalar
+// and separate instead of being packed into vectors, which would hide the ILP
+#if (defined(_M_X64) || defined(__x86_64__)) && defined(__GNUC__)
+#define KEEP_SCALAR(v) __asm__ volatile("" : "+x"(v))
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define KEEP_SCALAR(v) __asm__ volatile("" : "+w"(v))
+#else
+#define KEEP_SCALAR(v) (void)(v)
+#endif
+
+#define ILP_MUL 0.999999
+#define ILP_ADD 1e-6
+
+// Unroll factors the family is built with; iteration counts are per unrolled body
+static const int kUnrolls[] = { 1, 4 };
+#define ILP_UNROLL_COUNT 2
+
+template <typename T>
+static inline void IlpChainStep(T& a, T mul, T add) {
+    a = a * mul + add;
+    KEEP_SCALAR(a);
+}
+
+// One step on every chain. The fold keeps every index constant, so the
+// accumulators live in registers rather than in an array.
+template <typename T, size_t... C>
+static inline void IlpStep(T* acc, T mul, T add, std::index_sequence<C...>) {
+    (IlpChainStep(acc[C], mul, add), ...);
+}
+
+template <typename T, size_t... U, size_t... C>
+static inline void IlpBody(T* acc, T mul, T add, std::index_sequence<U...>, std::index_sequence<C...> chains) {
+    ((IlpStep<T>(acc, mul, add, chains), (void)U), ...);
+}
+
+// Every access to acc uses a constant index, including the set-up and the
+// sum, or the compiler keeps the array in memory and stores it every iteration
+template <typename T, int Unroll, size_t... C>
+static double IlpLoop(double seed, int64_t iters, std::index_sequence<C...> chains) {
+    T acc[sizeof...(C)] = { (T)(seed + C * 0.125)... };
+    const T mul = (T)ILP_MUL, add = (T)ILP_ADD;
+    for (int64_t i = 0; i < iters; i++) {
+        IlpBody<T>(acc, mul, add, std::make_index_sequence<Unroll>(), chains);
+    }
+    return (0.0 + ... + (double)acc[C]);
+}
+
+template <typename T, int Chains, int Unroll>
+static double IlpRun(double seed, int64_t iters) {
+    return IlpLoop<T, Unroll>(seed, iters, std::make_index_sequence<Chains>());
+}
+
+// Kernel table of one element type and unroll factor, chains 1..N
+template <typename T, int Unroll, size_t... C>
+static void FillTable(BenchKernelRunFn* out, std::index_sequence<C...>) {
+    ((out[C] = IlpRun<T, (int)C + 1, Unroll>), ...);
+}
+
+struct IlpTable {
+    BenchKernelRunFn run[2][ILP_UNROLL_COUNT][BENCH_ILP_MAX_CHAINS];  // [type][unroll][chains - 1]
+    IlpTable() {
+        typedef std::make_index_sequence<BENCH_ILP_MAX_CHAINS> AllChains;
+        FillTable<double, 1>(run[BENCH_ILP_DOUBLE][0], AllChains());
+        FillTable<double, 4>(run[BENCH_ILP_DOUBLE][1], AllChains());
+        FillTable<float, 1>(run[BENCH_ILP_FLOAT][0], AllChains());
+        FillTable<float, 4>(run[BENCH_ILP_FLOAT][1], AllChains());
+    }
+};
+
+BenchKernelRunFn BenchIlpKernel(int type, int chains, int unroll) {
+    static const IlpTable table;
+    if (type != BENCH_ILP_DOUBLE && type != BENCH_ILP_FLOAT) return NULL;
+    if (chains < 1 || chains > BENCH_ILP_MAX_CHAINS) return NULL;
+    for (int u = 0; u < ILP_UNROLL_COUNT; u++) {
+        if (kUnrolls[u] == unroll) return table.run[type][u][chains - 1];
+    }
+    return NULL;
+}
+
+const int* BenchIlpUnrolls(int* count) {
+    *count = ILP_UNROLL_COUNT;
+    return kUnrolls;
+}
@@ -0,0 +1,202 @@
+// Memory-access kernels: a pointer chase (one dependent load per iteration
+// around a random cycle through every cache line of a working set, from a few
+// KiB to gigabytes, so the rate steps down at each cache level) and random
+// independent updates of a large table, both on the page size BENCH_PAGES_ENV asks for
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "bench.h"
+
+#define LATENCY_LINE 64
+
+// Working sets at most this share of installed memory
+#define LATENCY_MEMORY_SHARE 4
+
+// The random-access table: at most this large, a power of two
+#define RANDOM_MAX_BYTES ((int64_t)1 << 30)
+
+// A line holds the address of the next one; the rest is padding, so every
+// load of the chase is a different cache line
+struct alignas(LATENCY_LINE) LatencyLine {
+    LatencyLine* next;
+};
+
+// The buffer of the kernel and size last run, shared by every thread. It is
+// rebuilt when the kernel, the size or the page mode changes, freeing the old
+// one first, so a sweep never holds two working sets.
+#define BUFFER_CHAIN 0
+#define BUFFER_TABLE 1
+
+static std::mutex g_buildLock;
+static std::atomic<int64_t> g_builtKey(-1);   // bytes | page mode | kind << 3; bytes are whole pages
+static std::atomic<uint32_t> g_generation(0);
+static BenchPages g_pages;
+
+// 4 KiB, 6 KiB, 8 KiB, 12 KiB, ... 4 GiB: powers of two and the points half way between
+static int64_t SizeAt(int index) {
+    int64_t pow2 = (int64_t)4096 << (index / 2);
+    return index % 2 ? pow2 + pow2 / 2 : pow2;
+}
+
+static uint64_t SplitMix(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Sattolo's shuffle gives a single cycle through all `count` lines in random
+// order: the prefetchers see no stride, and no line is left out of the chase
+static void BuildChain(void* base, int64_t bytes) {
+    LatencyLine* lines = (LatencyLine*)base;
+    int64_t count = bytes / LATENCY_LINE;
+    int64_t* order = new int64_t[count];
+    for (int64_t i = 0; i < count; i++) order[i] = i;
+    uint64_t state = (uint64_t)bytes;
+    for (int64_t i = count - 1; i > 0; i--) {
+        int64_t j = (int64_t)(SplitMix(&state) % (uint64_t)i);
+        std::swap(order[i], order[j]);
+    }
+    for (int64_t i = 0; i < count; i++) lines[order[i]].next = &lines[order[(i + 1) % count]];
+    delete[] order;
+}
+
+static void BuildTable(void* base, int64_t bytes) {
+    uint64_t* table = (uint64_t*)base;
+    for (int64_t i = 0; i < bytes / (int64_t)sizeof(uint64_t); i++) table[i] = (uint64_t)i;
+}
+
+static void* Buffer(int kind, int64_t bytes) {
+    int mode = BenchPageModeSelected();
+    int64_t key = bytes | mode | (int64_t)kind << 3;
+    if (g_builtKey.load(std::memory_order_acquire) != key) {
+        std::lock_guard<std::mutex> lock(g_buildLock);
+        if (g_builtKey.load(std::memory_order_relaxed) != key) {
+            BenchFreePages(&g_pages);
+            g_pages = BenchAllocPages((size_t)bytes, mode);
+            if (!g_pages.base) {
+                BenchFailRun("out of memory for the kernel's buffer");
+                return NULL;
+            }
+            if (kind == BUFFER_CHAIN) BuildChain(g_pages.base, bytes);
+            else BuildTable(g_pages.base, bytes);
+            g_generation.fetch_add(1, std::memory_order_relaxed);
+            g_builtKey.store(key, std::memory_order_release);
+        }
+    }
+    return g_pages.base;
+}
+
+// Where this thread is in the chain; a rebuilt chain starts it over. Threads
+// start at different lines of the same cycle.
+struct LatencyCursor {
+    uint32_t generation = 0;
+    LatencyLine* p = NULL;
+};
+
+template <int SizeIndex>
+static double LatencyRun(double seed, int64_t iters) {
+    static thread_local LatencyCursor cursor;
+    const int64_t bytes = SizeAt(SizeIndex);
+    LatencyLine* lines = (LatencyLine*)Buffer(BUFFER_CHAIN, bytes);
+    if (!lines) return seed;
+    uint32_t generation = g_generation.load(std::memory_order_relaxed);
+    if (cursor.generation != generation || !cursor.p) {
+        static std::atomic<int64_t> s_start(0);
+        int64_t count = bytes / LATENCY_LINE;
+        cursor.p = &lines[(s_start.fetch_add(count / 7 + 1, std::memory_order_relaxed)) % count];
+        cursor.generation = generation;
+    }
+    LatencyLine* p = cursor.p;
+    for (int64_t i = 0; i < iters; i++) p = p->next;
+    cursor.p = p;
+    return seed + (double)((uintptr_t)p & 0xff);
+}
+
+// GUPS-style: every iteration XORs a pseudo-random word of the table. The
+// updates are independent, so the rate is set by how many misses (and page
+// walks) the core keeps in flight rather than by one miss's latency. Each
+// worker updates its own power-of-two slice, so plain read-modify-writes
+// never race; one thread gets the whole table.
+static double RandomRun(double seed, int64_t iters) {
+    static thread_local uint64_t t_x = 0;
+    const int64_t bytes = BenchRandomBytes();
+    uint64_t* table = (uint64_t*)Buffer(BUFFER_TABLE, bytes);
+    if (!table) return seed;
+    const uint64_t words = (uint64_t)(bytes / sizeof(uint64_t));
+    const uint64_t share = words / (uint64_t)BenchRunThreads();
+    uint64_t slice = 1;
+    while (slice * 2 <= share) slice *= 2;
+    uint64_t* mine = table + share * (uint64_t)BenchRunWorker();
+    const uint64_t mask = slice - 1;
+    uint64_t x = t_x ? t_x : (uint64_t)(seed * 4096.0) | 1;
+    for (int64_t i = 0; i < iters; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        mine[(x >> 24) & mask] ^= x;
+    }
+    t_x = x;
+    return seed + (double)(x & 0xff);
+}
+
+template <size_t... I>
+static void FillTable(BenchKernelRunFn* out, std::index_sequence<I...>) {
+    ((out[I] = LatencyRun<(int)I>), ...);
+}
+
+int BenchLatencySizeCount() {
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    int n = 0;
+    while (n < BENCH_LATENCY_MAX_SIZES &&
+           (caches.memory <= 0 || SizeAt(n) <= caches.memory / LATENCY_MEMORY_SHARE)) n++;
+    return n;
+}
+
+int64_t BenchLatencySize(int index) {
+    return index >= 0 && index < BENCH_LATENCY_MAX_SIZES ? SizeAt(index) : 0;
+}
+
+void BenchLatencyName(int index, char* buf, size_t size) {
+    int64_t bytes = BenchLatencySize(index);
+    if (bytes % ((int64_t)1 << 30) == 0) snprintf(buf, size, "latency-%dg", (int)(bytes >> 30));
+    else if (bytes % ((int64_t)1 << 20) == 0) snprintf(buf, size, "latency-%dm", (int)(bytes >> 20));
+    else snprintf(buf, size, "latency-%dk", (int)(bytes >> 10));
+}
+
+int64_t BenchRandomBytes() {
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    int64_t bytes = RANDOM_MAX_BYTES;
+    while (caches.memory > 0 && bytes > ((int64_t)1 << 20) && bytes > caches.memory / LATENCY_MEMORY_SHARE) bytes /= 2;
+    return bytes;
+}
+
+BenchKernelRunFn BenchRandomKernel() {
+    return RandomRun;
+}
+
+void BenchBuildChase(void* base, int64_t bytes) {
+    BuildChain(base, bytes);
+}
+
+void* BenchChase(void* p, int64_t loads) {
+    LatencyLine* line = (LatencyLine*)p;
+    for (int64_t i = 0; i < loads; i++) line = line->next;
+    return line;
+}
+
+BenchPages BenchLastMemoryPages() {
+    std::lock_guard<std::mutex> lock(g_buildLock);
+    return g_pages;
+}
+
+struct LatencyTable {
+    BenchKernelRunFn run[BENCH_LATENCY_MAX_SIZES];
+    LatencyTable() { FillTable(run, std::make_index_sequence<BENCH_LATENCY_MAX_SIZES>()); }
+};
+
+BenchKernelRunFn BenchLatencyKernel(int index) {
+    static const LatencyTable table;
+    return index >= 0 && index < BenchLatencySizeCount() ? table.run[index] : NULL;
+}
@@ -0,0 +1,336 @@
+// Math kernels: the CPU kernel's sin(x) * cos(x) + sqrt(x + 1) through libm,
+// through a polynomial sincos (AVX2/FMA where available), and through a cheaper
+// approximation, with their error in ULP against a long double reference
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BENCH_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(BENCH_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#endif
+
+// sin and cos of |x| up to this are checked, on this many evenly spaced points
+#define MATH_TEST_RANGE 100.0
+#define MATH_TEST_POINTS (1 << 18)
+
+// pi/2 in three parts (fdlibm): q * MATH_PIO2_1 is exact for |q| < 2^20, and
+// the two smaller parts carry the bits the first one drops
+#define MATH_2_PI 0.63661977236758134308
+#define MATH_PIO2_1 1.57079632673412561417e+00
+#define MATH_PIO2_2 6.07710050630396597660e-11
+#define MATH_PIO2_3 2.02226624879595063154e-21
+#define MATH_PIO2 1.57079632679489661923
+
+// Cephes minimax coefficients on [-pi/4, pi/4], highest power first:
+// sin r = r + r^3 * S(r^2), cos r = 1 - r^2 / 2 + r^4 * C(r^2)
+static const double kSin[6] = {
+    1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+    -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1
+};
+static const double kCos[6] = {
+    -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+    2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2
+};
+
+// The approximation: Taylor terms up to r^7 and r^6, one-part reduction
+static const double kSinFast[3] = { -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0 };
+static const double kCosFast[2] = { -1.0 / 720.0, 1.0 / 24.0 };
+
+// Start of each lane; the recurrence stays near 1.8 whatever the seed
+#define LANE_OFFSET 0.125
+
+// ---- scalar versions, also the fallback without AVX2 ----
+
+static inline void SinCosPoly(double x, double* s, double* c) {
+    double q = nearbyint(x * MATH_2_PI);
+    double r = ((x - q * MATH_PIO2_1) - q * MATH_PIO2_2) - q * MATH_PIO2_3;
+    double r2 = r * r;
+    double sp = kSin[0], cp = kCos[0];
+    for (int i = 1; i < 6; i++) {
+        sp = sp * r2 + kSin[i];
+        cp = cp * r2 + kCos[i];
+    }
+    double sr = r + r * r2 * sp;
+    double cr = 1.0 - 0.5 * r2 + r2 * r2 * cp;
+    int64_t qi = (int64_t)q;
+    double sv = (qi & 1) ? cr : sr, cv = (qi & 1) ? sr : cr;
+    *s = (qi & 2) ? -sv : sv;
+    *c = ((qi + 1) & 2) ? -cv : cv;
+}
+
+static inline void SinCosFast(double x, double* s, double* c) {
+    double q = nearbyint(x * MATH_2_PI);
+    double r = x - q * MATH_PIO2;
+    double r2 = r * r;
+    double sr = r + r * r2 * ((kSinFast[0] * r2 + kSinFast[1]) * r2 + kSinFast[2]);
+    double cr = 1.0 - 0.5 * r2 + r2 * r2 * (kCosFast[0] * r2 + kCosFast[1]);
+    int64_t qi = (int64_t)q;
+    double sv = (qi & 1) ? cr : sr, cv = (qi & 1) ? sr : cr;
+    *s = (qi & 2) ? -sv : sv;
+    *c = ((qi + 1) & 2) ? -cv : cv;
+}
+
+// Reciprocal square root from the exponent bit trick and two Newton steps
+static inline double SqrtFast(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits = 0x5fe6eb50c7b537a9ull - (bits >> 1);
+    double y;
+    memcpy(&y, &bits, sizeof(y));
+    y = y * (1.5 - 0.5 * v * y * y);
+    y = y * (1.5 - 0.5 * v * y * y);
+    return v * y;
+}
+
+static double RunLibm(double seed, int64_t iters) {
+    double x[BENCH_MATH_LANES];
+    for (int j = 0; j < BENCH_MATH_LANES; j++) x[j] = seed + j * LANE_OFFSET;
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < BENCH_MATH_LANES; j++) x[j] = sin(x[j]) * cos(x[j]) + sqrt(x[j] + 1.0);
+    }
+    double sum = 0.0;
+    for (int j = 0; j < BENCH_MATH_LANES; j++) sum += x[j];
+    return sum;
+}
+
+static double RunPolyScalar(double seed, int64_t iters) {
+    double x[BENCH_MATH_LANES];
+    for (int j = 0; j < BENCH_MATH_LANES; j++) x[j] = seed + j * LANE_OFFSET;
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < BENCH_MATH_LANES; j++) {
+            double s, c;
+            SinCosPoly(x[j], &s, &c);
+            x[j] = s * c + sqrt(x[j] + 1.0);
+        }
+    }
+    double sum = 0.0;
+    for (int j = 0; j < BENCH_MATH_LANES; j++) sum += x[j];
+    return sum;
+}
+
+static double RunFastScalar(double seed, int64_t iters) {
+    double x[BENCH_MATH_LANES];
+    for (int j = 0; j < BENCH_MATH_LANES; j++) x[j] = seed + j * LANE_OFFSET;
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < BENCH_MATH_LANES; j++) {
+            double s, c;
+            SinCosFast(x[j], &s, &c);
+            x[j] = s * c + SqrtFast(x[j] + 1.0);
+        }
+    }
+    double sum = 0.0;
+    for (int j = 0; j < BENCH_MATH_LANES; j++) sum += x[j];
+    return sum;
+}
+
+#ifdef BENCH_X86
+
+// ---- AVX2/FMA versions, four lanes per vector ----
+
+// Quadrant swap and signs from the low bits of q, which sits in the low
+// mantissa bits of qd = x * 2/pi + 1.5 * 2^52 (negative q wraps mod 4 too)
+TARGET_AVX2 static inline void Quadrant(__m256d qd, __m256d sr, __m256d cr, __m256d* s, __m256d* c) {
+    const __m256i one = _mm256_set1_epi64x(1), two = _mm256_set1_epi64x(2);
+    __m256i qi = _mm256_castpd_si256(qd);
+    __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(qi, one), one));
+    __m256d sv = _mm256_blendv_pd(sr, cr, swap), cv = _mm256_blendv_pd(cr, sr, swap);
+    __m256i signS = _mm256_slli_epi64(_mm256_and_si256(qi, two), 62);
+    __m256i signC = _mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(qi, one), two), 62);
+    *s = _mm256_xor_pd(sv, _mm256_castsi256_pd(signS));
+    *c = _mm256_xor_pd(cv, _mm256_castsi256_pd(signC));
+}
+
+TARGET_AVX2 static inline void SinCosPoly4(__m256d x, __m256d* s, __m256d* c) {
+    const __m256d shifter = _mm256_set1_pd(6755399441055744.0);  // 1.5 * 2^52
+    __m256d qd = _mm256_fmadd_pd(x, _mm256_set1_pd(MATH_2_PI), shifter);
+    __m256d q = _mm256_sub_pd(qd, shifter);
+    __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(MATH_PIO2_1), x);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(MATH_PIO2_2), r);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(MATH_PIO2_3), r);
+    __m256d r2 = _mm256_mul_pd(r, r);
+    __m256d sp = _mm256_set1_pd(kSin[0]), cp = _mm256_set1_pd(kCos[0]);
+    for (int i = 1; i < 6; i++) {
+        sp = _mm256_fmadd_pd(sp, r2, _mm256_set1_pd(kSin[i]));
+        cp = _mm256_fmadd_pd(cp, r2, _mm256_set1_pd(kCos[i]));
+    }
+    __m256d sr = _mm256_fmadd_pd(_mm256_mul_pd(r, r2), sp, r);
+    __m256d cr = _mm256_fmadd_pd(_mm256_mul_pd(r2, r2), cp, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), r2, _mm256_set1_pd(1.0)));
+    Quadrant(qd, sr, cr, s, c);
+}
+
+TARGET_AVX2 static inline void SinCosFast4(__m256d x, __m256d* s, __m256d* c) {
+    const __m256d shifter = _mm256_set1_pd(6755399441055744.0);
+    __m256d qd = _mm256_fmadd_pd(x, _mm256_set1_pd(MATH_2_PI), shifter);
+    __m256d q = _mm256_sub_pd(qd, shifter);
+    __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(MATH_PIO2), x);
+    __m256d r2 = _mm256_mul_pd(r, r);
+    __m256d sp = _mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_set1_pd(kSinFast[0]), r2, _mm256_set1_pd(kSinFast[1])), r2,
+        _mm256_set1_pd(kSinFast[2]));
+    __m256d cp = _mm256_fmadd_pd(_mm256_set1_pd(kCosFast[0]), r2, _mm256_set1_pd(kCosFast[1]));
+    __m256d sr = _mm256_fmadd_pd(_mm256_mul_pd(r, r2), sp, r);
+    __m256d cr = _mm256_fmadd_pd(_mm256_mul_pd(r2, r2), cp, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), r2, _mm256_set1_pd(1.0)));
+    Quadrant(qd, sr, cr, s, c);
+}
+
+// Single-precision hardware estimate (12 bits) and one Newton step in double
+TARGET_AVX2 static inline __m256d SqrtFast4(__m256d v) {
+    __m256d y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(v)));
+    __m256d half = _mm256_mul_pd(_mm256_set1_pd(0.5), v);
+    y = _mm256_mul_pd(y, _mm256_fnmadd_pd(half, _mm256_mul_pd(y, y), _mm256_set1_pd(1.5)));
+    return _mm256_mul_pd(v, y);
+}
+
+TARGET_AVX2 static inline __m256d FormulaPoly4(__m256d x) {
+    __m256d s, c;
+    SinCosPoly4(x, &s, &c);
+    return _mm256_fmadd_pd(s, c, _mm256_sqrt_pd(_mm256_add_pd(x, _mm256_set1_pd(1.0))));
+}
+
+TARGET_AVX2 static inline __m256d FormulaFast4(__m256d x) {
+    __m256d s, c;
+    SinCosFast4(x, &s, &c);
+    return _mm256_fmadd_pd(s, c, SqrtFast4(_mm256_add_pd(x, _mm256_set1_pd(1.0))));
+}
+
+TARGET_AVX2 static double RunPolyAvx2(double seed, int64_t iters) {
+    __m256d a = _mm256_setr_pd(seed, seed + LANE_OFFSET, seed + 2 * LANE_OFFSET, seed + 3 * LANE_OFFSET);
+    __m256d b = _mm256_add_pd(a, _mm256_set1_pd(4 * LANE_OFFSET));
+    for (int64_t i = 0; i < iters; i++) {
+        a = FormulaPoly4(a);
+        b = FormulaPoly4(b);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(a, b));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+TARGET_AVX2 static double RunFastAvx2(double seed, int64_t iters) {
+    __m256d a = _mm256_setr_pd(seed, seed + LANE_OFFSET, seed + 2 * LANE_OFFSET, seed + 3 * LANE_OFFSET);
+    __m256d b = _mm256_add_pd(a, _mm256_set1_pd(4 * LANE_OFFSET));
+    for (int64_t i = 0; i < iters; i++) {
+        a = FormulaFast4(a);
+        b = FormulaFast4(b);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(a, b));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// sin, cos and sqrt(x + 1) of n points (n a multiple of 4)
+TARGET_AVX2 static void EvalAvx2(bool fast, const double* x, double* s, double* c, double* q, int n) {
+    for (int i = 0; i < n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i), sv, cv;
+        __m256d w = _mm256_add_pd(v, _mm256_set1_pd(1.0));
+        if (fast) SinCosFast4(v, &sv, &cv);
+        else SinCosPoly4(v, &sv, &cv);
+        _mm256_storeu_pd(s + i, sv);
+        _mm256_storeu_pd(c + i, cv);
+        _mm256_storeu_pd(q + i, fast ? SqrtFast4(w) : _mm256_sqrt_pd(w));
+    }
+}
+
+#endif
+
+// The vector path needs AVX2 with FMA; everything else runs the scalar code
+static bool UseAvx2() {
+#ifdef BENCH_X86
+    return BenchIsaSupported(BENCH_ISA_AVX2);
+#else
+    return false;
+#endif
+}
+
+const char* BenchMathName(int impl) {
+    static const char* names[BENCH_MATH_COUNT] = { "libm", "poly", "fast" };
+    return impl >= 0 && impl < BENCH_MATH_COUNT ? names[impl] : "";
+}
+
+const char* BenchMathIsa(int impl) {
+    return impl != BENCH_MATH_LIBM && UseAvx2() ? "avx2" : "scalar";
+}
+
+BenchKernelRunFn BenchMathKernel(int impl) {
+    switch (impl) {
+        case BENCH_MATH_LIBM: return RunLibm;
+#ifdef BENCH_X86
+        case BENCH_MATH_POLY: return UseAvx2() ? RunPolyAvx2 : RunPolyScalar;
+        case BENCH_MATH_FAST: return UseAvx2() ? RunFastAvx2 : RunFastScalar;
+#else
+        case BENCH_MATH_POLY: return RunPolyScalar;
+        case BENCH_MATH_FAST: return RunFastScalar;
+#endif
+        default: return NULL;
+    }
+}
+
+static void Eval(int impl, const double* x, double* s, double* c, double* q, int n) {
+#ifdef BENCH_X86
+    if (impl != BENCH_MATH_LIBM && UseAvx2()) {
+        EvalAvx2(impl == BENCH_MATH_FAST, x, s, c, q, n);
+        return;
+    }
+#endif
+    for (int i = 0; i < n; i++) {
+        if (impl == BENCH_MATH_LIBM) {
+            s[i] = sin(x[i]);
+            c[i] = cos(x[i]);
+            q[i] = sqrt(x[i] + 1.0);
+        } else if (impl == BENCH_MATH_POLY) {
+            SinCosPoly(x[i], &s[i], &c[i]);
+            q[i] = sqrt(x[i] + 1.0);
+        } else {
+            SinCosFast(x[i], &s[i], &c[i]);
+            q[i] = SqrtFast(x[i] + 1.0);
+        }
+    }
+}
+
+// Distance from `ref` in units of the last place of the double nearest to it
+static double UlpError(double got, long double ref) {
+    double r = (double)ref;
+    double ulp = nextafter(fabs(r), INFINITY) - fabs(r);
+    if (!(ulp > 0.0)) ulp = 4.9406564584124654e-324;
+    double e = (double)(fabsl((long double)got - ref) / ulp);
+    return e == e ? e : INFINITY;
+}
+
+BenchMathAccuracy BenchMathMeasureAccuracy(int impl) {
+    BenchMathAccuracy acc = {};
+    const int n = MATH_TEST_POINTS;
+    std::vector<double> x(n), s(n), c(n), q(n);
+    for (int i = 0; i < n; i++) x[i] = -MATH_TEST_RANGE + 2.0 * MATH_TEST_RANGE * i / (n - 1);
+    Eval(impl, x.data(), s.data(), c.data(), q.data(), n);
+    for (int i = 0; i < n; i++) {
+        long double xl = x[i];
+        long double sl = sinl(xl), cl = cosl(xl);
+        double e = UlpError(s[i], sl);
+        if (e > acc.sinUlp) acc.sinUlp = e;
+        e = UlpError(c[i], cl);
+        if (e > acc.cosUlp) acc.cosUlp = e;
+        if (x[i] <= -1.0) continue;
+        long double ql = sqrtl(xl + 1.0L);
+        e = UlpError(q[i], ql);
+        if (e > acc.sqrtUlp) acc.sqrtUlp = e;
+        // The formula where it is well conditioned (x >= 0 keeps it above 0.5,
+        // which covers the recurrence), as the kernel computes it: with an FMA
+        // where the vector path has one
+        if (x[i] < 0.0) continue;
+        double f = impl != BENCH_MATH_LIBM && UseAvx2() ? fma(s[i], c[i], q[i]) : s[i] * c[i] + q[i];
+        e = UlpError(f, sl * cl + ql);
+        if (e > acc.formulaUlp) acc.formulaUlp = e;
+    }
+    acc.samples = n;
+    acc.referenceBits = LDBL_MANT_DIG;
+    return acc;
+}
@@ -0,0 +1,281 @@
+// Node-to-node memory matrix: Triad bandwidth and pointer-chase latency with
+// the threads on one NUMA node and the buffer on another. Placement uses the
+// raw mbind / set_mempolicy system calls rather than libnuma, with first
+// touch from the node as the fallback where a sandbox refuses them.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+// The buffer is at least NUMA_CACHE_FACTOR times the largest cache and
+// NUMA_MIN_BYTES, and at most 1/NUMA_MEMORY_SHARE of its node's memory
+#define NUMA_CACHE_FACTOR 4
+#define NUMA_MIN_BYTES ((int64_t)256 << 20)
+#define NUMA_MEMORY_SHARE 8
+
+#define NUMA_PAGE 4096
+#define NUMA_SPAN 8192             // doubles per Triad step and thread
+#define NUMA_CHASE_BATCH 100000    // loads between clock reads
+#define NUMA_SAMPLE_PAGES 64       // pages checked for where they landed
+
+#define TRIAD_SCALAR 3.0
+
+// Keeps the chase results live
+static std::atomic<uintptr_t> g_sink(0);
+
+#ifndef _WIN32
+
+#define NUMA_MPOL_DEFAULT 0
+#define NUMA_MPOL_BIND 2
+
+// A nodemask with one bit set, and the maxnode the system calls expect for it
+struct NodeMask {
+    std::vector<unsigned long> bits;
+    unsigned long maxNode;
+
+    explicit NodeMask(int node) : bits(node / (8 * sizeof(unsigned long)) + 1, 0) {
+        const int per = 8 * sizeof(unsigned long);
+        bits[node / per] |= 1ul << (node % per);
+        maxNode = (unsigned long)(bits.size() * per + 1);
+    }
+};
+
+static bool Mbind(void* p, size_t bytes, int node) {
+#ifdef SYS_mbind
+    NodeMask mask(node);
+    return syscall(SYS_mbind, p, bytes, NUMA_MPOL_BIND, mask.bits.data(), mask.maxNode, 0) == 0;
+#else
+    (void)p; (void)bytes; (void)node;
+    return false;
+#endif
+}
+
+// Binds (node >= 0) or resets (node < 0) the calling thread's policy
+static bool SetMempolicy(int node) {
+#ifdef SYS_set_mempolicy
+    if (node < 0) return syscall(SYS_set_mempolicy, NUMA_MPOL_DEFAULT, NULL, 0) == 0;
+    NodeMask mask(node);
+    return syscall(SYS_set_mempolicy, NUMA_MPOL_BIND, mask.bits.data(), mask.maxNode) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+// move_pages without a target only reports the node of each page
+static double ShareOnNode(void* base, size_t bytes, int node) {
+#ifdef SYS_move_pages
+    void* pages[NUMA_SAMPLE_PAGES];
+    int status[NUMA_SAMPLE_PAGES];
+    size_t stride = bytes / NUMA_SAMPLE_PAGES / NUMA_PAGE * NUMA_PAGE;
+    for (int i = 0; i < NUMA_SAMPLE_PAGES; i++) pages[i] = (char*)base + i * stride;
+    if (syscall(SYS_move_pages, 0, NUMA_SAMPLE_PAGES, pages, NULL, status, 0) != 0) return -1.0;
+    int placed = 0, known = 0;
+    for (int i = 0; i < NUMA_SAMPLE_PAGES; i++) {
+        if (status[i] < 0) continue;
+        known++;
+        if (status[i] == node) placed++;
+    }
+    return known ? (double)placed / known : -1.0;
+#else
+    (void)base; (void)bytes; (void)node;
+    return -1.0;
+#endif
+}
+
+static void* MapOnNode(size_t bytes, int node, const char** binding) {
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    *binding = Mbind(p, bytes, node) ? "mbind" : NULL;
+    return p;
+}
+
+static void Unmap(void* p, size_t bytes) {
+    munmap(p, bytes);
+}
+
+#else
+
+static bool SetMempolicy(int node) {
+    (void)node;
+    return false;
+}
+
+static double ShareOnNode(void* base, size_t bytes, int node) {
+    (void)base; (void)bytes; (void)node;
+    return -1.0;
+}
+
+// The node is preferred rather than required: Windows takes pages from
+// another node when it runs out
+static void* MapOnNode(size_t bytes, int node, const char** binding) {
+    void* p = VirtualAllocExNuma(GetCurrentProcess(), NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, (DWORD)node);
+    *binding = p ? "VirtualAllocExNuma" : NULL;
+    return p;
+}
+
+static void Unmap(void* p, size_t bytes) {
+    (void)bytes;
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+#endif
+
+int64_t BenchNumaBytes(const BenchNumaNode& node) {
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    int64_t largest = caches.l3 ? caches.l3 : caches.l2 ? caches.l2 : caches.l1d;
+    int64_t bytes = largest * NUMA_CACHE_FACTOR;
+    if (bytes < NUMA_MIN_BYTES) bytes = NUMA_MIN_BYTES;
+    int64_t memory = node.memory > 0 ? node.memory : caches.memory;
+    if (memory > 0 && bytes > memory / NUMA_MEMORY_SHARE) bytes = memory / NUMA_MEMORY_SHARE;
+    bytes = bytes / NUMA_PAGE * NUMA_PAGE;
+    return bytes > NUMA_PAGE ? bytes : NUMA_PAGE;
+}
+
+// Runs `fn` on a new thread pinned to `cpu`
+template <class Fn>
+static void RunPinned(const BenchPlacement& cpu, Fn fn) {
+    std::thread t([&] {
+        BenchApplyPlacement(cpu, true);
+        fn();
+    });
+    t.join();
+}
+
+// ns per load over about `durationMs` of chasing from one processor
+static double ChaseNs(void* chain, const BenchPlacement& cpu, int durationMs) {
+    double ns = 0.0;
+    RunPinned(cpu, [&] {
+        void* p = BenchChase(chain, NUMA_CHASE_BATCH);
+        int64_t loads = 0;
+        int64_t t0 = BenchNowNs(), now;
+        do {
+            p = BenchChase(p, NUMA_CHASE_BATCH);
+            loads += NUMA_CHASE_BATCH;
+            now = BenchNowNs();
+        } while (now - t0 < (int64_t)durationMs * 1000000);
+        ns = (double)(now - t0) / loads;
+        g_sink.fetch_add((uintptr_t)p, std::memory_order_relaxed);
+    });
+    return ns;
+}
+
+// a = b + q * c over one thread's thirds of its slice, a span at a time
+struct TriadSlice {
+    double* a;
+    double* b;
+    double* c;
+    int64_t n;                 // doubles per third
+    int64_t bytes = 0;
+    int64_t stopNs = 0;
+};
+
+static void TriadPass(TriadSlice* s, int64_t from, int64_t len) {
+    const double q = TRIAD_SCALAR;
+    double* a = s->a + from;
+    const double* b = s->b + from;
+    const double* c = s->c + from;
+    for (int64_t i = 0; i < len; i++) a[i] = b[i] + q * c[i];
+    s->bytes += len * 3 * (int64_t)sizeof(double);
+}
+
+// Triad bytes per second with `threads` workers on `cpus`, each streaming its
+// own slice of the buffer; one untimed pass first, then a common window
+static double TriadBandwidth(double* buf, int64_t count, const std::vector<BenchPlacement>& cpus, int threads, int durationMs) {
+    std::vector<TriadSlice> slices;
+    int64_t per = count / threads / 3 / NUMA_SPAN * NUMA_SPAN;
+    if (per < NUMA_SPAN) return 0.0;
+    for (int t = 0; t < threads; t++) {
+        double* base = buf + (int64_t)t * per * 3;
+        slices.push_back(TriadSlice{ base, base + per, base + 2 * per, per });
+    }
+    std::atomic<int> ready(0);
+    std::atomic<int64_t> startNs(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            TriadSlice* s = &slices[t];
+            BenchApplyPlacement(cpus[t % cpus.size()], true);
+            for (int64_t i = 0; i < s->n; i += NUMA_SPAN) TriadPass(s, i, NUMA_SPAN);
+            s->bytes = 0;
+            ready.fetch_add(1);
+            int64_t start;
+            while ((start = startNs.load(std::memory_order_acquire)) == 0) std::this_thread::yield();
+            int64_t endNs = start + (int64_t)durationMs * 1000000;
+            int64_t pos = 0, now;
+            do {
+                TriadPass(s, pos, NUMA_SPAN);
+                pos = pos + NUMA_SPAN < s->n ? pos + NUMA_SPAN : 0;
+            } while ((now = BenchNowNs()) < endNs);
+            s->stopNs = now;
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    int64_t start = BenchNowNs();
+    startNs.store(start, std::memory_order_release);
+    for (std::thread& t : pool) t.join();
+    int64_t bytes = 0, stop = start;
+    for (const TriadSlice& s : slices) {
+        bytes += s.bytes;
+        if (s.stopNs > stop) stop = s.stopNs;
+    }
+    return stop > start ? bytes * 1e9 / (double)(stop - start) : 0.0;
+}
+
+BenchNumaColumn BenchMeasureNumaColumn(const std::vector<BenchNumaNode>& nodes, int mem, int threadsPerNode, int durationMs) {
+    BenchNumaColumn col;
+    col.bandwidth.assign(nodes.size(), 0.0);
+    col.latencyNs.assign(nodes.size(), 0.0);
+    if (mem < 0 || mem >= (int)nodes.size()) return col;
+    const BenchNumaNode& target = nodes[mem];
+    size_t bytes = (size_t)BenchNumaBytes(target);
+    const char* binding = NULL;
+    void* base = MapOnNode(bytes, target.id, &binding);
+    if (!base) return col;
+    // Laying out the chain writes every line, so it is also the first touch:
+    // done from the node itself, it places the pages there even unbound
+    if (!binding && target.cpus.empty()) {
+        Unmap(base, bytes);
+        return col;
+    }
+    if (target.cpus.empty()) {
+        BenchBuildChase(base, (int64_t)bytes);
+    } else {
+        RunPinned(target.cpus[0], [&] {
+            bool policy = !binding && SetMempolicy(target.id);
+            if (policy) binding = "set_mempolicy";
+            BenchBuildChase(base, (int64_t)bytes);
+            if (policy) SetMempolicy(-1);
+        });
+    }
+    if (!binding) binding = "first touch";
+    col.binding = binding;
+    col.onNode = ShareOnNode(base, bytes, target.id);
+
+    for (size_t cpu = 0; cpu < nodes.size(); cpu++) {
+        if (!nodes[cpu].cpus.empty()) col.latencyNs[cpu] = ChaseNs(base, nodes[cpu].cpus[0], durationMs);
+    }
+    // The chain's pointers read as denormals; Triad runs on plain values
+    double* values = (double*)base;
+    int64_t count = (int64_t)(bytes / sizeof(double));
+    for (int64_t i = 0; i < count; i++) values[i] = 1.0;
+    for (size_t cpu = 0; cpu < nodes.size(); cpu++) {
+        const std::vector<BenchPlacement>& cpus = nodes[cpu].cpus;
+        if (cpus.empty()) continue;
+        int threads = threadsPerNode > 0 && threadsPerNode < (int)cpus.size() ? threadsPerNode : (int)cpus.size();
+        col.bandwidth[cpu] = TriadBandwidth(values, count, cpus, threads, durationMs);
+    }
+    Unmap(base, bytes);
+    return col;
+}
@@ -0,0 +1,324 @@
+// OS primitive costs the benchmarks and the reaction tester lean on: waking
+// a sleeping thread, switching between two threads on one processor, a system
+// call that does nothing, and reading each clock. Every test keeps its samples
+// so the report is a distribution rather than a mean.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BENCH_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Timed round trips of the two-thread tests, after untimed ones that settle
+// both threads on their processors
+#define OS_ROUNDS 20000
+#define OS_WARMUP 1000
+
+// Calls per timed batch of the cheap tests, and batches: a single clock read
+// or null call is too short to time with a clock
+#define OS_BATCH 64
+#define OS_BATCHES 4000
+
+// Keeps the clock reads and call results live
+static std::atomic<uint64_t> g_sink(0);
+
+// ---- a one-shot wake-up signal: a futex word, an auto-reset event on Windows ----
+
+#ifdef _WIN32
+
+struct Signal {
+    HANDLE event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    ~Signal() { CloseHandle(event); }
+    void Post() { SetEvent(event); }
+    void Wait() { WaitForSingleObject(event, INFINITE); }
+};
+
+static int CurrentCpu() {
+    PROCESSOR_NUMBER pn;
+    GetCurrentProcessorNumberEx(&pn);
+    return pn.Group * 64 + pn.Number;
+}
+
+static void YieldToOther() {
+    SwitchToThread();
+}
+
+#else
+
+// Wait consumes the post; a post that lands between the exchange and the
+// futex wait changes the word, so the wait returns at once
+struct Signal {
+    std::atomic<int> word{0};
+    void Post() {
+        word.store(1, std::memory_order_release);
+        syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+    void Wait() {
+        while (word.exchange(0, std::memory_order_acquire) == 0) {
+            syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+        }
+    }
+};
+
+static int CurrentCpu() {
+    return sched_getcpu();
+}
+
+static void YieldToOther() {
+    sched_yield();
+}
+
+#endif
+
+// ---- clocks ----
+
+static uint64_t ReadSteady() {
+    return (uint64_t)BenchNowNs();
+}
+
+#ifdef _WIN32
+
+static uint64_t ReadQpc() {
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (uint64_t)t.QuadPart;
+}
+
+static uint64_t ReadTickCount() {
+    return (uint64_t)GetTickCount64();
+}
+
+static uint64_t ReadPreciseTime() {
+    FILETIME ft;
+    GetSystemTimePreciseAsFileTime(&ft);
+    return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+#else
+
+static uint64_t Timespec(const struct timespec& ts) {
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ReadMonotonic() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return Timespec(ts);
+}
+
+static uint64_t ReadCoarse() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return Timespec(ts);
+}
+
+static uint64_t ReadRealtime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return Timespec(ts);
+}
+
+// The same clock through the kernel, what every read costs when the vDSO
+// can't use the clocksource (hpet, acpi_pm)
+static uint64_t ReadMonotonicSyscall() {
+    struct timespec ts;
+    syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+    return Timespec(ts);
+}
+
+#endif
+
+#ifdef BENCH_X86
+
+static uint64_t ReadTsc() {
+    return __rdtsc();
+}
+
+static uint64_t ReadTscp() {
+    unsigned aux;
+    return __rdtscp(&aux);
+}
+
+#endif
+
+struct ClockEntry {
+    const char* name;
+    uint64_t (*read)();
+};
+
+static const ClockEntry kClocks[] = {
+    { "steady_clock", ReadSteady },
+#ifdef _WIN32
+    { "QueryPerformanceCounter", ReadQpc },
+    { "GetTickCount64", ReadTickCount },
+    { "GetSystemTimePreciseAsFileTime", ReadPreciseTime },
+#else
+    { "clock_gettime MONOTONIC", ReadMonotonic },
+    { "clock_gettime MONOTONIC_COARSE", ReadCoarse },
+    { "clock_gettime REALTIME", ReadRealtime },
+    { "clock_gettime syscall", ReadMonotonicSyscall },
+#endif
+#ifdef BENCH_X86
+    { "rdtsc", ReadTsc },
+    { "rdtscp", ReadTscp },
+#endif
+};
+
+// ---- the tests ----
+
+BenchDistribution BenchDistributionOf(std::vector<double> ns) {
+    BenchDistribution d;
+    d.count = (int)ns.size();
+    if (ns.empty()) return d;
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double q) { return ns[(size_t)(q * (ns.size() - 1) + 0.5)]; };
+    double sum = 0.0;
+    for (double v : ns) sum += v;
+    d.min = ns.front();
+    d.p50 = at(0.50);
+    d.p90 = at(0.90);
+    d.p99 = at(0.99);
+    d.p999 = at(0.999);
+    d.max = ns.back();
+    d.mean = sum / ns.size();
+    return d;
+}
+
+// `a` wakes `b` and sleeps until `b` wakes it back; both sleep in the kernel
+// every time, so half a round trip is one wake-up
+bool BenchWakeLatency(const BenchPlacement& a, const BenchPlacement& b, std::vector<double>* ns) {
+    Signal toA, toB;
+    int cpuA = -1, cpuB = -1;
+    std::vector<double> samples;
+    samples.reserve(OS_ROUNDS);
+    std::thread pong([&] {
+        BenchApplyPlacement(b, true);
+        cpuB = CurrentCpu();
+        for (int i = 0; i < OS_WARMUP + OS_ROUNDS; i++) {
+            toB.Wait();
+            toA.Post();
+        }
+    });
+    std::thread ping([&] {
+        BenchApplyPlacement(a, true);
+        cpuA = CurrentCpu();
+        for (int i = 0; i < OS_WARMUP + OS_ROUNDS; i++) {
+            int64_t t0 = BenchNowNs();
+            toB.Post();
+            toA.Wait();
+            if (i >= OS_WARMUP) samples.push_back((BenchNowNs() - t0) / 2.0);
+        }
+    });
+    ping.join();
+    pong.join();
+    // Pinning that didn't take would measure some other placement
+    bool same = a.group == b.group && a.cpu == b.cpu;
+    if ((cpuA == cpuB) != same) return false;
+    *ns = samples;
+    return true;
+}
+
+// Two threads on one processor, each yielding to the other: a yield that
+// found the partner runnable costs two switches. Yields that came straight
+// back (the partner wasn't ready) are dropped.
+bool BenchSwitchCost(const BenchPlacement& cpu, std::vector<double>* ns) {
+    std::atomic<int64_t> partnerTurns(0);
+    std::atomic<bool> stop(false);
+    int cpuA = -1, cpuB = -1;
+    std::vector<double> samples;
+    samples.reserve(OS_ROUNDS);
+    std::thread partner([&] {
+        BenchApplyPlacement(cpu, true);
+        cpuB = CurrentCpu();
+        while (!stop.load(std::memory_order_relaxed)) {
+            partnerTurns.fetch_add(1, std::memory_order_relaxed);
+            YieldToOther();
+        }
+    });
+    std::thread timer([&] {
+        BenchApplyPlacement(cpu, true);
+        cpuA = CurrentCpu();
+        while (partnerTurns.load(std::memory_order_relaxed) == 0) YieldToOther();
+        for (int i = 0; i < OS_WARMUP + OS_ROUNDS; i++) {
+            int64_t before = partnerTurns.load(std::memory_order_relaxed);
+            int64_t t0 = BenchNowNs();
+            YieldToOther();
+            int64_t t1 = BenchNowNs();
+            if (i >= OS_WARMUP && partnerTurns.load(std::memory_order_relaxed) == before + 1) samples.push_back((t1 - t0) / 2.0);
+        }
+        stop.store(true);
+    });
+    timer.join();
+    partner.join();
+    if (cpuA != cpuB || samples.size() < OS_ROUNDS / 2) return false;
+    *ns = samples;
+    return true;
+}
+
+const char* BenchSyscallName() {
+#ifdef _WIN32
+    return "SwitchToThread (nothing to switch to)";
+#else
+    return "getppid";
+#endif
+}
+
+void BenchSyscallCost(std::vector<double>* ns) {
+    ns->clear();
+    uint64_t x = 0;
+    for (int k = 0; k < OS_BATCHES; k++) {
+        int64_t t0 = BenchNowNs();
+        for (int i = 0; i < OS_BATCH; i++) {
+#ifdef _WIN32
+            x += (uint64_t)SwitchToThread();
+#else
+            x += (uint64_t)syscall(SYS_getppid);
+#endif
+        }
+        ns->push_back((double)(BenchNowNs() - t0) / OS_BATCH);
+    }
+    g_sink.fetch_add(x, std::memory_order_relaxed);
+}
+
+int BenchClockCount() {
+    return (int)(sizeof(kClocks) / sizeof(kClocks[0]));
+}
+
+const char* BenchClockName(int clock) {
+    return clock >= 0 && clock < BenchClockCount() ? kClocks[clock].name : "";
+}
+
+// The batch is timed with steady_clock, whose own read is spread over the batch
+void BenchClockCost(int clock, std::vector<double>* ns) {
+    ns->clear();
+    if (clock < 0 || clock >= BenchClockCount()) return;
+    uint64_t (*read)() = kClocks[clock].read;
+    uint64_t x = 0;
+    for (int k = 0; k < OS_BATCHES; k++) {
+        int64_t t0 = BenchNowNs();
+        for (int i = 0; i < OS_BATCH; i++) x += read();
+        ns->push_back((double)(BenchNowNs() - t0) / OS_BATCH);
+    }
+    g_sink.fetch_add(x, std::memory_order_relaxed);
+}
@@ -0,0 +1,250 @@
+// Buffers on base pages, transparent huge pages or reserved huge pages for
+// the memory-access kernels, falling back to ordinary memory (and saying why)
+// when the page size asked for isn't available
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "bench.h"
+
+#define PAGE_BASE ((size_t)4096)
+#define PAGE_2M ((size_t)2 << 20)
+#define PAGE_1G ((size_t)1 << 30)
+
+#if !defined(_WIN32) && !defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_SHIFT 26
+#endif
+
+static const char* kModeNames[BENCH_PAGES_COUNT] = { "default", "4k", "thp", "2m", "1g" };
+
+static size_t RoundUp(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+const char* BenchPageModeName(int mode) {
+    return mode >= 0 && mode < BENCH_PAGES_COUNT ? kModeNames[mode] : "";
+}
+
+int BenchPageModeFromName(const char* name) {
+    for (int mode = 0; mode < BENCH_PAGES_COUNT; mode++) {
+        if (strcmp(name, kModeNames[mode]) == 0) return mode;
+    }
+    return -1;
+}
+
+int BenchPageModeSelected() {
+    const char* forced = getenv(BENCH_PAGES_ENV);
+    int mode = forced ? BenchPageModeFromName(forced) : -1;
+    return mode >= 0 ? mode : BENCH_PAGES_DEFAULT;
+}
+
+#ifdef _WIN32
+
+// Large pages need SeLockMemoryPrivilege ("Lock pages in memory") held by the
+// account and enabled in the token; enabled once, remembered either way
+static bool EnableLockMemory() {
+    static int s_enabled = -1;
+    if (s_enabled >= 0) return s_enabled != 0;
+    s_enabled = 0;
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+    TOKEN_PRIVILEGES tp = {};
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (LookupPrivilegeValueA(NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) &&
+        AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL) && GetLastError() != ERROR_NOT_ALL_ASSIGNED) {
+        s_enabled = 1;
+    }
+    CloseHandle(token);
+    return s_enabled != 0;
+}
+
+static void* MapDefault(size_t bytes) {
+    return VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+// Windows never backs ordinary memory with large pages, so default and 4k are
+// the same; large pages are 2 MiB on x64 and are what "2m" maps to
+static void* MapMode(size_t* bytes, int mode, const char** why) {
+    if (mode == BENCH_PAGES_DEFAULT || mode == BENCH_PAGES_4K) return MapDefault(*bytes);
+    if (mode == BENCH_PAGES_THP) {
+        *why = "Windows has no transparent huge pages";
+        return NULL;
+    }
+    if (mode == BENCH_PAGES_1G) {
+        *why = "1 GiB pages are not available through VirtualAlloc";
+        return NULL;
+    }
+    size_t large = GetLargePageMinimum();
+    if (large == 0) {
+        *why = "the CPU or Windows edition has no large pages";
+        return NULL;
+    }
+    if (!EnableLockMemory()) {
+        *why = "needs SeLockMemoryPrivilege (\"Lock pages in memory\")";
+        return NULL;
+    }
+    *bytes = RoundUp(*bytes, large);
+    void* p = VirtualAlloc(NULL, *bytes, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!p) *why = "not enough contiguous physical memory for large pages";
+    return p;
+}
+
+static void Unmap(void* p, size_t bytes) {
+    (void)bytes;
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+#else
+
+static void* MapDefault(size_t bytes) {
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+// Free pages in the hugetlb pool of one size, -1 if the kernel has no such pool
+static long FreeHugePages(size_t pageBytes) {
+    char path[128], buf[32];
+    snprintf(path, sizeof(path), "/sys/kernel/mm/hugepages/hugepages-%zukB/free_hugepages", pageBytes >> 10);
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    long n = fgets(buf, sizeof(buf), f) ? atol(buf) : 0;
+    fclose(f);
+    return n;
+}
+
+// Reserved huge pages: the mapping either gets them all up front or fails
+static void* MapHugetlb(size_t* bytes, size_t pageBytes, int log2Page, const char** why) {
+    long available = FreeHugePages(pageBytes);
+    if (available < 0) {
+        *why = pageBytes == PAGE_1G ? "no 1 GiB page support in this CPU or kernel" : "no hugetlb support in this kernel";
+        return NULL;
+    }
+    size_t len = RoundUp(*bytes, pageBytes);
+    if ((size_t)available * pageBytes < len) {
+        *why = pageBytes == PAGE_1G ? "not enough free 1 GiB huge pages (hugepagesz=1G hugepages=N at boot)"
+                                    : "not enough free 2 MiB huge pages (sysctl vm.nr_hugepages)";
+        return NULL;
+    }
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2Page << MAP_HUGE_SHIFT), -1, 0);
+    if (p == MAP_FAILED) {
+        *why = "MAP_HUGETLB mapping failed";
+        return NULL;
+    }
+    *bytes = len;
+    return p;
+}
+
+// A 2 MiB-aligned range, so every part of it can be a huge page, with THP
+// asked for (madvise mode) or ruled out
+static void* MapAdvised(size_t* bytes, bool huge, const char** why) {
+    size_t len = RoundUp(*bytes, PAGE_2M);
+    char* raw = (char*)MapDefault(len + PAGE_2M);
+    if (!raw) return NULL;
+    char* p = (char*)RoundUp((size_t)raw, PAGE_2M);
+    if (p > raw) munmap(raw, p - raw);
+    munmap(p + len, raw + PAGE_2M - p);
+#ifdef MADV_HUGEPAGE
+    if (madvise(p, len, huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0 && huge) {
+        *why = "the kernel refused MADV_HUGEPAGE";
+        munmap(p, len);
+        return NULL;
+    }
+#else
+    if (huge) {
+        *why = "no transparent huge page support in this build";
+        munmap(p, len);
+        return NULL;
+    }
+#endif
+    *bytes = len;
+    return p;
+}
+
+static void* MapMode(size_t* bytes, int mode, const char** why) {
+    switch (mode) {
+    case BENCH_PAGES_4K: return MapAdvised(bytes, false, why);
+    case BENCH_PAGES_THP: return MapAdvised(bytes, true, why);
+    case BENCH_PAGES_2M: return MapHugetlb(bytes, PAGE_2M, 21, why);
+    case BENCH_PAGES_1G: return MapHugetlb(bytes, PAGE_1G, 30, why);
+    default: return MapDefault(*bytes);
+    }
+}
+
+static void Unmap(void* p, size_t bytes) {
+    munmap(p, bytes);
+}
+
+#endif
+
+BenchPages BenchAllocPages(size_t bytes, int mode) {
+    BenchPages pages;
+    pages.bytes = RoundUp(bytes > 0 ? bytes : 1, PAGE_BASE);
+    pages.mode = mode >= 0 && mode < BENCH_PAGES_COUNT ? mode : BENCH_PAGES_DEFAULT;
+    const char* why = NULL;
+    pages.base = MapMode(&pages.bytes, pages.mode, &why);
+    if (!pages.base && why) {
+        pages.fallback = why;
+        pages.mode = BENCH_PAGES_DEFAULT;
+        pages.bytes = RoundUp(bytes > 0 ? bytes : 1, PAGE_BASE);
+        pages.base = MapDefault(pages.bytes);
+    }
+    return pages;
+}
+
+void BenchFreePages(BenchPages* pages) {
+    if (pages->base) Unmap(pages->base, pages->bytes);
+    pages->base = NULL;
+    pages->bytes = 0;
+}
+
+int64_t BenchHugeBytes(const BenchPages& pages) {
+    if (!pages.base) return 0;
+    if (pages.mode == BENCH_PAGES_2M || pages.mode == BENCH_PAGES_1G) return (int64_t)pages.bytes;
+#ifdef _WIN32
+    return 0;
+#else
+    // AnonHugePages of every mapping that overlaps the buffer; a neighbour
+    // merged into the same mapping can add to it, never take away
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f) return -1;
+    uintptr_t lo = (uintptr_t)pages.base, hi = lo + pages.bytes;
+    bool inside = false;
+    int64_t huge = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        long kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start < hi && end > lo;
+        } else if (inside && sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) {
+            huge += (int64_t)kb << 10;
+        }
+    }
+    fclose(f);
+    return huge;
+#endif
+}
+
+std::string BenchThpSetting() {
+#ifdef _WIN32
+    return "";
+#else
+    char buf[128] = "";
+    FILE* f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!f) return "";
+    if (!fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return buf;
+#endif
+}
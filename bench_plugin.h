@@ -0,0 +1,66 @@
+// Benchmark kernel plugin interface. A plugin is a shared library (.so / .dll)
+// that exports BENCH_PLUGIN_ENTRY with C linkage; the host calls it once after
+// loading the library and registers every kernel it returns. Plain C so a
+// plugin can be built with any compiler; the library stays loaded for the
+// life of the process, so the strings and functions it hands out must too.
+//
+//     static double Run(double x, int64_t iters) { ... }
+//     static const BenchKernelInfo kKernels[] = {
+//         { BENCH_KERNEL_ABI_VERSION, "mykernel", "MY KERNEL", "ops", 1.0, BENCH_KERNEL_MULTI, Run },
+//     };
+//     BENCH_PLUGIN_EXPORT int32_t BenchPluginEntry(uint32_t abiVersion, const BenchKernelInfo** kernels) {
+//         if (abiVersion != BENCH_KERNEL_ABI_VERSION) return 0;
+//         *kernels = kKernels;
+//         return 1;
+//     }
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever BenchKernelInfo or the entry point change
+#define BENCH_KERNEL_ABI_VERSION 1
+
+#define BENCH_PLUGIN_ENTRY "BenchPluginEntry"
+
+#ifdef _WIN32
+#define BENCH_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define BENCH_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+// How the host runs a kernel
+enum BenchKernelThreadModel {
+    BENCH_KERNEL_SINGLE = 0,    // one worker thread
+    BENCH_KERNEL_MULTI = 1,     // one worker per usable processor (placement, SMT and process modes apply)
+    BENCH_KERNEL_SWEEP = 2,     // thread-scaling sweep up to the usable processors
+    BENCH_KERNEL_EXTERNAL = 3   // runs its own job (the GUI's GPU test); not available to plugins
+};
+
+// Run `iters` iterations of the workload starting from `seed` and return a
+// value that depends on every iteration, so the compiler can't drop the work.
+// Called from many threads or processes at once; must not share mutable state.
+// One call should be cheap to split: the host sizes calls to about
+// BENCH_CHUNK_TARGET_US and checks for cancel between them.
+typedef double (*BenchKernelRunFn)(double seed, int64_t iters);
+
+typedef struct BenchKernelInfo {
+    uint32_t abiVersion;        // BENCH_KERNEL_ABI_VERSION
+    const char* name;           // unique id in history, config and --type: [a-z0-9_-], under 32 chars
+    const char* label;          // menu and result text
+    const char* unit;           // what one op is, e.g. "ops", "flop", "B"; scores read M<unit>/s
+    double opsPerIter;          // units of work one iteration performs
+    int32_t threadModel;        // BenchKernelThreadModel
+    BenchKernelRunFn run;
+} BenchKernelInfo;
+
+// Point *kernels at an array of kernels and return its length, or return 0
+// if the host's abiVersion is not one this plugin was built for
+typedef int32_t (*BenchPluginEntryFn)(uint32_t abiVersion, const BenchKernelInfo** kernels);
+
+#ifdef __cplusplus
+}
+#endif
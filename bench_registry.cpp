@@ -0,0 +1,344 @@
+// Kernel registry: the built-in CPU kernels, kernels the executable adds, and
+// kernels loaded from plugin libraries through the C ABI in bench_plugin.h
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#ifdef _WIN32
+#define PLUGIN_SUFFIX ".dll"
+#define PATH_LIST_SEP ';'
+#else
+#define PLUGIN_SUFFIX ".so"
+#define PATH_LIST_SEP ':'
+#endif
+
+static std::vector<std::string> g_loadedFiles;
+static std::vector<std::string> g_pluginErrors;
+
+static BenchKernel Builtin(const std::string& name, const std::string& label, const char* unit, double opsPerIter,
+                           int threadModel, BenchKernelRunFn run, bool variant) {
+    BenchKernel k;
+    k.name = name;
+    k.label = label;
+    k.unit = unit;
+    k.opsPerIter = opsPerIter;
+    k.threadModel = threadModel;
+    k.run = run;
+    k.variant = variant;
+    return k;
+}
+
+static std::string Upper(std::string s) {
+    for (char& c : s) c = (char)toupper((unsigned char)c);
+    return s;
+}
+
+// Built-ins register on first use, so every entry point sees the same order.
+// "simd" runs the ISA BenchIsaSelected picks; simd-<isa> forces one the CPU
+// supports, so the set differs between machines but not between processes.
+static std::vector<BenchKernel>& Registry() {
+    static std::vector<BenchKernel> s_kernels;
+    if (s_kernels.empty()) {
+        s_kernels.push_back(Builtin("cpu", "CPU", "ops", 1.0, BENCH_KERNEL_SINGLE, BenchCpuKernel, false));
+        s_kernels.push_back(Builtin("multicore", "CPU MULTICORE", "ops", 1.0, BENCH_KERNEL_MULTI, BenchCpuKernel, false));
+        s_kernels.push_back(Builtin("scaling", "CPU SCALING", "ops", 1.0, BENCH_KERNEL_SWEEP, BenchCpuKernel, false));
+        int isa = BenchIsaSelected();
+        s_kernels.push_back(Builtin("simd", "SIMD (" + Upper(BenchIsaName(isa)) + ")", "flop", BenchIsaFlopsPerIter(isa),
+            BENCH_KERNEL_MULTI, BenchIsaKernel(isa), false));
+        for (int i = 0; i < BENCH_ISA_COUNT; i++) {
+            if (!BenchIsaSupported(i)) continue;
+            s_kernels.push_back(Builtin(std::string("simd-") + BenchIsaName(i), "SIMD " + Upper(BenchIsaName(i)), "flop",
+                BenchIsaFlopsPerIter(i), BENCH_KERNEL_MULTI, BenchIsaKernel(i), true));
+        }
+        // GEMM: "gemm" is FP64 at the middle size for the menu, gemm-d<N>/gemm-f<N> the --gemm sweep
+        int sizeCount;
+        const int* sizes = BenchGemmSizes(&sizeCount);
+        int gemmIsa = BenchGemmIsa();
+        s_kernels.push_back(Builtin("gemm", "GEMM FP64 (" + Upper(BenchIsaName(gemmIsa)) + ")", "flop",
+            2.0 * BENCH_GEMM_PANEL * sizes[2] * sizes[2], BENCH_KERNEL_MULTI, BenchGemmKernel(false, sizes[2]), false));
+        for (int fp32 = 0; fp32 <= 1; fp32++) {
+            for (int i = 0; i < sizeCount; i++) {
+                char name[BENCH_KERNEL_NAME_MAX], label[64];
+                snprintf(name, sizeof(name), "gemm-%c%d", fp32 ? 'f' : 'd', sizes[i]);
+                snprintf(label, sizeof(label), "GEMM %s %d", fp32 ? "FP32" : "FP64", sizes[i]);
+                s_kernels.push_back(Builtin(name, label, "flop", 2.0 * BENCH_GEMM_PANEL * sizes[i] * sizes[i],
+                    BENCH_KERNEL_MULTI, BenchGemmKernel(fp32 != 0, sizes[i]), true));
+            }
+        }
+        // STREAM: "stream" is Triad for the menu; stream-<op> and stream-<op>-nt are the --stream table
+        s_kernels.push_back(Builtin("stream", "MEMORY (TRIAD)", "B", BenchStreamBytesPerIter(BENCH_STREAM_TRIAD),
+            BENCH_KERNEL_MULTI, BenchStreamKernel(BENCH_STREAM_TRIAD, false), false));
+        for (int nt = 0; nt <= 1; nt++) {
+            for (int op = 0; op < BENCH_STREAM_COUNT; op++) {
+                if (!BenchStreamKernel(op, nt != 0)) continue;
+                s_kernels.push_back(Builtin(std::string("stream-") + BenchStreamName(op) + (nt ? "-nt" : ""),
+                    "STREAM " + Upper(BenchStreamName(op)) + (nt ? " NT" : ""), "B", BenchStreamBytesPerIter(op),
+                    BENCH_KERNEL_MULTI, BenchStreamKernel(op, nt != 0), true));
+            }
+        }
+        // Pointer chase per working-set size, latency-4k ... latency-1g; run by --latency
+        for (int i = 0; i < BenchLatencySizeCount(); i++) {
+            char name[BENCH_KERNEL_NAME_MAX], label[64];
+            BenchLatencyName(i, name, sizeof(name));
+            snprintf(label, sizeof(label), "LATENCY %s", Upper(name + 8).c_str());
+            s_kernels.push_back(Builtin(name, label, "load", 1.0, BENCH_KERNEL_SINGLE, BenchLatencyKernel(i), true));
+        }
+        s_kernels.push_back(Builtin("random", "RANDOM, OWN SLICE", "update", 1.0, BENCH_KERNEL_SINGLE, BenchRandomKernel(), true));
+        for (int i = 0; i < BENCH_MATH_COUNT; i++) {
+            s_kernels.push_back(Builtin(std::string("math-") + BenchMathName(i), "MATH " + Upper(BenchMathName(i)), "ops",
+                BENCH_MATH_LANES, BENCH_KERNEL_SINGLE, BenchMathKernel(i), true));
+        }
+        // ILP family, ilp-d8x4 = 8 double chains unrolled 4 times; run by --ilp
+        int unrollCount;
+        const int* unrolls = BenchIlpUnrolls(&unrollCount);
+        for (int type = BENCH_ILP_DOUBLE; type <= BENCH_ILP_FLOAT; type++) {
+            for (int u = 0; u < unrollCount; u++) {
+                for (int chains = 1; chains <= BENCH_ILP_MAX_CHAINS; chains++) {
+                    char name[BENCH_KERNEL_NAME_MAX], label[64];
+                    snprintf(name, sizeof(name), "ilp-%c%dx%d", type == BENCH_ILP_FLOAT ? 'f' : 'd', chains, unrolls[u]);
+                    snprintf(label, sizeof(label), "ILP %s %dx%d", type == BENCH_ILP_FLOAT ? "FLOAT" : "DOUBLE", chains, unrolls[u]);
+                    s_kernels.push_back(Builtin(name, label, "flop", 2.0 * chains * unrolls[u], BENCH_KERNEL_SINGLE,
+                        BenchIlpKernel(type, chains, unrolls[u]), true));
+                }
+            }
+        }
+        // Synchronization primitives, sync-<name>; run by --sync over thread counts
+        for (int i = 0; i < BENCH_SYNC_COUNT; i++) {
+            s_kernels.push_back(Builtin(std::string("sync-") + BenchSyncName(i), std::string("SYNC ") + BenchSyncLabel(i), "ops", 1.0,
+                BENCH_KERNEL_MULTI, BenchSyncKernel(i), true));
+        }
+        // Allocators: alloc-churn / alloc-xthread on the selected one, then each
+        // pattern and size on each allocator by name; run by --malloc
+        int allocator = BenchAllocatorSelected();
+        for (int pattern = 0; pattern < BENCH_ALLOC_PATTERNS; pattern++) {
+            std::string name = std::string("alloc-") + BenchAllocPatternName(pattern);
+            std::string label = "ALLOC " + Upper(BenchAllocPatternName(pattern));
+            s_kernels.push_back(Builtin(name, label + " (" + Upper(BenchAllocatorName(allocator)) + ")", "alloc", 1.0,
+                BENCH_KERNEL_MULTI, BenchAllocKernel(allocator, pattern), true));
+            for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+                s_kernels.push_back(Builtin(name + "-" + BenchAllocatorName(a), label + " " + Upper(BenchAllocatorName(a)),
+                    "alloc", 1.0, BENCH_KERNEL_MULTI, BenchAllocKernel(a, pattern), true));
+            }
+        }
+        int allocSizeCount;
+        const int* allocSizes = BenchAllocSizes(&allocSizeCount);
+        for (int a = 0; a < BENCH_ALLOC_COUNT; a++) {
+            for (int i = 0; i < allocSizeCount; i++) {
+                char name[BENCH_KERNEL_NAME_MAX], label[64];
+                snprintf(name, sizeof(name), "alloc-size-%d-%s", allocSizes[i], BenchAllocatorName(a));
+                snprintf(label, sizeof(label), "ALLOC %d B %s", allocSizes[i], Upper(BenchAllocatorName(a)).c_str());
+                s_kernels.push_back(Builtin(name, label, "alloc", 1.0, BENCH_KERNEL_MULTI, BenchAllocSizeKernel(a, allocSizes[i]), true));
+            }
+        }
+    }
+    return s_kernels;
+}
+
+static bool ValidName(const char* name) {
+    size_t n = strlen(name);
+    if (n == 0 || n >= BENCH_KERNEL_NAME_MAX) return false;
+    for (size_t i = 0; i < n; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) return false;
+    }
+    return true;
+}
+
+bool BenchRegisterKernel(const BenchKernelInfo& info, const char* source, std::string* error) {
+    const char* why = NULL;
+    bool plugin = source && source[0];
+    if (info.abiVersion != BENCH_KERNEL_ABI_VERSION) why = "built for another kernel ABI version";
+    else if (!info.name || !ValidName(info.name)) why = "name must be 1-31 characters of a-z, 0-9, _ and -";
+    else if (BenchFindKernel(info.name)) why = "name is already registered";
+    else if (info.threadModel < BENCH_KERNEL_SINGLE || info.threadModel > BENCH_KERNEL_EXTERNAL) why = "unknown thread model";
+    else if (plugin && info.threadModel == BENCH_KERNEL_EXTERNAL) why = "plugins cannot register external kernels";
+    else if (info.threadModel != BENCH_KERNEL_EXTERNAL && !info.run) why = "no run function";
+    else if (!(info.opsPerIter > 0.0)) why = "opsPerIter must be positive";
+    if (why) {
+        if (error) *error = std::string(info.name && info.name[0] ? info.name : "(unnamed)") + ": " + why;
+        return false;
+    }
+    BenchKernel k;
+    k.name = info.name;
+    k.label = info.label && info.label[0] ? info.label : info.name;
+    k.unit = info.unit && info.unit[0] ? info.unit : "ops";
+    k.opsPerIter = info.opsPerIter;
+    k.threadModel = info.threadModel;
+    k.run = info.run;
+    k.source = plugin ? source : "";
+    Registry().push_back(k);
+    return true;
+}
+
+const std::vector<BenchKernel>& BenchKernels() {
+    return Registry();
+}
+
+int BenchKernelIndex(const char* name) {
+    const std::vector<BenchKernel>& ks = Registry();
+    for (size_t i = 0; i < ks.size(); i++) {
+        if (ks[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+const BenchKernel* BenchFindKernel(const char* name) {
+    int i = BenchKernelIndex(name);
+    return i < 0 ? NULL : &Registry()[i];
+}
+
+BenchRateUnit BenchRateUnitFor(double reference, const std::string& unit) {
+    static const double scales[] = { 1e9, 1e6, 1e3 };
+    static const char* prefixes[] = { "G", "M", "K" };
+    BenchRateUnit r = { 1.0, "" };
+    const char* prefix = "";
+    for (int i = 0; i < 3; i++) {
+        if (reference >= scales[i]) {
+            r.scale = scales[i];
+            prefix = prefixes[i];
+            break;
+        }
+    }
+    snprintf(r.label, sizeof(r.label), "%s%s/s", prefix, unit.c_str());
+    return r;
+}
+
+const char* BenchLegacyKernelName(int type) {
+    static const char* names[] = { "cpu", "gpu", "multicore", "scaling" };
+    return type >= 0 && type < 4 ? names[type] : NULL;
+}
+
+const std::vector<std::string>& BenchPluginErrors() {
+    return g_pluginErrors;
+}
+
+// Load one library and register its kernels; the library is never unloaded
+static int LoadPluginFile(const std::string& path) {
+    for (const std::string& f : g_loadedFiles) {
+        if (f == path) return 0;
+    }
+    g_loadedFiles.push_back(path);
+#ifdef _WIN32
+    HMODULE lib = LoadLibraryA(path.c_str());
+    if (!lib) {
+        g_pluginErrors.push_back(path + ": cannot load the library");
+        return 0;
+    }
+    BenchPluginEntryFn entry = (BenchPluginEntryFn)(void*)GetProcAddress(lib, BENCH_PLUGIN_ENTRY);
+#else
+    void* lib = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        const char* err = dlerror();
+        g_pluginErrors.push_back(path + ": " + (err ? err : "cannot load the library"));
+        return 0;
+    }
+    BenchPluginEntryFn entry = (BenchPluginEntryFn)dlsym(lib, BENCH_PLUGIN_ENTRY);
+#endif
+    if (!entry) {
+        g_pluginErrors.push_back(path + ": no " BENCH_PLUGIN_ENTRY " export");
+        return 0;
+    }
+    const BenchKernelInfo* kernels = NULL;
+    int32_t count = entry(BENCH_KERNEL_ABI_VERSION, &kernels);
+    if (count <= 0 || !kernels) {
+        g_pluginErrors.push_back(path + ": no kernels for this ABI version");
+        return 0;
+    }
+    int added = 0;
+    for (int32_t i = 0; i < count; i++) {
+        std::string error;
+        if (BenchRegisterKernel(kernels[i], path.c_str(), &error)) added++;
+        else g_pluginErrors.push_back(path + ": " + error);
+    }
+    return added;
+}
+
+static bool EndsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Every plugin library in `dir`, in name order so registry indices are the
+// same in every process; a missing directory is not an error
+static int LoadPluginDir(const std::string& dir) {
+    std::vector<std::string> files;
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA((dir + "\\*" PLUGIN_SUFFIX).c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) files.push_back(dir + "\\" + fd.cFileName);
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    DIR* d = opendir(dir.c_str());
+    if (!d) return 0;
+    while (struct dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        if (EndsWith(name, PLUGIN_SUFFIX)) files.push_back(dir + "/" + name);
+    }
+    closedir(d);
+#endif
+    std::sort(files.begin(), files.end());
+    int added = 0;
+    for (const std::string& f : files) added += LoadPluginFile(f);
+    return added;
+}
+
+static bool IsDirectory(const std::string& path) {
+#ifdef _WIN32
+    DWORD attr = GetFileAttributesA(path.c_str());
+    return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+// Directory of this executable, with a trailing separator
+static std::string ExeDir() {
+    char path[4096];
+#ifdef _WIN32
+    DWORD n = GetModuleFileNameA(NULL, path, sizeof(path));
+    if (n == 0 || n >= sizeof(path)) return "";
+    const char* sep = strrchr(path, '\\');
+#else
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) return "";
+    path[n] = '\0';
+    const char* sep = strrchr(path, '/');
+#endif
+    return sep ? std::string(path, (size_t)(sep + 1 - path)) : "";
+}
+
+int BenchLoadPlugins() {
+    int added = LoadPluginDir(ExeDir() + BENCH_PLUGIN_DIR);
+    const char* env = getenv(BENCH_PLUGIN_ENV);
+    if (!env) return added;
+    std::string list = env;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(PATH_LIST_SEP, pos);
+        if (end == std::string::npos) end = list.size();
+        std::string entry = list.substr(pos, end - pos);
+        if (!entry.empty()) added += IsDirectory(entry) ? LoadPluginDir(entry) : LoadPluginFile(entry);
+        pos = end + 1;
+    }
+    return added;
+}
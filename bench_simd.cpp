@@ -0,0 +1,283 @@
+// SIMD kernels for the benchmark core: the same multiply-add recurrence as
+// scalar doubles and as SSE2, AVX2/FMA and AVX-512 vectors, picked at run time
+// from CPUID, plus a core clock probe that runs under each ISA's load
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BENCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC and Clang compile each kernel for its own ISA without raising the
+// baseline of the whole file; MSVC accepts the intrinsics as they are
+#if defined(BENCH_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+// Keep a scalar accumulator in its own register so the compiler can't pack
+// the independent chains into vectors and turn the scalar kernel into SSE
+#if defined(BENCH_X86) && defined(__GNUC__)
+#define KEEP_SCALAR(v) __asm__ volatile("" : "+x"(v))
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define KEEP_SCALAR(v) __asm__ volatile("" : "+w"(v))
+#else
+#define KEEP_SCALAR(v) (void)(v)
+#endif
+
+// Independent accumulators per kernel (RunScalar spells its eight out):
+// enough to cover a 4-cycle FMA latency on two ports
+#define SIMD_CHAINS 8
+
+// acc = acc * SIMD_MUL + SIMD_ADD converges to SIMD_ADD / (1 - SIMD_MUL) and
+// never reaches denormals or infinity, whatever the seed
+#define SIMD_MUL 0.999999
+#define SIMD_ADD 1e-6
+
+// Named accumulators, not an array: the register barrier would otherwise
+// keep the array in memory and add a store-forwarding delay to every chain
+#define SCALAR_STEP(a) a = a * SIMD_MUL + SIMD_ADD; KEEP_SCALAR(a)
+
+static double RunScalar(double seed, int64_t iters) {
+    double a0 = seed, a1 = seed + 0.125, a2 = seed + 0.25, a3 = seed + 0.375;
+    double a4 = seed + 0.5, a5 = seed + 0.625, a6 = seed + 0.75, a7 = seed + 0.875;
+    for (int64_t i = 0; i < iters; i++) {
+        SCALAR_STEP(a0); SCALAR_STEP(a1); SCALAR_STEP(a2); SCALAR_STEP(a3);
+        SCALAR_STEP(a4); SCALAR_STEP(a5); SCALAR_STEP(a6); SCALAR_STEP(a7);
+    }
+    return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+}
+
+#ifdef BENCH_X86
+
+// SSE2 has no FMA: a multiply and a dependent add per lane
+static double RunSse2(double seed, int64_t iters) {
+    const __m128d mul = _mm_set1_pd(SIMD_MUL), add = _mm_set1_pd(SIMD_ADD);
+    __m128d acc[SIMD_CHAINS];
+    for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm_set_pd(seed + j * 0.125, seed + j * 0.125 + 0.0625);
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm_add_pd(_mm_mul_pd(acc[j], mul), add);
+    }
+    double lanes[2], sum = 0.0;
+    for (int j = 0; j < SIMD_CHAINS; j++) {
+        _mm_storeu_pd(lanes, acc[j]);
+        sum += lanes[0] + lanes[1];
+    }
+    return sum;
+}
+
+TARGET_AVX2 static double RunAvx2(double seed, int64_t iters) {
+    const __m256d mul = _mm256_set1_pd(SIMD_MUL), add = _mm256_set1_pd(SIMD_ADD);
+    __m256d acc[SIMD_CHAINS];
+    for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm256_set1_pd(seed + j * 0.125);
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm256_fmadd_pd(acc[j], mul, add);
+    }
+    double lanes[4], sum = 0.0;
+    for (int j = 0; j < SIMD_CHAINS; j++) {
+        _mm256_storeu_pd(lanes, acc[j]);
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return sum;
+}
+
+TARGET_AVX512 static double RunAvx512(double seed, int64_t iters) {
+    const __m512d mul = _mm512_set1_pd(SIMD_MUL), add = _mm512_set1_pd(SIMD_ADD);
+    __m512d acc[SIMD_CHAINS];
+    for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm512_set1_pd(seed + j * 0.125);
+    for (int64_t i = 0; i < iters; i++) {
+        for (int j = 0; j < SIMD_CHAINS; j++) acc[j] = _mm512_fmadd_pd(acc[j], mul, add);
+    }
+    double lanes[8], sum = 0.0;
+    for (int j = 0; j < SIMD_CHAINS; j++) {
+        _mm512_storeu_pd(lanes, acc[j]);
+        for (int k = 0; k < 8; k++) sum += lanes[k];
+    }
+    return sum;
+}
+
+static void Cpuid(int leaf, int sub, unsigned int r[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, leaf, sub);
+    for (int i = 0; i < 4; i++) r[i] = (unsigned int)out[i];
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0)
+static uint64_t ReadXcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+// CPUID feature bits, and XCR0 to check that the OS preserves the YMM/ZMM state
+static bool DetectIsa(int isa) {
+    if (isa == BENCH_ISA_SCALAR || isa == BENCH_ISA_SSE2) return true;  // x86-64 baseline
+    unsigned int r[4];
+    Cpuid(0, 0, r);
+    if (r[0] < 7) return false;
+    Cpuid(1, 0, r);
+    bool fma = (r[2] >> 12) & 1, osxsave = (r[2] >> 27) & 1, avx = (r[2] >> 28) & 1;
+    if (!osxsave || !avx) return false;
+    uint64_t xcr0 = ReadXcr0();
+    if ((xcr0 & 0x6) != 0x6) return false;           // XMM and YMM
+    Cpuid(7, 0, r);
+    bool avx2 = (r[1] >> 5) & 1, avx512f = (r[1] >> 16) & 1;
+    if (isa == BENCH_ISA_AVX2) return avx2 && fma;
+    return avx512f && (xcr0 & 0xe0) == 0xe0;         // opmask and both ZMM halves
+}
+
+#else
+
+static bool DetectIsa(int isa) {
+    return isa == BENCH_ISA_SCALAR;
+}
+
+#endif
+
+// Kernel, lanes per vector and name of every ISA
+struct IsaEntry { const char* name; BenchKernelRunFn run; int lanes; };
+
+static const IsaEntry& Isa(int isa) {
+    static const IsaEntry table[BENCH_ISA_COUNT] = {
+        { "scalar", RunScalar, 1 },
+#ifdef BENCH_X86
+        { "sse2", RunSse2, 2 },
+        { "avx2", RunAvx2, 4 },
+        { "avx512", RunAvx512, 8 },
+#else
+        { "sse2", NULL, 2 },
+        { "avx2", NULL, 4 },
+        { "avx512", NULL, 8 },
+#endif
+    };
+    return table[isa];
+}
+
+const char* BenchIsaName(int isa) {
+    return isa >= 0 && isa < BENCH_ISA_COUNT ? Isa(isa).name : "";
+}
+
+int BenchIsaFromName(const char* name) {
+    for (int isa = 0; isa < BENCH_ISA_COUNT; isa++) {
+        if (strcmp(name, Isa(isa).name) == 0) return isa;
+    }
+    return -1;
+}
+
+bool BenchIsaSupported(int isa) {
+    static int s_supported = -1;  // bit per ISA, detected once
+    if (s_supported < 0) {
+        int bits = 0;
+        for (int i = 0; i < BENCH_ISA_COUNT; i++) {
+            if (Isa(i).run && DetectIsa(i)) bits |= 1 << i;
+        }
+        s_supported = bits;
+    }
+    return isa >= 0 && isa < BENCH_ISA_COUNT && ((s_supported >> isa) & 1);
+}
+
+int BenchIsaSelected() {
+    const char* forced = getenv(BENCH_ISA_ENV);
+    int isa = forced ? BenchIsaFromName(forced) : -1;
+    if (BenchIsaSupported(isa)) return isa;
+    for (isa = BENCH_ISA_COUNT - 1; isa > BENCH_ISA_SCALAR; isa--) {
+        if (BenchIsaSupported(isa)) break;
+    }
+    return isa;
+}
+
+BenchKernelRunFn BenchIsaKernel(int isa) {
+    return BenchIsaSupported(isa) ? Isa(isa).run : NULL;
+}
+
+double BenchIsaFlopsPerIter(int isa) {
+    return 2.0 * SIMD_CHAINS * Isa(isa).lanes;
+}
+
+#ifdef BENCH_X86
+
+// 64-bit imul has a 3-cycle latency on every x86 core since Nehalem and Zen,
+// so a dependent chain of them counts core cycles whatever the TSC says
+#define CLOCK_CHAIN_CYCLES 3.0
+#define CLOCK_CHAIN_OPS 96000
+
+static uint64_t MulChain(uint64_t x, uint64_t k) {
+    for (int i = 0; i < CLOCK_CHAIN_OPS; i += 64) {
+#if defined(__GNUC__)
+        __asm__ volatile(".rept 64\n\timul %1, %0\n\t.endr" : "+r"(x) : "r"(k));
+#else
+        for (int j = 0; j < 64; j++) x *= k;
+#endif
+    }
+    return x;
+}
+
+// One probing thread: the load for about a millisecond, then the timed chain
+// while the core is still at the clock that load gets, repeated until `endNs`
+static void ProbeClock(BenchKernelRunFn load, int64_t endNs, std::vector<double>* ghz) {
+    volatile uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t x = 1;
+    double seed = 1.0;
+    int64_t loadIters = 1000;
+    for (;;) {
+        int64_t t0 = BenchNowNs();
+        seed = load(seed, loadIters);
+        if (BenchNowNs() - t0 >= 1000000 || loadIters >= ((int64_t)1 << 40)) break;
+        loadIters *= 2;
+    }
+    while (BenchNowNs() < endNs) {
+        seed = load(seed, loadIters);
+        int64_t t0 = BenchNowNs();
+        x = MulChain(x, k);
+        int64_t ns = BenchNowNs() - t0;
+        if (ns > 0) ghz->push_back(CLOCK_CHAIN_OPS * CLOCK_CHAIN_CYCLES / ns);
+    }
+    if (x == 0 && seed == 0.0) ghz->push_back(0.0);  // keep both results live
+}
+
+double BenchMeasureClockGHz(BenchKernelRunFn load, int threads, int durationMs) {
+    if (!load || threads < 1) return 0.0;
+    int64_t endNs = BenchNowNs() + (int64_t)durationMs * 1000000;
+    std::vector<std::vector<double>> samples(threads);
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) pool.emplace_back(ProbeClock, load, endNs, &samples[i]);
+    for (std::thread& t : pool) t.join();
+    // Median over every thread: a chain that got preempted reads slow, never fast
+    std::vector<double> all;
+    for (const std::vector<double>& s : samples) all.insert(all.end(), s.begin(), s.end());
+    if (all.empty()) return 0.0;
+    std::sort(all.begin(), all.end());
+    return all[all.size() / 2];
+}
+
+#else
+
+double BenchMeasureClockGHz(BenchKernelRunFn load, int threads, int durationMs) {
+    (void)load; (void)threads; (void)durationMs;
+    return 0.0;  // no cycle-exact reference instruction outside x86
+}
+
+#endif
@@ -0,0 +1,190 @@
+// STREAM kernels (Copy, Scale, Add, Triad) for memory bandwidth: arrays well
+// past the last-level cache, each worker streaming through its own share of
+// them with ordinary or non-temporal stores
+#include <stdint.h>
+#include <new>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BENCH_X86 1
+#include <immintrin.h>
+#endif
+
+#define STREAM_SCALAR 3.0
+
+// Every array is at least STREAM_CACHE_FACTOR times the largest cache (the
+// STREAM rule) and STREAM_MIN_BYTES, and the three at most 1/STREAM_MEMORY_SHARE
+// of installed memory
+#define STREAM_CACHE_FACTOR 4
+#define STREAM_MIN_BYTES ((int64_t)64 << 20)
+#define STREAM_MEMORY_SHARE 2
+
+// Doubles per iteration, one 64-byte line; shares are whole lines, so every
+// chunk starts aligned for the 16-byte streaming stores
+#define STREAM_LINE 8
+#define STREAM_ALIGN 4096
+
+static const char* kNames[BENCH_STREAM_COUNT] = { "copy", "scale", "add", "triad" };
+static const int kArrays[BENCH_STREAM_COUNT] = { 2, 2, 3, 3 };  // arrays read or written
+
+// One worker's share of a, b and c and where it is in them. Thread-local, so
+// it belongs to the pool thread that touched it first; it is rebuilt when the
+// run's thread count changes the share.
+struct StreamArrays {
+    double* a = NULL;
+    double* b = NULL;
+    double* c = NULL;
+    int64_t n = 0;             // doubles per array, a multiple of STREAM_LINE
+    int64_t pos = 0;
+
+    void Release() {
+        for (double* p : { a, b, c }) {
+            if (p) ::operator delete(p, std::align_val_t(STREAM_ALIGN));
+        }
+        a = b = c = NULL;
+        n = pos = 0;
+    }
+    ~StreamArrays() { Release(); }
+};
+
+int64_t BenchStreamArrayBytes(int threads) {
+    BenchCacheInfo caches = BenchGetCacheInfo();
+    int64_t largest = caches.l3 ? caches.l3 : caches.l2 ? caches.l2 : caches.l1d;
+    int64_t bytes = largest * STREAM_CACHE_FACTOR;
+    if (bytes < STREAM_MIN_BYTES) bytes = STREAM_MIN_BYTES;
+    if (caches.memory > 0 && bytes * 3 > caches.memory / STREAM_MEMORY_SHARE) bytes = caches.memory / STREAM_MEMORY_SHARE / 3;
+    // Whole lines per thread
+    int64_t line = STREAM_LINE * sizeof(double) * (int64_t)(threads > 0 ? threads : 1);
+    bytes = bytes / line * line;
+    return bytes > line ? bytes : line;
+}
+
+// This thread's share for the current run, allocated and initialized here so
+// the first touch of every page happens on the CPU that will stream it
+static StreamArrays& Arrays() {
+    static thread_local StreamArrays s;
+    int threads = BenchRunThreads();
+    int64_t n = BenchStreamArrayBytes(threads) / threads / (int64_t)sizeof(double);
+    if (s.n != n) {
+        s.Release();
+        size_t bytes = (size_t)n * sizeof(double);
+        s.a = (double*)::operator new(bytes, std::align_val_t(STREAM_ALIGN), std::nothrow);
+        s.b = (double*)::operator new(bytes, std::align_val_t(STREAM_ALIGN), std::nothrow);
+        s.c = (double*)::operator new(bytes, std::align_val_t(STREAM_ALIGN), std::nothrow);
+        if (!s.a || !s.b || !s.c) {
+            s.Release();
+            BenchFailRun("out of memory for the STREAM arrays");
+            return s;
+        }
+        for (int64_t i = 0; i < n; i++) {
+            s.a[i] = 1.0;
+            s.b[i] = 2.0;
+            s.c[i] = 0.0;
+        }
+        s.n = n;
+    }
+    return s;
+}
+
+// ---- one span of `len` doubles per operation; the values stay fixed whatever
+// the order the kernels run in, as in STREAM with its arrays reset ----
+
+static void StreamSpan(int op, double* a, double* b, double* c, int64_t len) {
+    const double q = STREAM_SCALAR;
+    switch (op) {
+    case BENCH_STREAM_COPY:
+        for (int64_t i = 0; i < len; i++) c[i] = a[i];
+        break;
+    case BENCH_STREAM_SCALE:
+        for (int64_t i = 0; i < len; i++) b[i] = q * c[i];
+        break;
+    case BENCH_STREAM_ADD:
+        for (int64_t i = 0; i < len; i++) c[i] = a[i] + b[i];
+        break;
+    default:
+        for (int64_t i = 0; i < len; i++) a[i] = b[i] + q * c[i];
+        break;
+    }
+}
+
+#ifdef BENCH_X86
+
+// Streaming stores skip the read-for-ownership of the destination line and
+// don't evict the source arrays from the caches on the way
+static void StreamSpanNt(int op, double* a, double* b, double* c, int64_t len) {
+    const __m128d q = _mm_set1_pd(STREAM_SCALAR);
+    switch (op) {
+    case BENCH_STREAM_COPY:
+        for (int64_t i = 0; i < len; i += 2) _mm_stream_pd(c + i, _mm_load_pd(a + i));
+        break;
+    case BENCH_STREAM_SCALE:
+        for (int64_t i = 0; i < len; i += 2) _mm_stream_pd(b + i, _mm_mul_pd(q, _mm_load_pd(c + i)));
+        break;
+    case BENCH_STREAM_ADD:
+        for (int64_t i = 0; i < len; i += 2) _mm_stream_pd(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+        break;
+    default:
+        for (int64_t i = 0; i < len; i += 2) {
+            _mm_stream_pd(a + i, _mm_add_pd(_mm_load_pd(b + i), _mm_mul_pd(q, _mm_load_pd(c + i))));
+        }
+        break;
+    }
+}
+
+#else
+
+// Never registered; keeps StreamRun free of conditionals
+static inline void StreamSpanNt(int op, double* a, double* b, double* c, int64_t len) {
+    StreamSpan(op, a, b, c, len);
+}
+
+#endif
+
+// `iters` lines of the operation, continuing where this thread left off and
+// wrapping at the end of its share
+template <int Op, bool NonTemporal>
+static double StreamRun(double seed, int64_t iters) {
+    StreamArrays& s = Arrays();
+    if (!s.n) return seed;
+    while (iters > 0) {
+        int64_t lines = (s.n - s.pos) / STREAM_LINE;
+        if (lines > iters) lines = iters;
+        int64_t len = lines * STREAM_LINE;
+        if (NonTemporal) StreamSpanNt(Op, s.a + s.pos, s.b + s.pos, s.c + s.pos, len);
+        else StreamSpan(Op, s.a + s.pos, s.b + s.pos, s.c + s.pos, len);
+        s.pos += len;
+        if (s.pos >= s.n) s.pos = 0;
+        iters -= lines;
+    }
+#ifdef BENCH_X86
+    // Streaming stores are weakly ordered; drain them before the chunk counts
+    if (NonTemporal) _mm_sfence();
+#endif
+    return seed + s.a[s.pos] + s.c[s.pos];
+}
+
+const char* BenchStreamName(int op) {
+    return op >= 0 && op < BENCH_STREAM_COUNT ? kNames[op] : "";
+}
+
+double BenchStreamBytesPerIter(int op) {
+    return op >= 0 && op < BENCH_STREAM_COUNT ? (double)kArrays[op] * STREAM_LINE * sizeof(double) : 0.0;
+}
+
+BenchKernelRunFn BenchStreamKernel(int op, bool nonTemporal) {
+    static const BenchKernelRunFn normal[BENCH_STREAM_COUNT] = {
+        StreamRun<BENCH_STREAM_COPY, false>, StreamRun<BENCH_STREAM_SCALE, false>,
+        StreamRun<BENCH_STREAM_ADD, false>, StreamRun<BENCH_STREAM_TRIAD, false>,
+    };
+#ifdef BENCH_X86
+    static const BenchKernelRunFn streaming[BENCH_STREAM_COUNT] = {
+        StreamRun<BENCH_STREAM_COPY, true>, StreamRun<BENCH_STREAM_SCALE, true>,
+        StreamRun<BENCH_STREAM_ADD, true>, StreamRun<BENCH_STREAM_TRIAD, true>,
+    };
+#else
+    static const BenchKernelRunFn streaming[BENCH_STREAM_COUNT] = {};
+#endif
+    if (op < 0 || op >= BENCH_STREAM_COUNT) return NULL;
+    return nonTemporal ? streaming[op] : normal[op];
+}
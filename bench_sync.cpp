@@ -0,0 +1,177 @@
+// Synchronization kernels: one operation on a primitive shared by every
+// worker per iteration (an atomic add, a compare-exchange loop, a lock around
+// a one-counter critical section), and per-thread counters packed into shared
+// cache lines or padded apart, to show what false sharing costs
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include "bench.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+#define SYNC_PAUSE() _mm_pause()
+#else
+#define SYNC_PAUSE() ((void)0)
+#endif
+
+// Spins on a held lock before yielding, so a preempted holder (more threads
+// than processors) gets to run and release it
+#define SYNC_SPIN_LIMIT 4096
+
+// One write in this many iterations of the reader-writer kernel
+#define SYNC_WRITE_EVERY 8
+
+#define SYNC_LINE 64
+
+static const char* kNames[BENCH_SYNC_COUNT] = {
+    "atomic-local", "atomic", "cas", "ttas", "ticket", "mutex", "rwlock", "padded", "unpadded",
+};
+static const char* kLabels[BENCH_SYNC_COUNT] = {
+    "ATOMIC UNCONTENDED", "ATOMIC CONTENDED", "CAS LOOP", "TTAS SPINLOCK", "TICKET LOCK", "STD::MUTEX",
+    "RW LOCK", "PADDED COUNTERS", "UNPADDED COUNTERS",
+};
+
+struct alignas(SYNC_LINE) SyncSlot {
+    std::atomic<int64_t> value;
+};
+
+// Test-and-test-and-set: waiters spin on a plain load, which stays in their
+// own cache, and only try the exchange once the lock looks free
+struct alignas(SYNC_LINE) TtasLock {
+    std::atomic<int> locked;
+
+    void lock() {
+        for (;;) {
+            if (!locked.exchange(1, std::memory_order_acquire)) return;
+            for (int spins = 0; locked.load(std::memory_order_relaxed); spins++) {
+                SYNC_PAUSE();
+                if (spins == SYNC_SPIN_LIMIT) {
+                    spins = 0;
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+    void unlock() { locked.store(0, std::memory_order_release); }
+};
+
+// FIFO: each waiter takes a ticket and waits for it to be served, so the
+// lock is fair but every hand-over goes to one particular thread
+struct alignas(SYNC_LINE) TicketLock {
+    std::atomic<uint32_t> next;
+    std::atomic<uint32_t> serving;
+
+    void lock() {
+        uint32_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        for (int spins = 0; serving.load(std::memory_order_acquire) != ticket; spins++) {
+            SYNC_PAUSE();
+            if (spins == SYNC_SPIN_LIMIT) {
+                spins = 0;
+                std::this_thread::yield();
+            }
+        }
+    }
+    void unlock() { serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
+
+static SyncSlot g_shared;                  // the contended atomic and the CAS target
+static SyncSlot g_slots[BENCH_MAX_THREADS];  // one line per thread
+alignas(SYNC_LINE) static std::atomic<int64_t> g_packed[BENCH_MAX_THREADS];  // eight threads per line
+static TtasLock g_ttas;
+static TicketLock g_ticket;
+static std::mutex g_mutex;
+static std::shared_mutex g_rwlock;
+alignas(SYNC_LINE) static int64_t g_guarded;  // what the locks protect
+
+// This thread's slot in the per-thread arrays; pool threads keep theirs across runs
+static int Slot() {
+    static std::atomic<int> s_next(0);
+    static thread_local int t_slot = s_next.fetch_add(1, std::memory_order_relaxed) % BENCH_MAX_THREADS;
+    return t_slot;
+}
+
+// The guarded counter is a plain variable: the lock is what makes it safe
+template <class Lock>
+static int64_t Locked(Lock& lock, int64_t iters) {
+    int64_t x = 0;
+    for (int64_t i = 0; i < iters; i++) {
+        lock.lock();
+        x += ++g_guarded;
+        lock.unlock();
+    }
+    return x;
+}
+
+template <int Kind>
+static double SyncRun(double seed, int64_t iters) {
+    int64_t x = 0;
+    switch (Kind) {
+    case BENCH_SYNC_ATOMIC_LOCAL: {
+        std::atomic<int64_t>& v = g_slots[Slot()].value;
+        for (int64_t i = 0; i < iters; i++) x += v.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+    case BENCH_SYNC_ATOMIC:
+        for (int64_t i = 0; i < iters; i++) x += g_shared.value.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case BENCH_SYNC_CAS:
+        for (int64_t i = 0; i < iters; i++) {
+            int64_t v = g_shared.value.load(std::memory_order_relaxed);
+            while (!g_shared.value.compare_exchange_weak(v, v + 1, std::memory_order_relaxed)) {}
+            x += v;
+        }
+        break;
+    case BENCH_SYNC_TTAS:
+        x = Locked(g_ttas, iters);
+        break;
+    case BENCH_SYNC_TICKET:
+        x = Locked(g_ticket, iters);
+        break;
+    case BENCH_SYNC_MUTEX:
+        x = Locked(g_mutex, iters);
+        break;
+    case BENCH_SYNC_RWLOCK:
+        for (int64_t i = 0; i < iters; i++) {
+            if (i % SYNC_WRITE_EVERY == 0) {
+                std::unique_lock<std::shared_mutex> w(g_rwlock);
+                x += ++g_guarded;
+            } else {
+                std::shared_lock<std::shared_mutex> r(g_rwlock);
+                x += g_guarded;
+            }
+        }
+        break;
+    default: {
+        // A plain load and store of the thread's own counter, as the engine
+        // counts ops; only the layout differs between the two
+        std::atomic<int64_t>& v = Kind == BENCH_SYNC_PADDED ? g_slots[Slot()].value : g_packed[Slot()];
+        for (int64_t i = 0; i < iters; i++) {
+            int64_t n = v.load(std::memory_order_relaxed) + 1;
+            v.store(n, std::memory_order_relaxed);
+            x += n;
+        }
+        break;
+    }
+    }
+    return seed + (double)(x & 0xff);
+}
+
+const char* BenchSyncName(int kind) {
+    return kind >= 0 && kind < BENCH_SYNC_COUNT ? kNames[kind] : "";
+}
+
+const char* BenchSyncLabel(int kind) {
+    return kind >= 0 && kind < BENCH_SYNC_COUNT ? kLabels[kind] : "";
+}
+
+BenchKernelRunFn BenchSyncKernel(int kind) {
+    static const BenchKernelRunFn kernels[BENCH_SYNC_COUNT] = {
+        SyncRun<BENCH_SYNC_ATOMIC_LOCAL>, SyncRun<BENCH_SYNC_ATOMIC>, SyncRun<BENCH_SYNC_CAS>,
+        SyncRun<BENCH_SYNC_TTAS>, SyncRun<BENCH_SYNC_TICKET>, SyncRun<BENCH_SYNC_MUTEX>,
+        SyncRun<BENCH_SYNC_RWLOCK>, SyncRun<BENCH_SYNC_PADDED>, SyncRun<BENCH_SYNC_UNPADDED>,
+    };
+    return kind >= 0 && kind < BENCH_SYNC_COUNT ? kernels[kind] : NULL;
+}
@@ -0,0 +1,695 @@
+// Processor topology and worker placement for the benchmark core
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "bench.h"
+
+static std::once_flag g_topologyOnce;
+static BenchTopology g_topology;
+
+#ifdef _WIN32
+
+// Core, package and efficiency class of every logical processor, indexed by
+// group * 64 + processor. One RelationProcessorCore record per physical core
+// (with its EfficiencyClass), one RelationProcessorPackage record per socket.
+struct CpuRecord { int core, package, efficiencyClass; };
+
+static int ReadProcessorRecords(std::vector<CpuRecord>* byCpu) {
+    DWORD len = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &len);
+    if (len == 0) return 0;
+    std::vector<char> buf(len);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buf.data(), &len)) return 0;
+    int cores = 0, packages = 0;
+    for (DWORD off = 0; off < len; ) {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* rec = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buf.data() + off);
+        if (rec->Size == 0) break;
+        off += rec->Size;
+        bool isCore = rec->Relationship == RelationProcessorCore;
+        if (!isCore && rec->Relationship != RelationProcessorPackage) continue;
+        const PROCESSOR_RELATIONSHIP& pr = rec->Processor;
+        for (WORD i = 0; i < pr.GroupCount; i++) {
+            for (int bit = 0; bit < 64; bit++) {
+                if (!(pr.GroupMask[i].Mask >> bit & 1)) continue;
+                size_t idx = (size_t)pr.GroupMask[i].Group * 64 + bit;
+                if (byCpu->size() <= idx) byCpu->resize(idx + 1, CpuRecord());
+                if (isCore) {
+                    (*byCpu)[idx].core = cores;
+                    (*byCpu)[idx].efficiencyClass = pr.EfficiencyClass;
+                } else {
+                    (*byCpu)[idx].package = packages;
+                }
+            }
+        }
+        if (isCore) cores++;
+        else packages++;
+    }
+    return cores;
+}
+
+// A restricted affinity mask (process or job) confines the process to its
+// primary group; a hard CPU rate cap on the job becomes a quota
+static void DetectTopology() {
+    WORD groups = GetActiveProcessorGroupCount();
+    std::vector<uint64_t> allowed;
+    for (WORD g = 0; g < groups; g++) {
+        int count = (int)GetActiveProcessorCount(g);
+        g_topology.groupSizes.push_back(count);
+        g_topology.logicalCount += count;
+        allowed.push_back(count >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1));
+    }
+
+    DWORD_PTR procMask = 0, sysMask = 0;
+    uint64_t restricted = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &procMask, &sysMask) && procMask != 0 && procMask != sysMask) {
+        restricted = procMask;
+    }
+    JOBOBJECT_BASIC_LIMIT_INFORMATION basic = {};
+    if (QueryInformationJobObject(NULL, JobObjectBasicLimitInformation, &basic, sizeof(basic), NULL) &&
+        (basic.LimitFlags & JOB_OBJECT_LIMIT_AFFINITY) && basic.Affinity != 0) {
+        restricted = restricted ? (restricted & basic.Affinity) : basic.Affinity;
+    }
+    if (restricted) {
+        USHORT primary = 0, count = 1;
+        if (!GetProcessGroupAffinity(GetCurrentProcess(), &count, &primary)) primary = 0;
+        for (size_t g = 0; g < allowed.size(); g++) {
+            allowed[g] = (g == primary) ? (allowed[g] & restricted) : 0;
+        }
+    }
+    std::vector<CpuRecord> records;
+    g_topology.coreCount = ReadProcessorRecords(&records);
+    for (size_t g = 0; g < allowed.size(); g++) {
+        for (int cpu = 0; cpu < 64; cpu++) {
+            if (!(allowed[g] >> cpu & 1)) continue;
+            size_t idx = g * 64 + cpu;
+            CpuRecord rec = idx < records.size() ? records[idx] : CpuRecord();
+            BenchPlacement p;
+            p.group = (int)g;
+            p.cpu = cpu;
+            p.core = rec.core;
+            p.package = rec.package;
+            p.efficiencyClass = rec.efficiencyClass;
+            g_topology.allowed.push_back(p);
+        }
+    }
+
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate = {};
+    if (QueryInformationJobObject(NULL, JobObjectCpuRateControlInformation, &rate, sizeof(rate), NULL) &&
+        (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE)) {
+        // Rates are in 1/100 % of the whole machine
+        DWORD cap = 0;
+        if (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP) cap = rate.CpuRate;
+        else if (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_MIN_MAX_RATE) cap = rate.MaxRate;
+        if (cap > 0 && cap < 10000) g_topology.cpuQuota = cap / 10000.0 * g_topology.logicalCount;
+    }
+}
+
+#else
+
+// "0-3,8,10-11" as used by sysfs; returns the listed CPU ids
+static std::vector<int> ParseCpuList(const char* text) {
+    std::vector<int> cpus;
+    const char* s = text;
+    while (*s) {
+        char* end;
+        long lo = strtol(s, &end, 10);
+        if (end == s) break;
+        long hi = lo;
+        s = end;
+        if (*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long c = lo; c <= hi; c++) cpus.push_back((int)c);
+        while (*s == ',' || *s == '\n' || *s == ' ') s++;
+    }
+    return cpus;
+}
+
+static bool ReadLine(const std::string& path, char* buf, int size) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return false;
+    bool ok = fgets(buf, size, f) != NULL;
+    fclose(f);
+    return ok;
+}
+
+// Core and package of every online CPU, indexed by CPU id. core_id is only
+// unique within a package, so cores are numbered by distinct (package, core_id).
+struct CpuRecord { int core, package, efficiencyClass; };
+
+static int ReadCpuRecords(const std::vector<int>& online, std::vector<CpuRecord>* byCpu) {
+    std::map<std::pair<int, int>, int> cores;
+    char buf[64];
+    for (int cpu : online) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        int coreId = ReadLine(dir + "core_id", buf, sizeof(buf)) ? atoi(buf) : cpu;
+        int package = ReadLine(dir + "physical_package_id", buf, sizeof(buf)) ? atoi(buf) : 0;
+        if (package < 0) package = 0;
+        std::pair<int, int> key(package, coreId);
+        if (cores.find(key) == cores.end()) {
+            int next = (int)cores.size();
+            cores[key] = next;
+        }
+        if ((int)byCpu->size() <= cpu) byCpu->resize(cpu + 1, CpuRecord());
+        (*byCpu)[cpu].core = cores[key];
+        (*byCpu)[cpu].package = package;
+    }
+    return (int)cores.size();
+}
+
+// Efficiency classes: Intel hybrid parts list their E-cores under cpu_atom and
+// P-cores under cpu_core; Arm big.LITTLE exposes cpu_capacity, ranked here so
+// the smallest capacity is class 0
+static void ReadEfficiencyClasses(const std::vector<int>& online, std::vector<CpuRecord>* byCpu) {
+    char buf[4096];
+    if (ReadLine("/sys/devices/cpu_atom/cpus", buf, sizeof(buf))) {
+        for (int cpu : ParseCpuList(buf)) {
+            if (cpu < (int)byCpu->size()) (*byCpu)[cpu].efficiencyClass = 0;
+        }
+        if (ReadLine("/sys/devices/cpu_core/cpus", buf, sizeof(buf))) {
+            for (int cpu : ParseCpuList(buf)) {
+                if (cpu < (int)byCpu->size()) (*byCpu)[cpu].efficiencyClass = 1;
+            }
+        }
+        return;
+    }
+    std::map<int, std::vector<int>> byCapacity;
+    for (int cpu : online) {
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpu_capacity";
+        if (!ReadLine(path, buf, sizeof(buf))) return;
+        byCapacity[atoi(buf)].push_back(cpu);
+    }
+    int cls = 0;
+    for (const auto& entry : byCapacity) {
+        for (int cpu : entry.second) (*byCpu)[cpu].efficiencyClass = cls;
+        cls++;
+    }
+}
+
+// CPUs this thread may run on; the set is grown until the kernel's mask fits
+static std::vector<int> AffinityCpus() {
+    std::vector<int> cpus;
+    for (int n = 1024; n <= (1 << 20); n *= 2) {
+        cpu_set_t* set = CPU_ALLOC(n);
+        size_t size = CPU_ALLOC_SIZE(n);
+        CPU_ZERO_S(size, set);
+        if (sched_getaffinity(0, size, set) == 0) {
+            for (int c = 0; c < n; c++) {
+                if (CPU_ISSET_S(c, size, set)) cpus.push_back(c);
+            }
+            CPU_FREE(set);
+            return cpus;
+        }
+        CPU_FREE(set);
+    }
+    return cpus;
+}
+
+// Where the cgroup hierarchy holding `controller` is mounted and which cgroup
+// path that mount starts at (containers usually see their own cgroup as "/")
+static bool FindCgroupMount(bool v2, const char* controller, std::string* mountPoint, std::string* root) {
+    FILE* f = fopen("/proc/self/mountinfo", "r");
+    if (!f) return false;
+    char line[4096];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        // id parent major:minor root mountpoint options ... - fstype source superoptions
+        char mroot[1024], mpoint[1024];
+        if (sscanf(line, "%*s %*s %*s %1023s %1023s", mroot, mpoint) != 2) continue;
+        const char* sep = strstr(line, " - ");
+        if (!sep) continue;
+        char fstype[64], source[256], opts[1024] = "";
+        if (sscanf(sep + 3, "%63s %255s %1023s", fstype, source, opts) < 2) continue;
+        if (v2) {
+            found = strcmp(fstype, "cgroup2") == 0;
+        } else if (strcmp(fstype, "cgroup") == 0) {
+            // Super options list the controllers: "rw,cpu,cpuacct"
+            for (char* tok = strtok(opts, ","); tok && !found; tok = strtok(NULL, ",")) {
+                found = strcmp(tok, controller) == 0;
+            }
+        }
+        if (found) {
+            *mountPoint = mpoint;
+            *root = mroot;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// This process's cgroup path: the "0::" line for v2, the line naming the
+// controller for v1
+static bool FindCgroupPath(bool v2, const char* controller, std::string* path) {
+    FILE* f = fopen("/proc/self/cgroup", "r");
+    if (!f) return false;
+    char line[4096];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = 0;
+        char* c1 = strchr(line, ':');
+        char* c2 = c1 ? strchr(c1 + 1, ':') : NULL;
+        if (!c2) continue;
+        *c2 = 0;
+        if (v2) {
+            found = strncmp(line, "0:", 2) == 0 && c1[1] == 0;
+        } else {
+            for (char* tok = strtok(c1 + 1, ","); tok && !found; tok = strtok(NULL, ",")) {
+                found = strcmp(tok, controller) == 0;
+            }
+        }
+        if (found) *path = c2 + 1;
+    }
+    fclose(f);
+    return found;
+}
+
+// Tightest CPU bandwidth limit from this cgroup up to the mount root, in CPUs;
+// 0 when nothing is limited. A parent's quota caps every child.
+static double CgroupQuota(bool v2) {
+    std::string mountPoint, root, path;
+    if (!FindCgroupMount(v2, "cpu", &mountPoint, &root) || !FindCgroupPath(v2, "cpu", &path)) return 0.0;
+    if (root != "/" && path.compare(0, root.size(), root) == 0) path = path.substr(root.size());
+    double best = 0.0;
+    char buf[128];
+    while (true) {
+        std::string dir = mountPoint + (path == "/" ? "" : path) + "/";
+        double cpus = 0.0;
+        if (v2) {
+            // "max 100000" or "<quota> <period>"
+            long long quota = 0, period = 0;
+            if (ReadLine(dir + "cpu.max", buf, sizeof(buf)) &&
+                sscanf(buf, "%lld %lld", &quota, &period) == 2 && quota > 0 && period > 0) {
+                cpus = (double)quota / (double)period;
+            }
+        } else if (ReadLine(dir + "cpu.cfs_quota_us", buf, sizeof(buf))) {
+            long long quota = atoll(buf);  // -1 = unlimited
+            if (quota > 0 && ReadLine(dir + "cpu.cfs_period_us", buf, sizeof(buf)) && atoll(buf) > 0) {
+                cpus = (double)quota / (double)atoll(buf);
+            }
+        }
+        if (cpus > 0.0 && (best == 0.0 || cpus < best)) best = cpus;
+        if (path.empty() || path == "/") break;
+        size_t slash = path.find_last_of('/');
+        path = slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+    }
+    return best;
+}
+
+static void DetectTopology() {
+    char buf[4096];
+    std::vector<int> online;
+    if (ReadLine("/sys/devices/system/cpu/online", buf, sizeof(buf))) online = ParseCpuList(buf);
+    if (online.empty()) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < (count > 0 ? count : 1); c++) online.push_back((int)c);
+    }
+    g_topology.logicalCount = (int)online.size();
+    g_topology.groupSizes.push_back(g_topology.logicalCount);
+    std::vector<CpuRecord> records;
+    g_topology.coreCount = ReadCpuRecords(online, &records);
+    ReadEfficiencyClasses(online, &records);
+    for (int cpu : AffinityCpus()) {
+        CpuRecord rec = cpu < (int)records.size() ? records[cpu] : CpuRecord();
+        BenchPlacement p;
+        p.group = 0;
+        p.cpu = cpu;
+        p.core = rec.core;
+        p.package = rec.package;
+        p.efficiencyClass = rec.efficiencyClass;
+        g_topology.allowed.push_back(p);
+    }
+    // Hybrid hosts mount both; the v2 hierarchy wins when it has the cpu controller
+    double v2 = CgroupQuota(true), v1 = CgroupQuota(false);
+    g_topology.cpuQuota = (v2 > 0.0 && (v1 == 0.0 || v2 < v1)) ? v2 : v1;
+}
+
+#endif
+
+static void FinishTopology(BenchTopology* topo) {
+    if (topo->logicalCount < 1) {
+        topo->logicalCount = 1;
+        topo->groupSizes.assign(1, 1);
+    }
+    if (topo->allowed.empty()) {
+        for (int g = 0; g < (int)topo->groupSizes.size(); g++) {
+            for (int cpu = 0; cpu < topo->groupSizes[g]; cpu++) {
+                BenchPlacement p = {};
+                p.group = g;
+                p.cpu = cpu;
+                p.core = (int)topo->allowed.size();
+                topo->allowed.push_back(p);
+            }
+        }
+    }
+    if (topo->coreCount < 1) topo->coreCount = topo->logicalCount;
+    std::set<int> classes;
+    for (const BenchPlacement& p : topo->allowed) classes.insert(p.efficiencyClass);
+    topo->classCount = (int)classes.size();
+    // A fractional quota still lets the last thread run part of the time
+    int effective = (int)topo->allowed.size();
+    if (topo->cpuQuota > 0.0) {
+        int quota = (int)ceil(topo->cpuQuota - 1e-9);
+        if (quota < effective) effective = quota;
+    }
+    topo->effectiveCount = effective > 0 ? effective : 1;
+}
+
+static void DetectAndFinish() {
+    DetectTopology();
+    FinishTopology(&g_topology);
+}
+
+BenchTopology BenchGetTopology() {
+    std::call_once(g_topologyOnce, DetectAndFinish);
+    return g_topology;
+}
+
+BenchTopology BenchSimulateTopology(int logicalCount, int groupSize, int threadsPerCore) {
+    BenchTopology topo;
+    topo.simulated = true;
+    if (logicalCount < 1) logicalCount = 1;
+    if (groupSize < 1) groupSize = logicalCount;
+    if (threadsPerCore < 1) threadsPerCore = 1;
+    topo.logicalCount = logicalCount;
+    for (int left = logicalCount; left > 0; left -= groupSize) {
+        topo.groupSizes.push_back(left < groupSize ? left : groupSize);
+    }
+    for (int g = 0, index = 0; g < (int)topo.groupSizes.size(); g++) {
+        for (int cpu = 0; cpu < topo.groupSizes[g]; cpu++, index++) {
+            BenchPlacement p = {};
+            p.group = g;
+            p.cpu = cpu;
+            p.core = index / threadsPerCore;
+            topo.allowed.push_back(p);
+        }
+    }
+    topo.coreCount = (logicalCount + threadsPerCore - 1) / threadsPerCore;
+    FinishTopology(&topo);
+    return topo;
+}
+
+BenchTopology BenchTopologyFor(const BenchConfig& cfg) {
+    BenchTopology topo = BenchGetTopology();
+    if (cfg.simulatedGroupSize <= 0 && cfg.simulatedSmt <= 1) return topo;
+    int logical = topo.logicalCount > cfg.threadCount ? topo.logicalCount : cfg.threadCount;
+    return BenchSimulateTopology(logical, cfg.simulatedGroupSize, cfg.simulatedSmt);
+}
+
+std::vector<BenchPlacement> BenchPlanPlacement(const BenchTopology& topo, int threadCount) {
+    std::vector<BenchPlacement> plan;
+    int allowed = (int)topo.allowed.size();
+    if (threadCount < 1 || allowed < 1) return plan;
+    plan.reserve(threadCount);
+    // Allowed processors are listed group by group; thread i takes the group
+    // of processor i * allowed / threadCount, so every group gets its share
+    // and rounding never leaves one short by more than a thread
+    for (int64_t i = 0; i < threadCount; i++) {
+        plan.push_back(topo.allowed[(size_t)(i * allowed / threadCount)]);
+    }
+    return plan;
+}
+
+std::vector<BenchPlacement> BenchPlanPhysical(const BenchTopology& topo) {
+    std::vector<BenchPlacement> plan;
+    std::set<int> cores;
+    for (const BenchPlacement& p : topo.allowed) {
+        if (cores.insert(p.core).second) plan.push_back(p);
+    }
+    return plan;
+}
+
+std::vector<BenchPlacement> BenchPlanLogical(const BenchTopology& topo) {
+    std::vector<BenchPlacement> plan = topo.allowed;
+    std::stable_sort(plan.begin(), plan.end(),
+        [](const BenchPlacement& a, const BenchPlacement& b) { return a.core < b.core; });
+    return plan;
+}
+
+std::vector<BenchPlacement> BenchPlanCoresFirst(const BenchTopology& topo, int threadCount) {
+    std::vector<BenchPlacement> order = BenchPlanPhysical(topo);
+    std::set<int> cores;
+    for (const BenchPlacement& p : topo.allowed) {
+        if (!cores.insert(p.core).second) order.push_back(p);
+    }
+    std::vector<BenchPlacement> plan;
+    if (threadCount < 1 || order.empty()) return plan;
+    plan.reserve(threadCount);
+    for (int i = 0; i < threadCount; i++) plan.push_back(order[i % order.size()]);
+    return plan;
+}
+
+// Pool threads outlive runs; remember whether this one is still pinned
+static thread_local bool t_pinned = false;
+
+void BenchApplyPlacement(const BenchPlacement& p, bool pin) {
+    BenchTopology topo = BenchGetTopology();
+#ifdef _WIN32
+    // A thread starts in its process's primary group; move it explicitly, to
+    // every allowed processor of the target group unless pinned
+    if (!pin && !t_pinned && topo.groupSizes.size() < 2) return;
+    KAFFINITY mask = 0;
+    for (const BenchPlacement& a : topo.allowed) {
+        if (a.group == p.group && (!pin || a.cpu == p.cpu)) mask |= (KAFFINITY)1 << a.cpu;
+    }
+    if (mask == 0) return;
+    GROUP_AFFINITY ga = {};
+    ga.Group = (WORD)p.group;
+    ga.Mask = mask;
+    SetThreadGroupAffinity(GetCurrentThread(), &ga, NULL);
+#else
+    if (!pin && !t_pinned) return;
+    int maxCpu = p.cpu;
+    for (const BenchPlacement& a : topo.allowed) {
+        if (a.cpu > maxCpu) maxCpu = a.cpu;
+    }
+    cpu_set_t* set = CPU_ALLOC(maxCpu + 1);
+    size_t size = CPU_ALLOC_SIZE(maxCpu + 1);
+    CPU_ZERO_S(size, set);
+    if (pin) {
+        CPU_SET_S(p.cpu, size, set);
+    } else {
+        for (const BenchPlacement& a : topo.allowed) CPU_SET_S(a.cpu, size, set);
+    }
+    sched_setaffinity(0, size, set);
+    CPU_FREE(set);
+#endif
+    t_pinned = pin;
+}
+
+const char* BenchClassLabel(int efficiencyClass, int classCount) {
+    static const char* numbered[] = { "C0", "C1", "C2", "C3", "C4", "C5", "C6", "C7" };
+    if (classCount < 2) return "";
+    if (classCount == 2) return efficiencyClass > 0 ? "P" : "E";
+    if (efficiencyClass >= 0 && efficiencyClass < 8) return numbered[efficiencyClass];
+    return "C?";
+}
+
+#ifdef _WIN32
+
+static void DetectCaches(BenchCacheInfo* info) {
+    DWORD len = 0;
+    GetLogicalProcessorInformationEx(RelationCache, NULL, &len);
+    std::vector<char> buf(len);
+    if (len && GetLogicalProcessorInformationEx(RelationCache, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buf.data(), &len)) {
+        for (DWORD off = 0; off < len; ) {
+            SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* rec = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buf.data() + off);
+            if (rec->Size == 0) break;
+            off += rec->Size;
+            const CACHE_RELATIONSHIP& c = rec->Cache;
+            if (c.Type != CacheData && c.Type != CacheUnified) continue;
+            // One record per cache instance; the first of each level is the first processor's
+            int64_t* slot = c.Level == 1 ? &info->l1d : c.Level == 2 ? &info->l2 : c.Level == 3 ? &info->l3 : NULL;
+            if (slot && *slot == 0) *slot = c.CacheSize;
+        }
+    }
+    MEMORYSTATUSEX mem = {};
+    mem.dwLength = sizeof(mem);
+    if (GlobalMemoryStatusEx(&mem)) info->memory = (int64_t)mem.ullTotalPhys;
+}
+
+#else
+
+// "48K", "2048K", "30M" as in sysfs cache/index*/size
+static int64_t ParseSize(const char* text) {
+    char* end;
+    int64_t n = strtoll(text, &end, 10);
+    if (*end == 'K') n <<= 10;
+    else if (*end == 'M') n <<= 20;
+    else if (*end == 'G') n <<= 30;
+    return n;
+}
+
+static void DetectCaches(BenchCacheInfo* info) {
+    char level[16], type[32], size[32];
+    for (int i = 0; ; i++) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + "/";
+        if (!ReadLine(dir + "level", level, sizeof(level))) break;
+        if (!ReadLine(dir + "type", type, sizeof(type)) || !ReadLine(dir + "size", size, sizeof(size))) continue;
+        if (strncmp(type, "Data", 4) != 0 && strncmp(type, "Unified", 7) != 0) continue;
+        int lv = atoi(level);
+        int64_t* slot = lv == 1 ? &info->l1d : lv == 2 ? &info->l2 : lv == 3 ? &info->l3 : NULL;
+        if (slot) *slot = ParseSize(size);
+    }
+    long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) info->memory = (int64_t)pages * pageSize;
+}
+
+#endif
+
+BenchCacheInfo BenchGetCacheInfo() {
+    static std::once_flag s_once;
+    static BenchCacheInfo s_info;
+    std::call_once(s_once, DetectCaches, &s_info);
+    return s_info;
+}
+
+#ifdef _WIN32
+
+// One RelationCache record per cache instance; the processors in its group
+// mask share it
+static void DetectLlc(const BenchTopology& topo, std::vector<int>* domains) {
+    DWORD len = 0;
+    GetLogicalProcessorInformationEx(RelationCache, NULL, &len);
+    std::vector<char> buf(len);
+    if (!len || !GetLogicalProcessorInformationEx(RelationCache, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buf.data(), &len)) return;
+    int top = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        int instance = 0;
+        for (DWORD off = 0; off < len; ) {
+            SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* rec = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buf.data() + off);
+            if (rec->Size == 0) break;
+            off += rec->Size;
+            const CACHE_RELATIONSHIP& c = rec->Cache;
+            if (c.Type != CacheData && c.Type != CacheUnified) continue;
+            if (pass == 0) {
+                if (c.Level > top) top = c.Level;
+                continue;
+            }
+            if (c.Level != top) continue;
+            for (size_t i = 0; i < topo.allowed.size(); i++) {
+                const BenchPlacement& p = topo.allowed[i];
+                if (p.group == c.GroupMask.Group && ((c.GroupMask.Mask >> p.cpu) & 1)) (*domains)[i] = instance;
+            }
+            instance++;
+        }
+    }
+}
+
+#else
+
+// The highest data or unified cache level of each CPU; its shared_cpu_list
+// names the domain by its first CPU
+static void DetectLlc(const BenchTopology& topo, std::vector<int>* domains) {
+    char level[16], type[32], shared[4096];
+    for (size_t i = 0; i < topo.allowed.size(); i++) {
+        int top = 0;
+        for (int index = 0; ; index++) {
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(topo.allowed[i].cpu) + "/cache/index" + std::to_string(index) + "/";
+            if (!ReadLine(dir + "level", level, sizeof(level))) break;
+            if (!ReadLine(dir + "type", type, sizeof(type))) continue;
+            if (strncmp(type, "Data", 4) != 0 && strncmp(type, "Unified", 7) != 0) continue;
+            if (atoi(level) <= top || !ReadLine(dir + "shared_cpu_list", shared, sizeof(shared))) continue;
+            std::vector<int> cpus = ParseCpuList(shared);
+            if (cpus.empty()) continue;
+            top = atoi(level);
+            (*domains)[i] = cpus[0];
+        }
+    }
+}
+
+#endif
+
+std::vector<int> BenchLlcDomains(const BenchTopology& topo) {
+    std::vector<int> domains(topo.allowed.size(), -1);
+    if (!topo.simulated) DetectLlc(topo, &domains);
+    return domains;
+}
+
+#ifdef _WIN32
+
+// GetNumaNodeProcessorMaskEx reports one group per node, which covers every
+// node up to 64 processors
+static void DetectNumaNodes(std::vector<BenchNumaNode>* nodes) {
+    BenchTopology topo = BenchGetTopology();
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return;
+    for (ULONG n = 0; n <= highest; n++) {
+        GROUP_AFFINITY ga = {};
+        ULONGLONG available = 0;
+        if (!GetNumaNodeProcessorMaskEx((USHORT)n, &ga)) continue;
+        GetNumaAvailableMemoryNodeEx((USHORT)n, &available);
+        BenchNumaNode node;
+        node.id = (int)n;
+        node.memory = (int64_t)available;
+        for (const BenchPlacement& p : topo.allowed) {
+            if (p.group == ga.Group && ((ga.Mask >> p.cpu) & 1)) node.cpus.push_back(p);
+        }
+        if (!node.cpus.empty() || node.memory > 0) nodes->push_back(node);
+    }
+}
+
+#else
+
+// Online nodes from sysfs, each with its cpulist and the MemTotal line of its meminfo
+static void DetectNumaNodes(std::vector<BenchNumaNode>* nodes) {
+    BenchTopology topo = BenchGetTopology();
+    char buf[4096];
+    if (!ReadLine("/sys/devices/system/node/online", buf, sizeof(buf))) return;
+    for (int id : ParseCpuList(buf)) {
+        std::string dir = "/sys/devices/system/node/node" + std::to_string(id) + "/";
+        BenchNumaNode node;
+        node.id = id;
+        if (ReadLine(dir + "cpulist", buf, sizeof(buf))) {
+            for (int cpu : ParseCpuList(buf)) {
+                for (const BenchPlacement& p : topo.allowed) {
+                    if (p.cpu == cpu) node.cpus.push_back(p);
+                }
+            }
+        }
+        FILE* f = fopen((dir + "meminfo").c_str(), "r");
+        if (f) {
+            long long kb;
+            while (fgets(buf, sizeof(buf), f)) {
+                if (sscanf(buf, "Node %*d MemTotal: %lld kB", &kb) == 1) node.memory = (int64_t)kb << 10;
+            }
+            fclose(f);
+        }
+        nodes->push_back(node);
+    }
+}
+
+#endif
+
+static void DetectNuma(std::vector<BenchNumaNode>* nodes) {
+    DetectNumaNodes(nodes);
+    if (nodes->empty()) {
+        BenchNumaNode node;
+        node.cpus = BenchGetTopology().allowed;
+        node.memory = BenchGetCacheInfo().memory;
+        nodes->push_back(node);
+    }
+}
+
+std::vector<BenchNumaNode> BenchNumaNodes() {
+    static std::once_flag s_once;
+    static std::vector<BenchNumaNode> s_nodes;
+    std::call_once(s_once, DetectNuma, &s_nodes);
+    return s_nodes;
+}
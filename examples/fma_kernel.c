@@ -0,0 +1,25 @@
+// Example kernel plugin: a dependent multiply-add chain, two flops per
+// iteration. Build it as a shared library against bench_plugin.h and load it
+// with ReactionTimeBench --plugin <file or directory>, or drop it into the
+// plugins directory next to the executables.
+#include "bench_plugin.h"
+
+static double RunFma(double x, int64_t iters) {
+    volatile double sink = x;
+    double a = x * 1e-9 + 1.0;
+    for (int64_t i = 0; i < iters; i++) {
+        a = a * 0.999999 + 1e-7;
+    }
+    sink = a;
+    return sink;
+}
+
+static const BenchKernelInfo kKernels[] = {
+    { BENCH_KERNEL_ABI_VERSION, "example-fma", "EXAMPLE FMA", "flop", 2.0, BENCH_KERNEL_MULTI, RunFma },
+};
+
+BENCH_PLUGIN_EXPORT int32_t BenchPluginEntry(uint32_t abiVersion, const BenchKernelInfo** kernels) {
+    if (abiVersion != BENCH_KERNEL_ABI_VERSION) return 0;
+    *kernels = kKernels;
+    return (int32_t)(sizeof(kKernels) / sizeof(kKernels[0]));
+}
@@ -11,6 +11,11 @@
 #include <xinput.h>
 #include <d3d11.h>
 #include <d3dcompiler.h>
+#include <atomic>
+#include <mutex>
+
+#include "bench.h"
+#include "bench_host.h"
 
 #pragma comment(lib, "winmm.lib")
 #pragma comment(lib, "d3d11.lib")
@@ -70,30 +75,47 @@ static int g_rebindingAction = -1;     // -1=none, 0=rebinding reset, 1=rebindin
 static LARGE_INTEGER g_rebindStartTime = {}; // timestamp when rebind mode was entered
 static char g_configPath[MAX_PATH] = {0};
 
-// Benchmark state
-static HANDLE g_benchThread = NULL;
-static volatile bool g_benchDone = false;
-static volatile bool g_benchCancel = false;
-static volatile LONGLONG g_benchOps = 0;
-static DWORD g_benchStartTick = 0;
-static double g_lastBenchScore = 0.0;  // result of last benchmark (Mops/s)
-static int g_lastBenchType = 0;        // 0=cpu, 1=gpu, 2=multicore
-static const DWORD BENCH_DURATION_MS = 10000;
+// Benchmark state (CPU runs live in bench.cpp; the GPU run is driven from here).
+// The GPU thread publishes progress through atomics; g_benchDone is stored last
+// (seq_cst) so everything the thread wrote is visible once the UI sees it.
+static HANDLE g_benchThread = NULL;           // stays set while a cancelled GPU thread drains
+static std::atomic<bool> g_benchDone(false);
+static std::atomic<bool> g_benchCancel(false);
+static std::atomic<LONGLONG> g_benchOps(0);
+static std::atomic<int64_t> g_benchStartNs(0);  // GPU barrier release (BenchNowNs), 0 while setting up
+static double g_gpuMeasuredSec = 0.0;         // GPU measurement window, warm-up excluded
+static std::mutex g_gpuStatsLock;
+static BenchRateStats g_gpuStats = {};        // GPU batch-means precision, guarded by g_gpuStatsLock
+static int64_t g_lastCancelNs = -1;           // measured latency of the last cancel, -1 = none
+static bool g_benchHosted = false;            // the running benchmark is in a child process
+static bool g_benchInProcess = false;         // config: skip the child process host
+static bool g_benchProcesses = false;         // multicore as one worker process per thread
+static bool g_benchProcRun = false;           // the running benchmark is an in-process BenchProc* run
+static char g_lastBenchError[256] = "";       // why the last hosted run produced no result
+static std::vector<double> g_gpuSeries;       // GPU ops/s per sample interval, read once the run is done
+static double g_lastBenchScore = 0.0;  // result of last benchmark (M<unit>/s)
+static int g_lastBenchKernel = 0;      // registry index of the last benchmark
+static double g_lastBenchPrecision = 0.0;  // 95 % CI half-width relative to the score, 0 = unknown
+static double g_lastBenchSeconds = 0.0;    // measured window of the last run
+static bool g_lastBenchConverged = false;  // adaptive run reached its precision target
+static char g_lastBenchCpus[128] = "";       // multicore: threads vs usable and machine CPUs
+static BenchTimeSeries g_lastBenchSeries;   // throughput over time for the result chart
+static BenchThrottleSummary g_lastBenchThrottle = {};
+static std::vector<BenchThreadResult> g_lastBenchCores;  // pinned multicore: one entry per worker
+static std::vector<BenchClassScore> g_lastBenchClasses;  // pinned multicore: efficiency-class subtotals
+static BenchSmtReport g_lastBenchSmt;                    // SMT placement modes: yield and sibling pairs
+static BenchScalingReport g_lastBenchScaling;            // scaling sweep: curve, model fit and knee
+static std::vector<double> g_lastBenchThreadRates;       // multicore: ops/s of every worker
+static BenchThreadSpread g_lastBenchSpread = {};         // multicore: per-thread spread and stragglers
+static int g_benchThreadCount = 0;
+static BenchConfig g_benchConfig;      // warm-up and measurement window for every type
 
 // Benchmark history
 static char g_benchHistoryPath[MAX_PATH] = {0};
-struct BenchHistoryEntry { char date[12]; double score; };
+struct BenchHistoryEntry { char date[12]; double score; double precision; bool throttled; int knee; };
 static BenchHistoryEntry g_benchHistory[20] = {};
 static int g_benchHistoryCount = 0;
 
-// Multi-core benchmark
-#define MAX_BENCH_THREADS 64
-static HANDLE g_benchThreads[MAX_BENCH_THREADS] = {};
-static int g_benchThreadCount = 0;
-// Per-thread counters, padded to avoid false sharing (64-byte cache lines)
-struct alignas(64) PaddedCounter { volatile LONGLONG ops; };
-static PaddedCounter g_threadOps[MAX_BENCH_THREADS] = {};
-
 // Gamepad state (joyGetPosEx — works with PS5, Xbox, Switch Pro, etc.)
 static int g_joyId = -1;           // cached joystick ID, -1 = needs scan
 static DWORD g_joyScanTime = 0;    // last scan timestamp (GetTickCount)
@@ -133,6 +155,20 @@ static void InitConfigPath() {
     else strcat(g_benchHistoryPath, ".benchmarks");
 }
 
+// Multicore placement as one menu choice: 0 floating, 1 pinned, 2-4 the SMT
+// modes, 5 one worker process per thread
+static int GetBenchPlacement() {
+    if (g_benchProcesses) return 5;
+    if (g_benchConfig.smtMode != BENCH_SMT_OFF) return 1 + g_benchConfig.smtMode;
+    return g_benchConfig.pinThreads ? 1 : 0;
+}
+
+static void SetBenchPlacement(int placement) {
+    g_benchConfig.pinThreads = placement == 1;
+    g_benchConfig.smtMode = placement >= 2 && placement <= 4 ? placement - 1 : BENCH_SMT_OFF;
+    g_benchProcesses = placement == 5;
+}
+
 // Save keybinds to config file
 static void SaveKeybinds() {
     FILE* f = fopen(g_configPath, "w");
@@ -141,6 +177,12 @@ static void SaveKeybinds() {
     fprintf(f, "resetCode=%d\n", g_bindReset.code);
     fprintf(f, "clickType=%d\n", (int)g_bindClick.type);
     fprintf(f, "clickCode=%d\n", g_bindClick.code);
+    fprintf(f, "benchAdaptive=%d\n", g_benchConfig.adaptive ? 1 : 0);
+    fprintf(f, "benchPinned=%d\n", g_benchConfig.pinThreads ? 1 : 0);
+    fprintf(f, "benchSmt=%d\n", g_benchConfig.smtMode);
+    fprintf(f, "benchScaling=%d\n", g_benchConfig.scalingMode);
+    fprintf(f, "benchInProcess=%d\n", g_benchInProcess ? 1 : 0);
+    fprintf(f, "benchProcesses=%d\n", g_benchProcesses ? 1 : 0);
     fclose(f);
 }
 
@@ -166,6 +208,18 @@ static void LoadKeybinds() {
             legacyKeyReset = val;
         } else if (sscanf(line, "clickButton=%d", &val) == 1) {
             legacyClickButton = val;
+        } else if (sscanf(line, "benchAdaptive=%d", &val) == 1) {
+            g_benchConfig.adaptive = val != 0;
+        } else if (sscanf(line, "benchPinned=%d", &val) == 1) {
+            g_benchConfig.pinThreads = val != 0;
+        } else if (sscanf(line, "benchSmt=%d", &val) == 1 && val >= BENCH_SMT_OFF && val <= BENCH_SMT_PAIRS) {
+            g_benchConfig.smtMode = val;
+        } else if (sscanf(line, "benchInProcess=%d", &val) == 1) {
+            g_benchInProcess = val != 0;
+        } else if (sscanf(line, "benchProcesses=%d", &val) == 1) {
+            g_benchProcesses = val != 0;
+        } else if (sscanf(line, "benchScaling=%d", &val) == 1 && val >= BENCH_SCALING_POW2 && val <= BENCH_SCALING_EVERY) {
+            g_benchConfig.scalingMode = val;
         }
     }
     fclose(f);
@@ -192,19 +246,16 @@ static void LoadKeybinds() {
     }
 }
 
-// Save a benchmark result to history file
-static void SaveBenchResult(int type, double score) {
-    FILE* f = fopen(g_benchHistoryPath, "a");
-    if (!f) return;
-    SYSTEMTIME st;
-    GetLocalTime(&st);
-    fprintf(f, "%d,%02d/%02d %02d:%02d,%.6f\n",
-        type, st.wMonth, st.wDay, st.wHour, st.wMinute, score);
-    fclose(f);
+// Save a benchmark result to the history file, keyed by kernel name
+static void SaveBenchResult(const char* kernel, double score, double precision, const BenchTimeSeries& series,
+                            const BenchThrottleSummary& throttle, const std::vector<BenchThreadResult>& cores,
+                            const BenchSmtReport& smt, const BenchScalingReport& scaling) {
+    BenchAppendHistory(g_benchHistoryPath, kernel, score, precision, series, throttle, cores, smt, scaling, NULL);
 }
 
-// Load benchmark history for a specific type (last 20, newest first)
-static void LoadBenchHistory(int type) {
+// Load benchmark history for one kernel (last 20, newest first). Lines from
+// before the kernel registry start with the old numeric type instead of a name.
+static void LoadBenchHistory(const char* kernel) {
     g_benchHistoryCount = 0;
     FILE* f = fopen(g_benchHistoryPath, "r");
     if (!f) return;
@@ -212,15 +263,24 @@ static void LoadBenchHistory(int type) {
     // Read all matching entries into a temp buffer
     BenchHistoryEntry all[1024];
     int total = 0;
-    char line[256];
+    char line[32768];  // room for the time series, per-core scores and a scaling curve
     while (fgets(line, sizeof(line), f) && total < 1024) {
-        int t;
-        char date[12];
-        double score;
-        if (sscanf(line, "%d,%11[^,],%lf", &t, date, &score) == 3 && t == type) {
+        int throttled = 0;
+        char name[BENCH_KERNEL_NAME_MAX], date[12];
+        double score, precision = 0.0, dropPct = 0.0;
+        if (sscanf(line, "%31[^,],%11[^,],%lf,%lf,%lf,%d", name, date, &score, &precision, &dropPct, &throttled) < 3) continue;
+        const char* legacy = name[0] >= '0' && name[0] <= '9' ? BenchLegacyKernelName(atoi(name)) : NULL;
+        if (strcmp(legacy ? legacy : name, kernel) == 0) {
             strncpy(all[total].date, date, sizeof(all[total].date) - 1);
             all[total].date[sizeof(all[total].date) - 1] = '\0';
             all[total].score = score;
+            all[total].precision = precision;
+            all[total].throttled = throttled != 0;
+            all[total].knee = 0;
+            const char* sc = strstr(line, ",scaling:");
+            int mode;
+            double serial, sigma, kappa;
+            if (sc) sscanf(sc, ",scaling:%d:%lf:%lf:%lf:%d", &mode, &serial, &sigma, &kappa, &all[total].knee);
             total++;
         }
     }
@@ -239,7 +299,8 @@ static void LoadBenchHistory(int type) {
 static POINT g_mousePos = {0, 0};
 static int g_hoveredButton = -1;
 static int g_selectedButton = -1;  // keyboard/gamepad selected button, -1 = none
-static UIButton g_buttons[16];
+#define MAX_BUTTONS 24
+static UIButton g_buttons[MAX_BUTTONS];
 static int g_buttonCount = 0;
 
 // Button IDs
@@ -254,11 +315,49 @@ enum ButtonID {
     BTN_COPY_EMAIL,
     BTN_CLOSE,
     BTN_BENCHMARK,
-    BTN_BENCH_CPU,
-    BTN_BENCH_GPU,
-    BTN_BENCH_MULTICORE
+    BTN_BENCH_MODE,
+    BTN_BENCH_PLACEMENT,
+    BTN_BENCH_PAGE,
+    BTN_BENCH_KERNEL    // + registry index, one per kernel in the benchmark menu
 };
 
+// Kernels per benchmark menu page; a page button steps through the rest
+#define BENCH_MENU_KERNELS 8
+#define BENCH_MENU_MIN_BTN_H 28    // smallest menu button before it splits into two columns
+
+static int g_benchMenuPage = 0;
+
+// Pages of menu kernels: every registry entry except the forced variants
+// (simd-avx2 ...), which are left to the headless runner
+static int MenuPageCount() {
+    int n = 0;
+    for (const BenchKernel& k : BenchKernels()) {
+        if (!k.variant) n++;
+    }
+    return n > 0 ? (n + BENCH_MENU_KERNELS - 1) / BENCH_MENU_KERNELS : 1;
+}
+
+// Registry indices of the kernels on the current menu page, in registry order
+static int MenuKernels(int* indices) {
+    const std::vector<BenchKernel>& ks = BenchKernels();
+    if (g_benchMenuPage >= MenuPageCount()) g_benchMenuPage = 0;
+    int first = g_benchMenuPage * BENCH_MENU_KERNELS, seen = 0, n = 0;
+    for (int i = 0; i < (int)ks.size() && n < BENCH_MENU_KERNELS; i++) {
+        if (ks[i].variant) continue;
+        if (seen++ >= first) indices[n++] = i;
+    }
+    return n;
+}
+
+static bool IsMenuKernel(int index) {
+    int indices[BENCH_MENU_KERNELS];
+    int n = MenuKernels(indices);
+    for (int i = 0; i < n; i++) {
+        if (indices[i] == index) return true;
+    }
+    return false;
+}
+
 // Colors
 static const COLORREF COLOR_GREEN = RGB(0, 180, 0);
 static const COLORREF COLOR_RED = RGB(220, 0, 0);
@@ -600,7 +699,7 @@ static void DrawButton(HDC hdc, int centerX, int y, int width, int height,
     btnRect.bottom = y + height;
 
     // Register button for hit-testing
-    if (g_buttonCount < 16) {
+    if (g_buttonCount < MAX_BUTTONS) {
         g_buttons[g_buttonCount].rect = btnRect;
         g_buttons[g_buttonCount].id = id;
         strncpy(g_buttons[g_buttonCount].text, text, 63);
@@ -635,6 +734,276 @@ static void DrawButton(HDC hdc, int centerX, int y, int width, int height,
     TextOutA(hdc, tx, ty, text, (int)strlen(text));
 }
 
+// Draw a throughput-over-time chart: warm-up shaded, peak and sustained levels marked
+static void DrawRateChart(HDC hdc, RECT rc, const BenchTimeSeries& series,
+                          const BenchThrottleSummary& throttle, const BenchRateUnit& rate, HFONT font) {
+    HBRUSH bg = CreateSolidBrush(RGB(35, 35, 42));
+    FillRect(hdc, &rc, bg);
+    DeleteObject(bg);
+
+    int count = (int)series.total.size();
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    if (count >= 2 && w > 20 && h > 20) {
+        // Scale to the data range so a few-percent drop is visible
+        double lo = series.total[0], hi = series.total[0];
+        for (int i = 1; i < count; i++) {
+            if (series.total[i] < lo) lo = series.total[i];
+            if (series.total[i] > hi) hi = series.total[i];
+        }
+        double pad = (hi - lo) * 0.1 + hi * 0.01;
+        lo -= pad;
+        hi += pad;
+        if (lo < 0.0) lo = 0.0;
+
+        // Warm-up region
+        if (series.warmupSamples > 0) {
+            int wx = rc.left + (int)((double)series.warmupSamples / (count - 1) * (w - 1));
+            if (wx > rc.right) wx = rc.right;
+            RECT warm = { rc.left, rc.top, wx, rc.bottom };
+            HBRUSH warmBrush = CreateSolidBrush(RGB(45, 45, 55));
+            FillRect(hdc, &warm, warmBrush);
+            DeleteObject(warmBrush);
+        }
+
+        // Peak and sustained levels
+        double levels[2] = { throttle.peak, throttle.sustained };
+        COLORREF levelColors[2] = { RGB(90, 90, 105), throttle.throttled ? COLOR_ACCENT : RGB(90, 140, 90) };
+        for (int l = 0; l < 2; l++) {
+            if (levels[l] <= lo || levels[l] >= hi) continue;
+            int ly = rc.bottom - 1 - (int)((levels[l] - lo) / (hi - lo) * (h - 1));
+            HPEN levelPen = CreatePen(PS_DOT, 1, levelColors[l]);
+            HPEN oldPen = (HPEN)SelectObject(hdc, levelPen);
+            MoveToEx(hdc, rc.left, ly, NULL);
+            LineTo(hdc, rc.right, ly);
+            SelectObject(hdc, oldPen);
+            DeleteObject(levelPen);
+        }
+
+        // Rate line
+        POINT* pts = new POINT[count];
+        for (int i = 0; i < count; i++) {
+            pts[i].x = rc.left + (int)((double)i / (count - 1) * (w - 1));
+            pts[i].y = rc.bottom - 1 - (int)((series.total[i] - lo) / (hi - lo) * (h - 1));
+        }
+        HPEN linePen = CreatePen(PS_SOLID, 2, COLOR_WHITE);
+        HPEN oldPen = (HPEN)SelectObject(hdc, linePen);
+        Polyline(hdc, pts, count);
+        SelectObject(hdc, oldPen);
+        DeleteObject(linePen);
+        delete[] pts;
+
+        // Axis labels
+        char label[64];
+        SelectObject(hdc, font);
+        SetBkMode(hdc, TRANSPARENT);
+        SetTextColor(hdc, RGB(120, 120, 130));
+        snprintf(label, sizeof(label), "%.1f %s", hi / rate.scale, rate.label);
+        TextOutA(hdc, rc.left + 6, rc.top + 4, label, (int)strlen(label));
+        snprintf(label, sizeof(label), "%.1f s", count * series.intervalMs / 1000.0);
+        SIZE ls;
+        GetTextExtentPoint32A(hdc, label, (int)strlen(label), &ls);
+        TextOutA(hdc, rc.right - ls.cx - 6, rc.bottom - ls.cy - 4, label, (int)strlen(label));
+    }
+
+    HPEN borderPen = CreatePen(PS_SOLID, 1, RGB(80, 80, 95));
+    HPEN oldPen = (HPEN)SelectObject(hdc, borderPen);
+    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+    Rectangle(hdc, rc.left, rc.top, rc.right, rc.bottom);
+    SelectObject(hdc, oldPen);
+    SelectObject(hdc, oldBrush);
+    DeleteObject(borderPen);
+}
+
+// Speedup against thread count: ideal (dotted), fitted USL model (dotted),
+// measured (solid) and parallel efficiency on a 0-100 % scale, knee marked
+static void DrawScalingChart(HDC hdc, RECT rc, const BenchScalingReport& scaling, HFONT font) {
+    HBRUSH bg = CreateSolidBrush(RGB(35, 35, 42));
+    FillRect(hdc, &rc, bg);
+    DeleteObject(bg);
+
+    int count = (int)scaling.points.size();
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    if (count >= 2 && w > 20 && h > 20) {
+        double maxN = scaling.points.back().threads;
+        double top = 1.0;
+        for (const BenchScalingPoint& p : scaling.points) {
+            if (p.speedup > top) top = p.speedup;
+        }
+        top *= 1.15;
+        auto px = [&](double n) { return rc.left + (int)(n / maxN * (w - 1)); };
+        auto py = [&](double v) { return rc.bottom - 1 - (int)(v / top * (h - 1)); };
+
+        // Knee
+        const BenchScalingFit& fit = scaling.fit;
+        HPEN kneePen = CreatePen(PS_DOT, 1, COLOR_ACCENT);
+        HPEN oldPen = (HPEN)SelectObject(hdc, kneePen);
+        MoveToEx(hdc, px(fit.kneeThreads), rc.top, NULL);
+        LineTo(hdc, px(fit.kneeThreads), rc.bottom);
+        SelectObject(hdc, oldPen);
+        DeleteObject(kneePen);
+
+        // Ideal speedup, clipped to the top of the chart
+        HPEN idealPen = CreatePen(PS_DOT, 1, RGB(90, 90, 105));
+        oldPen = (HPEN)SelectObject(hdc, idealPen);
+        double idealEnd = maxN < top ? maxN : top;
+        MoveToEx(hdc, px(0.0), py(0.0), NULL);
+        LineTo(hdc, px(idealEnd), py(idealEnd));
+        SelectObject(hdc, oldPen);
+        DeleteObject(idealPen);
+
+        // USL fit, one vertex per few pixels
+        int steps = w / 4 > 2 ? w / 4 : 2;
+        POINT* pts = new POINT[steps + 1];
+        for (int i = 0; i <= steps; i++) {
+            double n = 1.0 + (maxN - 1.0) * i / steps;
+            double s = n / (1.0 + fit.sigma * (n - 1.0) + fit.kappa * n * (n - 1.0));
+            pts[i].x = px(n);
+            pts[i].y = py(s);
+        }
+        HPEN fitPen = CreatePen(PS_DOT, 1, RGB(90, 140, 90));
+        oldPen = (HPEN)SelectObject(hdc, fitPen);
+        Polyline(hdc, pts, steps + 1);
+        SelectObject(hdc, oldPen);
+        DeleteObject(fitPen);
+        delete[] pts;
+
+        // Measured speedup and efficiency
+        pts = new POINT[count];
+        POINT* effPts = new POINT[count];
+        for (int i = 0; i < count; i++) {
+            pts[i].x = effPts[i].x = px(scaling.points[i].threads);
+            pts[i].y = py(scaling.points[i].speedup);
+            effPts[i].y = rc.bottom - 1 - (int)(scaling.points[i].efficiency * (h - 1) * 0.95);
+        }
+        HPEN effPen = CreatePen(PS_SOLID, 1, RGB(150, 150, 160));
+        oldPen = (HPEN)SelectObject(hdc, effPen);
+        Polyline(hdc, effPts, count);
+        SelectObject(hdc, oldPen);
+        DeleteObject(effPen);
+        HPEN linePen = CreatePen(PS_SOLID, 2, COLOR_WHITE);
+        oldPen = (HPEN)SelectObject(hdc, linePen);
+        Polyline(hdc, pts, count);
+        HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+        for (int i = 0; i < count; i++) {
+            Rectangle(hdc, pts[i].x - 3, pts[i].y - 3, pts[i].x + 4, pts[i].y + 4);
+        }
+        SelectObject(hdc, oldBrush);
+        SelectObject(hdc, oldPen);
+        DeleteObject(linePen);
+        delete[] pts;
+        delete[] effPts;
+
+        // Axis labels
+        char label[64];
+        SelectObject(hdc, font);
+        SetBkMode(hdc, TRANSPARENT);
+        SetTextColor(hdc, RGB(120, 120, 130));
+        snprintf(label, sizeof(label), "%.1fx speedup (white), efficiency (gray)", top);
+        TextOutA(hdc, rc.left + 6, rc.top + 4, label, (int)strlen(label));
+        snprintf(label, sizeof(label), "%d threads", scaling.points.back().threads);
+        SIZE ls;
+        GetTextExtentPoint32A(hdc, label, (int)strlen(label), &ls);
+        TextOutA(hdc, rc.right - ls.cx - 6, rc.bottom - ls.cy - 4, label, (int)strlen(label));
+    }
+
+    HPEN borderPen = CreatePen(PS_SOLID, 1, RGB(80, 80, 95));
+    HPEN oldPen = (HPEN)SelectObject(hdc, borderPen);
+    HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+    Rectangle(hdc, rc.left, rc.top, rc.right, rc.bottom);
+    SelectObject(hdc, oldPen);
+    SelectObject(hdc, oldBrush);
+    DeleteObject(borderPen);
+}
+
+// Compact strip with one bar per worker scaled to the fastest; stragglers in
+// the accent color
+static void DrawThreadStrip(HDC hdc, RECT rc, const std::vector<double>& rates, const BenchThreadSpread& spread) {
+    int count = (int)rates.size();
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    if (count < 2 || w < count || h < 4 || spread.max <= 0.0) return;
+    HBRUSH bg = CreateSolidBrush(RGB(35, 35, 42));
+    FillRect(hdc, &rc, bg);
+    DeleteObject(bg);
+    HBRUSH normal = CreateSolidBrush(RGB(150, 150, 160));
+    HBRUSH slow = CreateSolidBrush(COLOR_ACCENT);
+    for (int i = 0; i < count; i++) {
+        bool straggler = false;
+        for (const BenchStraggler& st : spread.stragglers) {
+            if (st.thread == i) straggler = true;
+        }
+        int x0 = rc.left + (int)((int64_t)i * w / count);
+        int x1 = rc.left + (int)((int64_t)(i + 1) * w / count);
+        if (x1 - x0 > 2) x1--;  // gap between bars when there is room
+        int bh = (int)(rates[i] / spread.max * h);
+        RECT bar = { x0, rc.bottom - bh, x1, rc.bottom };
+        FillRect(hdc, &bar, straggler ? slow : normal);
+    }
+    DeleteObject(normal);
+    DeleteObject(slow);
+}
+
+// One labelled bar in a result grid
+struct GridCell { char label[48]; double value; bool alt; };
+
+// Draw per-core (or per-pair) values as a grid of bars scaled to the largest,
+// so weak cores stand out; `alt` cells (efficiency cores) get a second color
+static void DrawBarGrid(HDC hdc, RECT rc, const std::vector<GridCell>& cells, HFONT font) {
+    int count = (int)cells.size();
+    int w = rc.right - rc.left, h = rc.bottom - rc.top;
+    if (count == 0 || w < 100 || h < 20) return;
+    double best = 0.0;
+    for (const GridCell& c : cells) {
+        if (c.value > best) best = c.value;
+    }
+    int cols = w / 118;
+    if (cols < 1) cols = 1;
+    if (cols > count) cols = count;
+    int rows = (count + cols - 1) / cols;
+    int cellW = w / cols, cellH = h / rows;
+    if (cellH > 22) cellH = 22;
+    if (cellH < 10) return;  // too many cores for this window; the subtotals still show
+
+    SelectObject(hdc, font);
+    SetBkMode(hdc, TRANSPARENT);
+    for (int i = 0; i < count; i++) {
+        const GridCell& c = cells[i];
+        int x = rc.left + (i % cols) * cellW, y = rc.top + (i / cols) * cellH;
+        RECT bar = { x + 2, y + 2, x + 2 + (int)((cellW - 4) * (best > 0.0 ? c.value / best : 0.0)), y + cellH - 2 };
+        HBRUSH brush = CreateSolidBrush(c.alt ? RGB(50, 75, 95) : RGB(70, 70, 88));
+        FillRect(hdc, &bar, brush);
+        DeleteObject(brush);
+        SetTextColor(hdc, RGB(170, 170, 180));
+        TextOutA(hdc, x + 6, y + (cellH - 14) / 2, c.label, (int)strlen(c.label));
+    }
+}
+
+// Grid cells for the last pinned run: sibling pairs in SMT pairs mode,
+// otherwise one cell per core labelled with its CPU, efficiency class and rate
+static std::vector<GridCell> BuildCoreCells(int classCount, const BenchRateUnit& rate) {
+    std::vector<GridCell> cells;
+    if (!g_lastBenchSmt.pairs.empty()) {
+        for (const BenchSmtPair& p : g_lastBenchSmt.pairs) {
+            GridCell c = {};
+            if (p.cpuB >= 0)
+                snprintf(c.label, sizeof(c.label), "%d+%d x%.2f -%.0f%%", p.cpuA, p.cpuB, p.yield, p.slowdownPct);
+            else
+                snprintf(c.label, sizeof(c.label), "%d x%.2f", p.cpuA, p.yield);
+            c.value = p.paired;
+            cells.push_back(c);
+        }
+        return cells;
+    }
+    for (const BenchThreadResult& t : g_lastBenchCores) {
+        GridCell c = {};
+        snprintf(c.label, sizeof(c.label), "%d%s %.2f", t.placement.cpu,
+            BenchClassLabel(t.placement.efficiencyClass, classCount), t.opsPerSec / rate.scale);
+        c.value = t.opsPerSec;
+        c.alt = classCount > 1 && t.placement.efficiencyClass == 0;
+        cells.push_back(c);
+    }
+    return cells;
+}
+
 // Hit-test buttons at given screen position, returns button id or -1
 static int HitTestButtons(int screenX, int screenY) {
     POINT clientPt = { screenX, screenY };
@@ -692,9 +1061,16 @@ static int GetMenuButtonIds(int* ids, int maxIds) {
             if (count < maxIds) ids[count++] = BTN_BACK;
             break;
         case STATE_BENCHMARK_MENU:
-            if (count < maxIds) ids[count++] = BTN_BENCH_CPU;
-            if (count < maxIds) ids[count++] = BTN_BENCH_MULTICORE;
-            if (count < maxIds) ids[count++] = BTN_BENCH_GPU;
+            {
+                int kernels[BENCH_MENU_KERNELS];
+                int n = MenuKernels(kernels);
+                for (int i = 0; i < n; i++) {
+                    if (count < maxIds) ids[count++] = BTN_BENCH_KERNEL + kernels[i];
+                }
+            }
+            if (MenuPageCount() > 1 && count < maxIds) ids[count++] = BTN_BENCH_PAGE;
+            if (count < maxIds) ids[count++] = BTN_BENCH_MODE;
+            if (count < maxIds) ids[count++] = BTN_BENCH_PLACEMENT;
             if (count < maxIds) ids[count++] = BTN_BACK;
             break;
         default:
@@ -705,8 +1081,8 @@ static int GetMenuButtonIds(int* ids, int maxIds) {
 
 // Navigate menu selection up (-1) or down (+1)
 static void NavigateMenu(int direction) {
-    int ids[16];
-    int count = GetMenuButtonIds(ids, 16);
+    int ids[MAX_BUTTONS];
+    int count = GetMenuButtonIds(ids, MAX_BUTTONS);
     if (count == 0) return;
 
     if (g_selectedButton == -1) {
@@ -869,56 +1245,6 @@ static HICON CreateAppIcon(int size) {
     return icon;
 }
 
-// CPU benchmark thread: tight math loop (single-core)
-static DWORD WINAPI BenchmarkCPUThread(LPVOID) {
-    volatile double x = 1.0;
-    LONGLONG ops = 0;
-    while (true) {
-        x = sin(x) * cos(x) + sqrt(x + 1.0);
-        ops++;
-        if ((ops & 0xFFFF) == 0) {
-            g_benchOps = ops;
-            if (g_benchCancel) return 0;
-            if (GetTickCount() - g_benchStartTick >= BENCH_DURATION_MS) break;
-        }
-    }
-    g_benchOps = ops;
-    g_benchDone = true;
-    return 0;
-}
-
-// CPU multi-core benchmark thread: each thread writes to its own padded counter
-static DWORD WINAPI BenchmarkMulticoreThread(LPVOID param) {
-    int idx = (int)(intptr_t)param;
-    volatile double x = 1.0 + idx;
-    LONGLONG ops = 0;
-    while (true) {
-        x = sin(x) * cos(x) + sqrt(x + 1.0);
-        ops++;
-        if ((ops & 0xFFFF) == 0) {
-            g_threadOps[idx].ops = ops;
-            if (g_benchCancel) return 0;
-            if (GetTickCount() - g_benchStartTick >= BENCH_DURATION_MS) break;
-        }
-    }
-    g_threadOps[idx].ops = ops;
-    return 0;
-}
-
-// Multi-core coordinator thread: waits for all worker threads, then sums
-static DWORD WINAPI BenchmarkMulticoreCoordinator(LPVOID) {
-    WaitForMultipleObjects((DWORD)g_benchThreadCount, g_benchThreads, TRUE, INFINITE);
-    LONGLONG total = 0;
-    for (int i = 0; i < g_benchThreadCount; i++) {
-        total += g_threadOps[i].ops;
-        CloseHandle(g_benchThreads[i]);
-        g_benchThreads[i] = NULL;
-    }
-    g_benchOps = total;
-    g_benchDone = true;
-    return 0;
-}
-
 // GPU benchmark thread: D3D11 compute shader
 static DWORD WINAPI BenchmarkGPUThread(LPVOID) {
     // HLSL compute shader — 512 iterations of sin*cos+sqrt per thread
@@ -1000,7 +1326,23 @@ static DWORD WINAPI BenchmarkGPUThread(LPVOID) {
         ctx->CSSetShader(cs, NULL, 0);
         ctx->CSSetUnorderedAccessViews(0, 1, &uav, NULL);
 
-        LONGLONG ops = 0;
+        // Device setup is done: start the clock, warm up, then measure
+        int64_t release = BenchNowNs();
+        const BenchConfig& cfg = g_benchConfig;
+        int64_t warmupEnd = release + (int64_t)cfg.warmupMs * 1000000;
+        int64_t stopAt = warmupEnd + (int64_t)(cfg.adaptive ? cfg.maxDurationMs : cfg.durationMs) * 1000000;
+        int64_t minStop = warmupEnd + (int64_t)cfg.minDurationMs * 1000000;
+        int64_t batchNs = (int64_t)cfg.sampleIntervalMs * BENCH_BATCH_INTERVALS * 1000000;
+        g_benchStartNs = release;
+
+        LONGLONG ops = 0, startOps = 0, batchOps = 0, sampleOps = 0;
+        int64_t startNs = 0, now = release, batchStartNs = 0, sampleNs = release;
+        int64_t intervalNs = (int64_t)cfg.sampleIntervalMs * 1000000;
+        int64_t nextSampleAt = release + intervalNs;
+        double batchRates[1024];
+        int batchCount = 0;
+        bool measuring = cfg.warmupMs <= 0;
+        if (measuring) startNs = batchStartNs = release;
         while (true) {
             // Dispatch multiple batches before syncing
             for (int b = 0; b < BATCHES_PER_DISPATCH; b++)
@@ -1018,9 +1360,44 @@ static DWORD WINAPI BenchmarkGPUThread(LPVOID) {
             g_benchOps = ops;
 
             if (g_benchCancel) { g_benchOps = 0; goto cleanup; }
-            if (GetTickCount() - g_benchStartTick >= BENCH_DURATION_MS) break;
+            now = BenchNowNs();
+            // Time series: a dispatch batch can span several intervals, spread its rate over them
+            if (now >= nextSampleAt) {
+                double rate = (double)(ops - sampleOps) * 1e9 / (double)(now - sampleNs);
+                while (nextSampleAt <= now) {
+                    g_gpuSeries.push_back(rate);
+                    nextSampleAt += intervalNs;
+                }
+                sampleOps = ops;
+                sampleNs = now;
+            }
+            if (!measuring) {
+                if (now >= warmupEnd) {
+                    measuring = true;
+                    startNs = batchStartNs = now;
+                    startOps = batchOps = ops;
+                }
+                continue;
+            }
+            // Batch-means precision, same rule as the CPU runs
+            if (now - batchStartNs >= batchNs && batchCount < 1024) {
+                batchRates[batchCount++] = (double)(ops - batchOps) * 1e9 / (double)(now - batchStartNs);
+                batchStartNs = now;
+                batchOps = ops;
+                BenchRateStats st = BenchComputeRateStats(batchRates, batchCount);
+                {
+                    std::lock_guard<std::mutex> lock(g_gpuStatsLock);
+                    g_gpuStats = st;
+                }
+                if (cfg.adaptive && now >= minStop && st.batches >= 3 &&
+                    st.precision > 0.0 && st.precision <= cfg.targetPrecision) {
+                    break;
+                }
+            }
+            if (now >= stopAt) break;
         }
-        g_benchOps = ops;
+        g_benchOps = ops - startOps;
+        g_gpuMeasuredSec = (double)(now - startNs) / 1e9;
     }
     goto cleanup;
 
@@ -1039,57 +1416,181 @@ cleanup:
     return 0;
 }
 
-// Start a specific benchmark (0=CPU, 1=GPU, 2=Multicore)
-static void StartBenchmarkType(int type) {
-    g_lastBenchType = type;
+// Start the benchmark of one registry kernel; its thread model picks the state
+// and how many workers run it
+static void StartBenchmark(int kernelIndex) {
+    const BenchKernel& kernel = BenchKernels()[kernelIndex];
+    bool gpu = kernel.threadModel == BENCH_KERNEL_EXTERNAL;
+    // Reap a GPU thread that outlived its cancel bound before reusing the state it touches
+    if (g_benchThread) {
+        WaitForSingleObject(g_benchThread, INFINITE);
+        CloseHandle(g_benchThread);
+        g_benchThread = NULL;
+    }
+    g_lastCancelNs = -1;
+    g_lastBenchError[0] = 0;
+    g_lastBenchKernel = kernelIndex;
     g_lastBenchScore = 0.0;
     g_benchOps = 0;
     g_benchDone = false;
     g_benchCancel = false;
-    g_benchStartTick = GetTickCount();
-
-    if (type == 0) {
-        g_state = STATE_BENCHMARK_CPU;
-        g_benchThread = CreateThread(NULL, 0, BenchmarkCPUThread, NULL, 0, NULL);
-    } else if (type == 1) {
+    g_benchStartNs = 0;
+    g_gpuMeasuredSec = 0.0;
+    g_gpuStats = BenchRateStats();
+    g_gpuSeries.clear();
+    g_lastBenchSeries = BenchTimeSeries();
+    g_lastBenchThrottle = BenchThrottleSummary();
+    g_lastBenchPrecision = 0.0;
+    g_lastBenchSeconds = 0.0;
+    g_lastBenchConverged = false;
+    g_lastBenchCpus[0] = 0;
+    g_lastBenchCores.clear();
+    g_lastBenchClasses.clear();
+    g_lastBenchSmt = BenchSmtReport();
+    g_lastBenchScaling = BenchScalingReport();
+    g_lastBenchThreadRates.clear();
+    g_lastBenchSpread = BenchThreadSpread();
+
+    BenchConfig cfg = g_benchConfig;
+    snprintf(cfg.kernel, sizeof(cfg.kernel), "%s", kernel.name.c_str());
+    if (gpu) {
         g_state = STATE_BENCHMARK_GPU;
-        g_benchThread = CreateThread(NULL, 0, BenchmarkGPUThread, NULL, 0, NULL);
+    } else if (kernel.threadModel == BENCH_KERNEL_SINGLE) {
+        g_state = STATE_BENCHMARK_CPU;
+        cfg.threadCount = 1;
+        cfg.pinThreads = false;
+        cfg.smtMode = BENCH_SMT_OFF;
+        cfg.scalingMode = BENCH_SCALING_OFF;
     } else {
         g_state = STATE_BENCHMARK_MULTICORE;
-        SYSTEM_INFO si;
-        GetSystemInfo(&si);
-        g_benchThreadCount = (int)si.dwNumberOfProcessors;
-        if (g_benchThreadCount > MAX_BENCH_THREADS) g_benchThreadCount = MAX_BENCH_THREADS;
-        for (int i = 0; i < g_benchThreadCount; i++) {
-            g_threadOps[i].ops = 0;
-            g_benchThreads[i] = CreateThread(NULL, 0, BenchmarkMulticoreThread, (LPVOID)(intptr_t)i, 0, NULL);
+        // Every processor group, not just the one GetSystemInfo reports, limited
+        // to what the process may use (affinity mask, job CPU rate cap)
+        cfg.threadCount = BenchGetTopology().effectiveCount;
+        if (cfg.threadCount > BENCH_MAX_THREADS) cfg.threadCount = BENCH_MAX_THREADS;
+        if (kernel.threadModel == BENCH_KERNEL_SWEEP) {
+            // Sweep up to the usable CPUs; SMT modes are a placement of their own
+            cfg.smtMode = BENCH_SMT_OFF;
+            if (cfg.scalingMode == BENCH_SCALING_OFF) cfg.scalingMode = BENCH_SCALING_POW2;
+        } else {
+            cfg.scalingMode = BENCH_SCALING_OFF;
         }
-        // Coordinator thread waits for all workers and sets g_benchDone
-        g_benchThread = CreateThread(NULL, 0, BenchmarkMulticoreCoordinator, NULL, 0, NULL);
+    }
+    g_benchThreadCount = gpu ? 0 : cfg.threadCount;
+    bool processes = kernel.threadModel == BENCH_KERNEL_MULTI && g_benchProcesses;
+
+    // Run in a child copy of this executable so a crashing kernel or a hung
+    // driver can't take the UI down; in-process if the host can't be launched
+    int job = gpu ? BENCH_HOST_JOB_GPU : processes ? BENCH_HOST_JOB_PROCESSES : BENCH_HOST_JOB_CPU;
+    g_benchHosted = !g_benchInProcess && BenchHostStart(cfg, job, NULL);
+    g_benchProcRun = !g_benchHosted && processes;
+    if (!g_benchHosted) {
+        if (gpu) g_benchThread = CreateThread(NULL, 0, BenchmarkGPUThread, NULL, 0, NULL);
+        else if (processes) BenchProcStart(cfg);
+        else BenchStart(cfg);
     }
     InvalidateRect(g_hwnd, NULL, FALSE);
 }
 
-// Cancel a running benchmark and return to benchmark menu
-static void CancelBenchmark() {
-    g_benchCancel = true;
+// GPU run progress from the globals its thread updates
+static BenchProgress GpuProgress() {
+    BenchProgress p = {};
+    int windowMs = g_benchConfig.adaptive ? g_benchConfig.maxDurationMs : g_benchConfig.durationMs;
+    p.totalNs = ((int64_t)g_benchConfig.warmupMs + windowMs) * 1000000;
+    p.ops = g_benchOps;
+    p.runPhaseCount = 1;
+    {
+        std::lock_guard<std::mutex> lock(g_gpuStatsLock);
+        p.stats = g_gpuStats;
+    }
+    int64_t start = g_benchStartNs;
+    if (start == 0) {
+        p.phase = BENCH_PHASE_STARTING;
+    } else {
+        p.elapsedNs = BenchNowNs() - start;
+        p.phase = (p.elapsedNs < (int64_t)g_benchConfig.warmupMs * 1000000) ? BENCH_PHASE_WARMUP : BENCH_PHASE_MEASURE;
+    }
+    return p;
+}
+
+// Progress of the running benchmark in the same shape for CPU and GPU runs
+static BenchProgress GetBenchProgress() {
+    if (g_benchHosted) return BenchHostGetProgress();
+    if (g_benchProcRun) return BenchProcGetProgress();
+    if (g_state != STATE_BENCHMARK_GPU) return BenchGetProgress();
+    return GpuProgress();
+}
+
+// The GPU run as a benchmark host job: the same thread and globals as the
+// in-process run, collected into a BenchResult
+static bool GpuJobStart(const BenchConfig& cfg) {
+    g_benchConfig = cfg;
+    g_benchOps = 0;
+    g_benchDone = false;
+    g_benchCancel = false;
+    g_benchStartNs = 0;
+    g_gpuMeasuredSec = 0.0;
+    g_gpuStats = BenchRateStats();
+    g_gpuSeries.clear();
+    g_benchThread = CreateThread(NULL, 0, BenchmarkGPUThread, NULL, 0, NULL);
+    return g_benchThread != NULL;
+}
+
+static bool GpuJobIsDone() {
+    return g_benchDone.load();
+}
+
+static BenchResult GpuJobResult() {
     if (g_benchThread) {
-        WaitForSingleObject(g_benchThread, 2000);
+        WaitForSingleObject(g_benchThread, INFINITE);
         CloseHandle(g_benchThread);
         g_benchThread = NULL;
     }
-    // Clean up any multicore worker handles that coordinator didn't close
-    for (int i = 0; i < g_benchThreadCount; i++) {
-        if (g_benchThreads[i]) {
-            WaitForSingleObject(g_benchThreads[i], 500);
-            CloseHandle(g_benchThreads[i]);
-            g_benchThreads[i] = NULL;
-        }
+    BenchResult r;
+    r.completed = true;
+    r.threadCount = 1;
+    r.totalOps = g_benchOps;
+    r.elapsedSec = g_gpuMeasuredSec;
+    if (g_gpuMeasuredSec > 0.0) r.score = (double)g_benchOps / g_gpuMeasuredSec;
+    {
+        std::lock_guard<std::mutex> lock(g_gpuStatsLock);
+        r.stats = g_gpuStats;
+    }
+    r.adaptive = g_benchConfig.adaptive;
+    r.converged = g_benchConfig.adaptive && g_gpuMeasuredSec * 1000.0 < g_benchConfig.maxDurationMs;
+    r.series.intervalMs = g_benchConfig.sampleIntervalMs;
+    r.series.warmupSamples = g_benchConfig.warmupMs / g_benchConfig.sampleIntervalMs;
+    r.series.total = g_gpuSeries;
+    r.throttle = BenchAnalyzeThrottling(r.series.total.data(), (int)r.series.total.size(), r.series.warmupSamples);
+    return r;
+}
+
+static int64_t GpuJobCancel() {
+    int64_t t0 = BenchNowNs();
+    g_benchCancel = true;
+    if (g_benchThread && WaitForSingleObject(g_benchThread, BENCH_CANCEL_BOUND_MS) == WAIT_OBJECT_0) {
+        CloseHandle(g_benchThread);
+        g_benchThread = NULL;
+    }
+    return BenchNowNs() - t0;
+}
+
+// Cancel a running benchmark and return to benchmark menu. Waits at most
+// BENCH_CANCEL_BOUND_MS; a hosted run's child is killed after that, an
+// in-process GPU thread stuck in the driver keeps its handle and cancel flag
+// and is reaped by the next StartBenchmark.
+static void CancelBenchmark() {
+    if (g_benchHosted) {
+        g_lastCancelNs = BenchHostCancel();
+        g_benchHosted = false;
+    } else if (g_benchProcRun) {
+        g_lastCancelNs = BenchProcCancel();
+        g_benchProcRun = false;
+    } else if (g_state == STATE_BENCHMARK_GPU) {
+        g_lastCancelNs = GpuJobCancel();
+    } else {
+        g_lastCancelNs = BenchCancel();
     }
     g_benchThreadCount = 0;
-    g_benchCancel = false;
-    g_benchDone = false;
-    g_benchOps = 0;
     g_state = STATE_BENCHMARK_MENU;
     InvalidateRect(g_hwnd, NULL, FALSE);
 }
@@ -1250,7 +1751,7 @@ static void OnPaint(HWND hwnd) {
                 int ey = y + 220;
 
                 // Register as clickable
-                if (g_buttonCount < 16) {
+                if (g_buttonCount < MAX_BUTTONS) {
                     g_buttons[g_buttonCount].rect = { ex, ey, ex + emailSize.cx, ey + emailSize.cy };
                     g_buttons[g_buttonCount].id = BTN_EMAIL;
                     strncpy(g_buttons[g_buttonCount].text, email, 63);
@@ -1269,7 +1770,7 @@ static void OnPaint(HWND hwnd) {
                 int iconY = ey;
                 RECT copyRect = { iconX, iconY, iconX + iconSize, iconY + iconSize };
 
-                if (g_buttonCount < 16) {
+                if (g_buttonCount < MAX_BUTTONS) {
                     g_buttons[g_buttonCount].rect = copyRect;
                     g_buttons[g_buttonCount].id = BTN_COPY_EMAIL;
                     strncpy(g_buttons[g_buttonCount].text, "copy", 63);
@@ -1310,14 +1811,71 @@ static void OnPaint(HWND hwnd) {
         {
             DrawCenteredText(memDC, "Benchmark", ch / 5 - 100, titleFont, COLOR_ACCENT);
 
-            int btnW = 280, btnH = 56, gap = 20;
+            // One button per kernel on the page (plus the page button when the
+            // registry needs more than one) and mode, placement and back between the title
+            // and the error / notes lines at the bottom; shrink them to fit short
+            // windows, and split them into two columns when even the smallest
+            // buttons don't fit in one
+            int menuKernels[BENCH_MENU_KERNELS];
+            int kernels = MenuKernels(menuKernels);
+            int pages = MenuPageCount();
+            int extra = pages > 1 ? 1 : 0;
+            int rows = kernels + extra + 3;
+            int btnW = 280, btnH = 56, gap = rows > 7 ? 8 : 14, cols = 1;
             int startY = ch / 3 + 20 - 100;
-            DrawButton(memDC, centerX, startY, btnW, btnH, "CPU", BTN_BENCH_CPU, btnFont);
-            DrawButton(memDC, centerX, startY + btnH + gap, btnW, btnH, "CPU MULTICORE", BTN_BENCH_MULTICORE, btnFont);
-            DrawButton(memDC, centerX, startY + 2 * (btnH + gap), btnW, btnH, "GPU", BTN_BENCH_GPU, btnFont);
-            DrawButton(memDC, centerX, startY + 3 * (btnH + gap), btnW, btnH, "BACK", BTN_BACK, btnFont);
-
-            DrawCenteredText(memDC, "Each benchmark runs for 10 seconds", ch - 60, smallFont, RGB(120, 120, 130));
+            int space = ch - 105 - startY;
+            if (rows * BENCH_MENU_MIN_BTN_H + (rows - 1) * gap > space) {
+                cols = 2;
+                rows = (rows + 1) / 2;
+            }
+            int fitH = (space - (rows - 1) * gap) / rows;
+            if (fitH < btnH) btnH = fitH > BENCH_MENU_MIN_BTN_H ? fitH : BENCH_MENU_MIN_BTN_H;
+            // Column-major: kernels first, then page, mode, placement and back
+            auto slotX = [&](int i) { return cols == 1 ? centerX : centerX + (i / rows * 2 - 1) * (btnW + gap) / 2; };
+            auto slotY = [&](int i) { return startY + i % rows * (btnH + gap); };
+            for (int i = 0; i < kernels; i++) {
+                const BenchKernel& k = BenchKernels()[menuKernels[i]];
+                char kernelBuf[64];
+                snprintf(kernelBuf, sizeof(kernelBuf), "%s%s", k.label.c_str(),
+                    k.threadModel == BENCH_KERNEL_SWEEP && g_benchConfig.scalingMode == BENCH_SCALING_EVERY ? " (EVERY)" : "");
+                DrawButton(memDC, slotX(i), slotY(i), btnW, btnH, kernelBuf, BTN_BENCH_KERNEL + menuKernels[i], btnFont);
+            }
+            if (pages > 1) {
+                char pageBuf[64];
+                snprintf(pageBuf, sizeof(pageBuf), "KERNELS: PAGE %d/%d", g_benchMenuPage + 1, pages);
+                DrawButton(memDC, slotX(kernels), slotY(kernels), btnW, btnH, pageBuf, BTN_BENCH_PAGE, btnFont);
+            }
+            char modeBuf[64];
+            if (g_benchConfig.adaptive)
+                snprintf(modeBuf, sizeof(modeBuf), "MODE: +-%.1f%%", g_benchConfig.targetPrecision * 100.0);
+            else
+                snprintf(modeBuf, sizeof(modeBuf), "MODE: %d SECONDS", g_benchConfig.durationMs / 1000);
+            DrawButton(memDC, slotX(kernels + extra), slotY(kernels + extra), btnW, btnH, modeBuf, BTN_BENCH_MODE, btnFont);
+            static const char* placementLabels[] = {
+                "CORES: FLOATING", "CORES: PINNED", "SMT: PER CORE", "SMT: ALL LOGICAL", "SMT: PAIRS",
+                "CORES: PROCESSES"
+            };
+            DrawButton(memDC, slotX(kernels + extra + 1), slotY(kernels + extra + 1), btnW, btnH,
+                placementLabels[GetBenchPlacement()], BTN_BENCH_PLACEMENT, btnFont);
+            DrawButton(memDC, slotX(kernels + extra + 2), slotY(kernels + extra + 2), btnW, btnH, "BACK", BTN_BACK, btnFont);
+
+            char durationBuf[128];
+            if (g_benchConfig.adaptive)
+                snprintf(durationBuf, sizeof(durationBuf), "Adaptive: runs %d-%d s until the score is within +-%.1f%% (95%% confidence)",
+                    g_benchConfig.minDurationMs / 1000, g_benchConfig.maxDurationMs / 1000, g_benchConfig.targetPrecision * 100.0);
+            else
+                snprintf(durationBuf, sizeof(durationBuf), "Each benchmark warms up for %.1f s, then measures for %d seconds",
+                    g_benchConfig.warmupMs / 1000.0, g_benchConfig.durationMs / 1000);
+            DrawCenteredText(memDC, durationBuf, ch - 60, smallFont, RGB(120, 120, 130));
+
+            if (g_lastBenchError[0]) {
+                DrawCenteredText(memDC, g_lastBenchError, ch - 95, smallFont, COLOR_ACCENT);
+            } else if (g_lastCancelNs >= 0) {
+                char cancelBuf[96];
+                snprintf(cancelBuf, sizeof(cancelBuf), "Cancelled in %.2f ms (bound %d ms)%s",
+                    g_lastCancelNs / 1000000.0, BENCH_CANCEL_BOUND_MS, g_benchThread ? ", GPU still finishing" : "");
+                DrawCenteredText(memDC, cancelBuf, ch - 95, smallFont, RGB(120, 120, 130));
+            }
         }
         break;
 
@@ -1325,14 +1883,15 @@ static void OnPaint(HWND hwnd) {
         case STATE_BENCHMARK_GPU:
         case STATE_BENCHMARK_MULTICORE:
         {
-            const char* title = "Testing CPU...";
-            if (g_state == STATE_BENCHMARK_GPU) title = "Testing GPU...";
-            else if (g_state == STATE_BENCHMARK_MULTICORE) title = "Testing CPU (all cores)...";
+            const BenchKernel& kernel = BenchKernels()[g_lastBenchKernel];
+            char title[96];
+            snprintf(title, sizeof(title), kernel.threadModel == BENCH_KERNEL_MULTI ? "Testing %s (all cores)..." : "Testing %s...",
+                kernel.label.c_str());
             DrawCenteredText(memDC, title, ch / 4, titleFont, COLOR_ACCENT);
 
-            // Progress bar
-            DWORD elapsed = GetTickCount() - g_benchStartTick;
-            float progress = (float)elapsed / (float)BENCH_DURATION_MS;
+            // Progress bar (warm-up + measurement window)
+            BenchProgress prog = GetBenchProgress();
+            float progress = prog.totalNs > 0 ? (float)((double)prog.elapsedNs / (double)prog.totalNs) : 0.0f;
             if (progress > 1.0f) progress = 1.0f;
             int barW = 400, barH = 30;
             int barX = centerX - barW / 2;
@@ -1380,19 +1939,27 @@ static void OnPaint(HWND hwnd) {
                 }
             }
 
-            // Stats
+            // Stats: warm-up is shown separately, seconds count the measurement window only
             char statsBuf[128];
-            DWORD secs = elapsed / 1000;
-            snprintf(statsBuf, sizeof(statsBuf), "%d / %d seconds", secs > 10 ? 10 : secs, BENCH_DURATION_MS / 1000);
+            int durationSecs = (g_benchConfig.adaptive ? g_benchConfig.maxDurationMs : g_benchConfig.durationMs) / 1000;
+            if (prog.phase == BENCH_PHASE_STARTING) {
+                snprintf(statsBuf, sizeof(statsBuf), "Starting...");
+            } else if (prog.phase == BENCH_PHASE_WARMUP) {
+                snprintf(statsBuf, sizeof(statsBuf), "Warming up...");
+            } else {
+                // Seconds into the current phase; SMT modes and sweeps run several
+                int64_t phaseNs = prog.totalNs / (prog.runPhaseCount > 0 ? prog.runPhaseCount : 1);
+                int secs = (int)(((prog.elapsedNs - phaseNs * prog.runPhase) / 1000000 - g_benchConfig.warmupMs) / 1000);
+                if (secs < 0) secs = 0;
+                if (g_benchConfig.adaptive)
+                    snprintf(statsBuf, sizeof(statsBuf), "%d seconds (max %d)", secs > durationSecs ? durationSecs : secs, durationSecs);
+                else
+                    snprintf(statsBuf, sizeof(statsBuf), "%d / %d seconds", secs > durationSecs ? durationSecs : secs, durationSecs);
+            }
             DrawCenteredText(memDC, statsBuf, ch / 2 + 80, mediumFont, COLOR_WHITE);
 
-            // Show live ops count (for multicore, sum all thread counters)
-            LONGLONG ops = g_benchOps;
-            if (g_state == STATE_BENCHMARK_MULTICORE) {
-                ops = 0;
-                for (int i = 0; i < g_benchThreadCount; i++)
-                    ops += g_threadOps[i].ops;
-            }
+            // Show live ops count (multicore counters are summed by the bench core)
+            LONGLONG ops = prog.ops;
             char opsBuf[128];
             if (ops > 1000000) {
                 snprintf(opsBuf, sizeof(opsBuf), "%.1f M operations", (double)ops / 1000000.0);
@@ -1401,11 +1968,43 @@ static void OnPaint(HWND hwnd) {
             }
             DrawCenteredText(memDC, opsBuf, ch / 2 + 120, smallFont, RGB(180, 180, 190));
 
-            // Show core count for multicore
+            // Running precision (adaptive mode stops on it) and core count for multicore
+            int infoY = ch / 2 + 155;
+            if (g_benchConfig.adaptive && prog.phase == BENCH_PHASE_MEASURE) {
+                char precBuf[96];
+                if (prog.stats.precision > 0.0)
+                    snprintf(precBuf, sizeof(precBuf), "Precision +-%.2f%% (target +-%.2f%%)",
+                        prog.stats.precision * 100.0, g_benchConfig.targetPrecision * 100.0);
+                else
+                    snprintf(precBuf, sizeof(precBuf), "Precision: measuring...");
+                DrawCenteredText(memDC, precBuf, infoY, smallFont, RGB(150, 150, 160));
+                infoY += 35;
+            }
             if (g_state == STATE_BENCHMARK_MULTICORE) {
                 char coresBuf[64];
-                snprintf(coresBuf, sizeof(coresBuf), "%d threads", g_benchThreadCount);
-                DrawCenteredText(memDC, coresBuf, ch / 2 + 155, smallFont, RGB(150, 150, 160));
+                BenchTopology topo = BenchGetTopology();
+                int groups = (int)topo.groupSizes.size();
+                if (kernel.threadModel == BENCH_KERNEL_SWEEP) {
+                    std::vector<int> steps = BenchScalingSteps(g_benchConfig.scalingMode == BENCH_SCALING_EVERY ?
+                        BENCH_SCALING_EVERY : BENCH_SCALING_POW2, g_benchThreadCount);
+                    int step = prog.runPhase < (int)steps.size() ? prog.runPhase : (int)steps.size() - 1;
+                    snprintf(coresBuf, sizeof(coresBuf), "Step %d of %d: %d of %d threads", step + 1, (int)steps.size(),
+                        steps[step], g_benchThreadCount);
+                } else if (g_benchProcesses && prog.runPhaseCount > 1)
+                    snprintf(coresBuf, sizeof(coresBuf), "Phase %d of 2: %d %s", prog.runPhase + 1, g_benchThreadCount,
+                        prog.runPhase == 0 ? "threads in one process" : "worker processes");
+                else if (g_benchConfig.smtMode != BENCH_SMT_OFF && prog.runPhaseCount > 1)
+                    snprintf(coresBuf, sizeof(coresBuf), "Phase %d of %d: %s", prog.runPhase + 1, prog.runPhaseCount,
+                        prog.runPhase == 0 ? "one thread per core" : "every logical CPU");
+                else if (g_benchConfig.smtMode != BENCH_SMT_OFF)
+                    snprintf(coresBuf, sizeof(coresBuf), "One pinned thread per core (no SMT siblings)");
+                else if (groups > 1)
+                    snprintf(coresBuf, sizeof(coresBuf), "%d threads in %d processor groups", g_benchThreadCount, groups);
+                else if (topo.effectiveCount < topo.logicalCount)
+                    snprintf(coresBuf, sizeof(coresBuf), "%d threads (%d of %d CPUs usable)", g_benchThreadCount, topo.effectiveCount, topo.logicalCount);
+                else
+                    snprintf(coresBuf, sizeof(coresBuf), "%d threads", g_benchThreadCount);
+                DrawCenteredText(memDC, coresBuf, infoY, smallFont, RGB(150, 150, 160));
             }
 
             // Hint
@@ -1415,21 +2014,116 @@ static void OnPaint(HWND hwnd) {
 
         case STATE_BENCHMARK_RESULT:
         {
-            const char* label = "CPU";
-            if (g_lastBenchType == 1) label = "GPU";
-            else if (g_lastBenchType == 2) label = "CPU Multicore";
+            const BenchKernel& kernel = BenchKernels()[g_lastBenchKernel];
+            const char* label = kernel.label.c_str();
+            // Every rate on the page in the kernel's unit, scaled like the score
+            BenchRateUnit rate = BenchRateUnitFor(g_lastBenchScore * 1e6, kernel.unit);
 
-            DrawCenteredText(memDC, "Benchmark Result", ch / 4, titleFont, COLOR_ACCENT);
+            int resultY = ch / 6 - 30;
+            DrawCenteredText(memDC, "Benchmark Result", resultY, titleFont, COLOR_ACCENT);
 
             char scoreBuf[128];
-            if (g_lastBenchScore >= 1.0) {
-                snprintf(scoreBuf, sizeof(scoreBuf), "%s:  %.2f Mops/s", label, g_lastBenchScore);
-            } else {
-                snprintf(scoreBuf, sizeof(scoreBuf), "%s:  %.2f Kops/s", label, g_lastBenchScore * 1000.0);
+            snprintf(scoreBuf, sizeof(scoreBuf), "%s:  %.2f %s", label, g_lastBenchScore * 1e6 / rate.scale, rate.label);
+            DrawCenteredText(memDC, scoreBuf, resultY + 80, mediumFont, COLOR_WHITE);
+
+            // Achieved precision of the score
+            char precBuf[128];
+            if (g_lastBenchPrecision > 0.0)
+                snprintf(precBuf, sizeof(precBuf), "+-%.2f%% at 95%% confidence, %.1f s measured%s", g_lastBenchPrecision * 100.0,
+                    g_lastBenchSeconds, g_benchConfig.adaptive ? (g_lastBenchConverged ? " (adaptive)" : " (adaptive, hit max)") : "");
+            else
+                snprintf(precBuf, sizeof(precBuf), "%.1f s measured, too short to estimate precision", g_lastBenchSeconds);
+            DrawCenteredText(memDC, precBuf, resultY + 120, smallFont, RGB(150, 150, 160));
+
+            // Throttling summary and throughput chart
+            if (g_lastBenchSeries.total.size() >= 2) {
+                char throttleBuf[160];
+                const BenchThrottleSummary& t = g_lastBenchThrottle;
+                if (t.throttled && t.onsetSample >= 0) {
+                    snprintf(throttleBuf, sizeof(throttleBuf), "THROTTLING: %.1f%% below peak from %.1f s (peak %.2f, sustained %.2f %s)",
+                        t.dropPct, t.onsetSample * g_lastBenchSeries.intervalMs / 1000.0, t.peak / rate.scale, t.sustained / rate.scale,
+                        rate.label);
+                } else {
+                    snprintf(throttleBuf, sizeof(throttleBuf), "Peak %.2f  Sustained %.2f %s  Drop %.1f%%",
+                        t.peak / rate.scale, t.sustained / rate.scale, rate.label, t.dropPct);
+                }
+                DrawCenteredText(memDC, throttleBuf, resultY + 150, smallFont, t.throttled ? COLOR_ACCENT : RGB(150, 150, 160));
+            }
+            if (g_lastBenchCpus[0]) {
+                DrawCenteredText(memDC, g_lastBenchCpus, resultY + 180, smallFont, RGB(150, 150, 160));
+            }
+            int areaTop = resultY + 215, areaBottom = ch - 100;
+            if (g_lastBenchSmt.mode != BENCH_SMT_OFF) {
+                char smtBuf[160];
+                snprintf(smtBuf, sizeof(smtBuf), "One thread per core %.2f   All logical CPUs %.2f %s   SMT yield %.2fx",
+                    g_lastBenchSmt.physicalScore / rate.scale, g_lastBenchSmt.logicalScore / rate.scale, rate.label, g_lastBenchSmt.yield);
+                DrawCenteredText(memDC, smtBuf, resultY + 205, smallFont, COLOR_WHITE);
+                areaTop += 25;
+            }
+            if (g_lastBenchScaling.points.size() >= 2) {
+                const BenchScalingFit& fit = g_lastBenchScaling.fit;
+                char fitBuf[192];
+                int len = snprintf(fitBuf, sizeof(fitBuf), "Knee at %d threads   Serial fraction %.1f%%   USL sigma %.3f kappa %.4f",
+                    fit.kneeThreads, fit.serialFraction * 100.0, fit.sigma, fit.kappa);
+                if (fit.peakThreads > 0.0)
+                    snprintf(fitBuf + len, sizeof(fitBuf) - len, " (peak at %.0f)", fit.peakThreads);
+                DrawCenteredText(memDC, fitBuf, resultY + 205, smallFont, COLOR_WHITE);
+                areaTop += 25;
+            }
+            // Per-thread spread: a bar per worker, stragglers named (by CPU when pinned)
+            if (g_lastBenchThreadRates.size() >= 2) {
+                const BenchThreadSpread& sp = g_lastBenchSpread;
+                char spreadBuf[256];
+                int len = snprintf(spreadBuf, sizeof(spreadBuf), "Per thread %.2f / %.2f / %.2f %s (min/median/max)   CV %.1f%%",
+                    sp.min / rate.scale, sp.median / rate.scale, sp.max / rate.scale, rate.label, sp.cv * 100.0);
+                for (size_t i = 0; i < sp.stragglers.size() && i < 4 && len < (int)sizeof(spreadBuf); i++) {
+                    const BenchStraggler& st = sp.stragglers[i];
+                    if (!g_lastBenchCores.empty())
+                        len += snprintf(spreadBuf + len, sizeof(spreadBuf) - len, "%s CPU %d -%.0f%%",
+                            i ? "," : "   Slow:", g_lastBenchCores[st.thread].placement.cpu, st.deficitPct);
+                    else
+                        len += snprintf(spreadBuf + len, sizeof(spreadBuf) - len, "%s thread %d -%.0f%%",
+                            i ? "," : "   Slow:", st.thread, st.deficitPct);
+                }
+                if (sp.stragglers.size() > 4 && len < (int)sizeof(spreadBuf))
+                    snprintf(spreadBuf + len, sizeof(spreadBuf) - len, " +%d more", (int)sp.stragglers.size() - 4);
+                DrawCenteredText(memDC, spreadBuf, areaTop, smallFont, sp.stragglers.empty() ? RGB(150, 150, 160) : COLOR_ACCENT);
+                int stripW = cw - 80 < 600 ? cw - 80 : 600;
+                RECT stripRect = { centerX - stripW / 2, areaTop + 24, centerX + stripW / 2, areaTop + 38 };
+                DrawThreadStrip(memDC, stripRect, g_lastBenchThreadRates, sp);
+                areaTop += 50;
+            }
+            // Pinned runs split the space below between the chart and the per-core grid
+            int chartW = cw - 80 < 600 ? cw - 80 : 600;
+            int chartBottom = g_lastBenchCores.empty() ? areaBottom : areaTop + (areaBottom - areaTop) * 2 / 5;
+            // Sweeps chart the curve instead of the last step's time series
+            if (g_lastBenchScaling.points.size() >= 2) {
+                RECT chartRect = { centerX - chartW / 2, areaTop, centerX + chartW / 2, chartBottom };
+                if (chartRect.bottom - chartRect.top >= 60) {
+                    DrawScalingChart(memDC, chartRect, g_lastBenchScaling, smallFont);
+                }
+            } else if (g_lastBenchSeries.total.size() >= 2) {
+                RECT chartRect = { centerX - chartW / 2, areaTop, centerX + chartW / 2, chartBottom };
+                if (chartRect.bottom - chartRect.top >= 60) {
+                    DrawRateChart(memDC, chartRect, g_lastBenchSeries, g_lastBenchThrottle, rate, smallFont);
+                }
+            }
+            if (!g_lastBenchCores.empty()) {
+                int classCount = BenchGetTopology().classCount;
+                char classBuf[256] = "";
+                int len = 0;
+                for (const BenchClassScore& c : g_lastBenchClasses) {
+                    const char* name = BenchClassLabel(c.efficiencyClass, classCount);
+                    len += snprintf(classBuf + len, sizeof(classBuf) - len, "%s%s%s%d cores %.2f %s (%.2f each)",
+                        len ? "   " : "", name, name[0] ? ": " : "", c.threads, c.score / rate.scale, rate.label, c.perThread / rate.scale);
+                    if (len >= (int)sizeof(classBuf)) break;
+                }
+                DrawCenteredText(memDC, classBuf, chartBottom + 20, smallFont, RGB(150, 150, 160));
+                RECT gridRect = { centerX - chartW / 2, chartBottom + 40, centerX + chartW / 2, areaBottom };
+                DrawBarGrid(memDC, gridRect, BuildCoreCells(classCount, rate), smallFont);
             }
-            DrawCenteredText(memDC, scoreBuf, ch / 2 - 20, mediumFont, COLOR_WHITE);
 
-            DrawButton(memDC, centerX, ch / 2 + 60, 200, 56, "BACK", BTN_BACK, btnFont);
+            DrawButton(memDC, centerX, ch - 86, 200, 56, "BACK", BTN_BACK, btnFont);
 
             // Draw benchmark history (top-left, ~35% opacity like version text)
             if (g_benchHistoryCount > 0) {
@@ -1446,10 +2140,17 @@ static void OnPaint(HWND hwnd) {
                 int maxW = 0;
                 char histLines[20][64];
                 for (int i = 0; i < g_benchHistoryCount; i++) {
-                    if (g_benchHistory[i].score >= 1.0)
-                        snprintf(histLines[i], 64, "%s  %.2f Mops/s", g_benchHistory[i].date, g_benchHistory[i].score);
-                    else
-                        snprintf(histLines[i], 64, "%s  %.2f Kops/s", g_benchHistory[i].date, g_benchHistory[i].score * 1000.0);
+                    char histPrec[32] = "";
+                    if (g_benchHistory[i].precision > 0.0)
+                        snprintf(histPrec, sizeof(histPrec), "  +-%.1f%%%s", g_benchHistory[i].precision * 100.0,
+                            g_benchHistory[i].throttled ? "  T" : "");
+                    if (g_benchHistory[i].knee > 0) {
+                        size_t len = strlen(histPrec);
+                        snprintf(histPrec + len, sizeof(histPrec) - len, "  knee %d", g_benchHistory[i].knee);
+                    }
+                    BenchRateUnit histRate = BenchRateUnitFor(g_benchHistory[i].score * 1e6, kernel.unit);
+                    snprintf(histLines[i], 64, "%s  %.2f %s%s", g_benchHistory[i].date, g_benchHistory[i].score * 1e6 / histRate.scale,
+                        histRate.label, histPrec);
                     SIZE s;
                     GetTextExtentPoint32A(memDC, histLines[i], (int)strlen(histLines[i]), &s);
                     if (s.cx > maxW) maxW = s.cx;
@@ -1674,14 +2375,22 @@ static void OnButtonClick(int id) {
             g_selectedButton = -1;
             InvalidateRect(g_hwnd, NULL, FALSE);
             break;
-        case BTN_BENCH_CPU:
-            StartBenchmarkType(0);
+        case BTN_BENCH_MODE:
+            g_benchConfig.adaptive = !g_benchConfig.adaptive;
+            g_selectedButton = BTN_BENCH_MODE;  // keep keyboard/gamepad focus on the toggle
+            SaveKeybinds();
+            InvalidateRect(g_hwnd, NULL, FALSE);
             break;
-        case BTN_BENCH_GPU:
-            StartBenchmarkType(1);
+        case BTN_BENCH_PAGE:
+            g_benchMenuPage = (g_benchMenuPage + 1) % MenuPageCount();
+            g_selectedButton = BTN_BENCH_PAGE;
+            InvalidateRect(g_hwnd, NULL, FALSE);
             break;
-        case BTN_BENCH_MULTICORE:
-            StartBenchmarkType(2);
+        case BTN_BENCH_PLACEMENT:
+            SetBenchPlacement((GetBenchPlacement() + 1) % 6);
+            g_selectedButton = BTN_BENCH_PLACEMENT;
+            SaveKeybinds();
+            InvalidateRect(g_hwnd, NULL, FALSE);
             break;
         case BTN_BACK:
             if (g_state == STATE_KEYBINDS || g_state == STATE_ABOUT) {
@@ -1721,6 +2430,9 @@ static void OnButtonClick(int id) {
                 CloseClipboard();
             }
             break;
+        default:
+            if (id >= BTN_BENCH_KERNEL && IsMenuKernel(id - BTN_BENCH_KERNEL)) StartBenchmark(id - BTN_BENCH_KERNEL);
+            break;
     }
 }
 
@@ -1936,7 +2648,28 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     (void)hPrevInstance;
-    (void)lpCmdLine;
+
+    // The GPU test runs its own job; plugins load before any child dispatch so
+    // a host or worker process sees the same registry as this one
+    static const BenchKernelInfo gpuKernel = { BENCH_KERNEL_ABI_VERSION, "gpu", "GPU", "ops", 1.0, BENCH_KERNEL_EXTERNAL, NULL };
+    BenchRegisterKernel(gpuKernel, NULL, NULL);
+    BenchLoadPlugins();
+
+    // Benchmark host child: run the job named in the shared segment, no window
+    if (strncmp(lpCmdLine, BENCH_HOST_ARG " ", sizeof(BENCH_HOST_ARG)) == 0) {
+        BenchHostJob jobs[3];
+        jobs[BENCH_HOST_JOB_CPU] = BenchHostCpuJob();
+        jobs[BENCH_HOST_JOB_PROCESSES] = BenchHostProcessJob();
+        jobs[BENCH_HOST_JOB_GPU] = { GpuJobStart, GpuJobIsDone, GpuProgress, GpuJobResult, GpuJobCancel, NULL };
+        return BenchHostMain(lpCmdLine + sizeof(BENCH_HOST_ARG), jobs, 3);
+    }
+    // Process-per-core worker: "<segment> <index>"
+    if (strncmp(lpCmdLine, BENCH_PROC_ARG " ", sizeof(BENCH_PROC_ARG)) == 0) {
+        char segment[64];
+        int index = -1;
+        if (sscanf(lpCmdLine + sizeof(BENCH_PROC_ARG), "%63s %d", segment, &index) != 2) return 2;
+        return BenchProcWorkerMain(segment, index);
+    }
 
     // Initialize performance counter
     QueryPerformanceFrequency(&g_perfFreq);
@@ -2028,14 +2761,61 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         // Benchmark progress: continuous repaint + completion check
         if (g_state == STATE_BENCHMARK_CPU || g_state == STATE_BENCHMARK_GPU || g_state == STATE_BENCHMARK_MULTICORE) {
             InvalidateRect(g_hwnd, NULL, FALSE);
-            if (g_benchDone) {
-                double elapsed = (double)BENCH_DURATION_MS / 1000.0;
-                double score = (double)g_benchOps / elapsed / 1000000.0;
-                CloseHandle(g_benchThread);
-                g_benchThread = NULL;
+            bool done = g_benchHosted ? BenchHostIsDone() : g_benchProcRun ? BenchProcIsDone() :
+                (g_state == STATE_BENCHMARK_GPU) ? g_benchDone.load() : BenchIsDone();
+            BenchResult result;
+            if (done) {
+                if (g_benchHosted) result = BenchHostGetResult();
+                else if (g_benchProcRun) result = BenchProcGetResult();
+                else if (g_state == STATE_BENCHMARK_GPU) result = GpuJobResult();
+                else result = BenchGetResult();
+            }
+            bool kernelFailed = !g_benchHosted && !g_benchProcRun && g_state != STATE_BENCHMARK_GPU && BenchRunError()[0];
+            if (done && (g_benchHosted || g_benchProcRun || kernelFailed) && !result.completed) {
+                // A child crashed or was killed, or a kernel gave up; nothing to save
+                snprintf(g_lastBenchError, sizeof(g_lastBenchError), "Benchmark failed: %s",
+                    g_benchHosted ? BenchHostError() : g_benchProcRun ? BenchProcError() : BenchRunError());
+                g_benchHosted = false;
+                g_benchProcRun = false;
+                g_benchThreadCount = 0;
+                g_state = STATE_BENCHMARK_MENU;
+                g_selectedButton = -1;
+                InvalidateRect(g_hwnd, NULL, FALSE);
+            } else if (done) {
+                g_benchHosted = false;
+                g_benchProcRun = false;
+                // Score from the measured window, not the nominal duration
+                double score = result.score / 1000000.0;
+                g_lastBenchPrecision = result.stats.precision;
+                g_lastBenchSeconds = result.elapsedSec;
+                g_lastBenchConverged = result.converged;
+                g_lastBenchSeries = result.series;
+                const BenchKernel& kernel = BenchKernels()[g_lastBenchKernel];
+                if (kernel.threadModel == BENCH_KERNEL_MULTI || kernel.threadModel == BENCH_KERNEL_SWEEP) {
+                    BenchTopology topo = BenchGetTopology();
+                    if (result.processes)
+                        snprintf(g_lastBenchCpus, sizeof(g_lastBenchCpus), "%d processes on %d usable CPUs, threads %.2f M%s/s (processes x%.3f)",
+                            result.threadCount, result.effectiveCount, result.threadedScore / 1e6, kernel.unit.c_str(),
+                            result.threadedScore > 0.0 ? result.score / result.threadedScore : 0.0);
+                    else
+                        snprintf(g_lastBenchCpus, sizeof(g_lastBenchCpus), "%d threads on %d usable of %d logical CPUs, %d cores%s",
+                            result.threadCount, result.effectiveCount, result.logicalCount, topo.coreCount,
+                            topo.cpuQuota > 0.0 ? " (CPU rate capped)" : "");
+                    if (result.pinned) {
+                        g_lastBenchCores = result.threads;
+                        g_lastBenchClasses = result.classes;
+                    }
+                    g_lastBenchSmt = result.smt;
+                    g_lastBenchScaling = result.scaling;
+                    for (const BenchThreadResult& t : result.threads) g_lastBenchThreadRates.push_back(t.opsPerSec);
+                    g_lastBenchSpread = result.spread;
+                }
+                g_lastBenchThrottle = BenchAnalyzeThrottling(g_lastBenchSeries.total.data(), (int)g_lastBenchSeries.total.size(),
+                    g_lastBenchSeries.warmupSamples);
                 g_lastBenchScore = score;
-                SaveBenchResult(g_lastBenchType, score);
-                LoadBenchHistory(g_lastBenchType);
+                SaveBenchResult(kernel.name.c_str(), score, g_lastBenchPrecision, g_lastBenchSeries, g_lastBenchThrottle, g_lastBenchCores, g_lastBenchSmt,
+                    g_lastBenchScaling);
+                LoadBenchHistory(kernel.name.c_str());
                 g_state = STATE_BENCHMARK_RESULT;
                 g_selectedButton = -1;
                 InvalidateRect(g_hwnd, NULL, FALSE);